@@ -842,8 +842,11 @@ static void test_obsolete_flags(void)
 
 static void test_HeapQueryInformation(void)
 {
+    void *ptrs[300];
+    HANDLE heap;
     ULONG info;
     SIZE_T size;
+    UINT i;
     BOOL ret;
 
     pHeapQueryInformation = (void *)GetProcAddress(GetModuleHandleA("kernel32.dll"), "HeapQueryInformation");
@@ -890,6 +893,102 @@ static void test_HeapQueryInformation(void)
                                 &info, sizeof(info) + 1, NULL);
     ok(ret, "HeapQueryInformation error %u\n", GetLastError());
     ok(info == 0 || info == 1 || info == 2, "expected 0, 1 or 2, got %u\n", info);
+
+    heap = HeapCreate(0, 0, 0);
+    ok(heap != NULL, "HeapCreate failed\n");
+    info = 2;
+    ret = HeapSetInformation(heap, HeapCompatibilityInformation, &info, sizeof(info));
+    ok(ret, "HeapSetInformation error %u\n", GetLastError());
+    info = 0xdeadbeef;
+    ret = pHeapQueryInformation(heap, HeapCompatibilityInformation, &info, sizeof(info), NULL);
+    ok(ret, "HeapQueryInformation error %u\n", GetLastError());
+    ok(info == 2, "expected 2, got %u\n", info);
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        ptrs[i] = HeapAlloc(heap, HEAP_ZERO_MEMORY, 1 + i % 100);
+        ok(ptrs[i] != NULL, "HeapAlloc failed\n");
+        ok(!((BYTE *)ptrs[i])[i % 100], "block %u not zeroed\n", i);
+        memset(ptrs[i], 0xcc, 1 + i % 100);
+    }
+    for (i = 0; i < ARRAY_SIZE(ptrs); i += 2) HeapFree(heap, 0, ptrs[i]);
+    for (i = 0; i < ARRAY_SIZE(ptrs); i += 2)
+    {
+        ptrs[i] = HeapAlloc(heap, 0, 1 + i % 100);
+        ok(ptrs[i] != NULL, "HeapAlloc failed\n");
+    }
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        size = HeapSize(heap, 0, ptrs[i]);
+        ok(size == 1 + i % 100, "block %u: got size %lu\n", i, size);
+    }
+    ok(HeapValidate(heap, 0, NULL), "HeapValidate failed\n");
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) HeapFree(heap, 0, ptrs[i]);
+    ok(HeapValidate(heap, 0, NULL), "HeapValidate failed\n");
+    HeapDestroy(heap);
+
+    heap = HeapCreate(HEAP_NO_SERIALIZE, 0, 0);
+    ok(heap != NULL, "HeapCreate failed\n");
+    info = 2;
+    ret = HeapSetInformation(heap, HeapCompatibilityInformation, &info, sizeof(info));
+    ok(!ret, "HeapSetInformation succeeded\n");
+    HeapDestroy(heap);
+}
+
+struct lfh_thread_params
+{
+    HANDLE heap;
+    HANDLE ready;
+};
+
+static DWORD WINAPI lfh_thread( void *arg )
+{
+    struct lfh_thread_params *params = arg;
+    void *ptrs[200];
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) ptrs[i] = HeapAlloc( params->heap, 0, 1 + i % 100 );
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) HeapFree( params->heap, 0, ptrs[i] );
+    SetEvent( params->ready );
+    Sleep( INFINITE );
+    return 0;
+}
+
+/* the blocks cached by a killed thread must not break the heap */
+static void test_lfh_terminate_thread(void)
+{
+    struct lfh_thread_params params;
+    void *ptrs[200];
+    HANDLE thread;
+    ULONG info = 2;
+    UINT i;
+    BOOL ret;
+
+    params.heap = HeapCreate( 0, 0, 0 );
+    ok( params.heap != NULL, "HeapCreate failed\n" );
+    ret = HeapSetInformation( params.heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( ret, "HeapSetInformation failed: %u\n", GetLastError() );
+    params.ready = CreateEventA( NULL, FALSE, FALSE, NULL );
+
+    thread = CreateThread( NULL, 0, lfh_thread, &params, 0, NULL );
+    ok( thread != NULL, "CreateThread failed: %u\n", GetLastError() );
+    ok( !WaitForSingleObject( params.ready, 5000 ), "thread didn't start\n" );
+    ret = TerminateThread( thread, 0 );
+    ok( ret, "TerminateThread failed: %u\n", GetLastError() );
+    ok( !WaitForSingleObject( thread, 5000 ), "thread didn't exit\n" );
+    CloseHandle( thread );
+    CloseHandle( params.ready );
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        ptrs[i] = HeapAlloc( params.heap, 0, 1 + i % 100 );
+        ok( ptrs[i] != NULL, "HeapAlloc failed\n" );
+    }
+    ok( HeapValidate( params.heap, 0, NULL ), "HeapValidate failed\n" );
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) HeapFree( params.heap, 0, ptrs[i] );
+    ok( HeapValidate( params.heap, 0, NULL ), "HeapValidate failed\n" );
+    ret = HeapDestroy( params.heap );
+    ok( ret, "HeapDestroy failed: %u\n", GetLastError() );
 }
 
 static void test_heap_checks( DWORD flags )
@@ -1245,6 +1344,7 @@ START_TEST(heap)
     test_sized_HeapReAlloc((1 << 20), 1);
 
     test_HeapQueryInformation();
+    test_lfh_terminate_thread();
     test_GetPhysicallyInstalledSystemMemory();
 
     if (pRtlGetNtGlobalFlags)
@@ -3809,6 +3809,111 @@ static void test_InMemoryOrderModuleList(void)
     ok(entry2 == mark2, "expected entry2 == mark2, got %p and %p\n", entry2, mark2);
 }
 
+/* the static imports must be loaded as usual when they are prefetched */
+static void test_import_prefetch_child(void)
+{
+    HMODULE module = GetModuleHandleA( NULL );
+    const IMAGE_IMPORT_DESCRIPTOR *imports;
+    ULONG size;
+
+    imports = pRtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_IMPORT, &size );
+    ok( imports != NULL, "no import directory\n" );
+    if (!imports) return;
+
+    for (; imports->Name && imports->FirstThunk; imports++)
+    {
+        const char *name = RVAToAddr( imports->Name, module );
+        ok( GetModuleHandleA( name ) != NULL, "%s not loaded\n", name );
+    }
+}
+
+static void test_import_prefetch(void)
+{
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = { sizeof(si) };
+    char cmdline[MAX_PATH + 32];
+    char **argv;
+
+    if (!pRtlImageDirectoryEntryToData)
+    {
+        win_skip( "RtlImageDirectoryEntryToData not available\n" );
+        return;
+    }
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" loader prefetch", argv[0] );
+    SetEnvironmentVariableA( "WINEPREFETCHDLLS", "1" );
+    ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi ),
+        "CreateProcess failed: %u\n", GetLastError() );
+    SetEnvironmentVariableA( "WINEPREFETCHDLLS", NULL );
+    winetest_wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+}
+
+/* the imports resolved through the import cache must match the exports */
+static void test_import_cache_child(void)
+{
+    HMODULE module = GetModuleHandleA( NULL ), imp_mod;
+    const IMAGE_IMPORT_DESCRIPTOR *imports;
+    const IMAGE_THUNK_DATA *import_list, *thunk_list;
+    const IMAGE_IMPORT_BY_NAME *pe_name;
+    ULONG size;
+
+    imports = pRtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_IMPORT, &size );
+    ok( imports != NULL, "no import directory\n" );
+    if (!imports) return;
+
+    for (; imports->Name && imports->FirstThunk; imports++)
+    {
+        const char *name = RVAToAddr( imports->Name, module );
+
+        if (!imports->u.OriginalFirstThunk) continue;
+        imp_mod = GetModuleHandleA( name );
+        ok( imp_mod != NULL, "%s not loaded\n", name );
+        if (!imp_mod) continue;
+        import_list = RVAToAddr( imports->u.OriginalFirstThunk, module );
+        thunk_list = RVAToAddr( imports->FirstThunk, module );
+        for (; import_list->u1.Ordinal; import_list++, thunk_list++)
+        {
+            if (IMAGE_SNAP_BY_ORDINAL( import_list->u1.Ordinal )) continue;
+            pe_name = RVAToAddr( import_list->u1.AddressOfData, module );
+            ok( (FARPROC)thunk_list->u1.Function == GetProcAddress( imp_mod, (const char *)pe_name->Name ),
+                "%s.%s resolved to %p, expected %p\n", name, pe_name->Name, (void *)thunk_list->u1.Function,
+                GetProcAddress( imp_mod, (const char *)pe_name->Name ) );
+        }
+    }
+}
+
+static void test_import_cache(void)
+{
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = { sizeof(si) };
+    char cmdline[MAX_PATH + 32];
+    char **argv;
+    int i;
+
+    if (!pRtlImageDirectoryEntryToData)
+    {
+        win_skip( "RtlImageDirectoryEntryToData not available\n" );
+        return;
+    }
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" loader import_cache", argv[0] );
+    SetEnvironmentVariableA( "WINEIMPORTCACHE", "1" );
+    /* the first run fills the cache, the second one uses it */
+    for (i = 0; i < 2; i++)
+    {
+        ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi ),
+            "CreateProcess failed: %u\n", GetLastError() );
+        winetest_wait_child_process( pi.hProcess );
+        CloseHandle( pi.hProcess );
+        CloseHandle( pi.hThread );
+    }
+    SetEnvironmentVariableA( "WINEIMPORTCACHE", NULL );
+}
+
 static void test_dll_file( const char *name )
 {
     HMODULE module = GetModuleHandleA( name );
@@ -3913,6 +4018,16 @@ START_TEST(loader)
         *child_failures = -1;
 
     argc = winetest_get_mainargs(&argv);
+    if (argc > 2 && !strcmp( argv[2], "prefetch" ))
+    {
+        test_import_prefetch_child();
+        return;
+    }
+    if (argc > 2 && !strcmp( argv[2], "import_cache" ))
+    {
+        test_import_cache_child();
+        return;
+    }
     if (argc > 4)
     {
         test_dll_phase = atoi(argv[4]);
@@ -3927,6 +4042,8 @@ START_TEST(loader)
     test_import_resolution();
     test_ExitProcess();
     test_InMemoryOrderModuleList();
+    test_import_prefetch();
+    test_import_cache();
     test_dll_file( "ntdll.dll" );
     test_dll_file( "kernel32.dll" );
     test_dll_file( "advapi32.dll" );
@@ -2636,6 +2636,126 @@ static void test_apc_deadlock(void)
     CloseHandle(pi.hProcess);
 }
 
+static void test_fast_sync_child(HANDLE event, HANDLE ready, HANDLE done)
+{
+    HANDLE ev, sem, dup, handles[2];
+    LONG prev;
+    DWORD ret;
+
+    ev = CreateEventA(NULL, TRUE, FALSE, NULL);
+    ok(ev != NULL, "CreateEvent failed with %u\n", GetLastError());
+    ret = WaitForSingleObject(ev, 0);
+    ok(ret == WAIT_TIMEOUT, "expected WAIT_TIMEOUT, got %u\n", ret);
+    ok(SetEvent(ev), "SetEvent failed with %u\n", GetLastError());
+    ret = WaitForSingleObject(ev, 0);
+    ok(ret == WAIT_OBJECT_0, "expected WAIT_OBJECT_0, got %u\n", ret);
+    ret = WaitForSingleObject(ev, 0);
+    ok(ret == WAIT_OBJECT_0, "expected WAIT_OBJECT_0, got %u\n", ret);
+    ok(ResetEvent(ev), "ResetEvent failed with %u\n", GetLastError());
+    ret = WaitForSingleObject(ev, 0);
+    ok(ret == WAIT_TIMEOUT, "expected WAIT_TIMEOUT, got %u\n", ret);
+
+    ok(DuplicateHandle(GetCurrentProcess(), ev, GetCurrentProcess(), &dup, SYNCHRONIZE, FALSE, 0),
+       "DuplicateHandle failed with %u\n", GetLastError());
+    SetLastError(0xdeadbeef);
+    ok(!SetEvent(dup), "SetEvent succeeded\n");
+    ok(GetLastError() == ERROR_ACCESS_DENIED, "expected ERROR_ACCESS_DENIED, got %u\n", GetLastError());
+    CloseHandle(dup);
+    CloseHandle(ev);
+
+    ev = CreateEventA(NULL, FALSE, TRUE, NULL);
+    ok(ev != NULL, "CreateEvent failed with %u\n", GetLastError());
+    ret = WaitForSingleObject(ev, 0);
+    ok(ret == WAIT_OBJECT_0, "expected WAIT_OBJECT_0, got %u\n", ret);
+    ret = WaitForSingleObject(ev, 0);
+    ok(ret == WAIT_TIMEOUT, "expected WAIT_TIMEOUT, got %u\n", ret);
+
+    sem = CreateSemaphoreA(NULL, 1, 2, NULL);
+    ok(sem != NULL, "CreateSemaphore failed with %u\n", GetLastError());
+    ok(ReleaseSemaphore(sem, 1, &prev), "ReleaseSemaphore failed with %u\n", GetLastError());
+    ok(prev == 1, "expected 1, got %d\n", prev);
+    SetLastError(0xdeadbeef);
+    ok(!ReleaseSemaphore(sem, 1, NULL), "ReleaseSemaphore succeeded\n");
+    ok(GetLastError() == ERROR_TOO_MANY_POSTS, "expected ERROR_TOO_MANY_POSTS, got %u\n", GetLastError());
+
+    handles[0] = ev;
+    handles[1] = sem;
+    ret = WaitForMultipleObjects(2, handles, FALSE, 0);
+    ok(ret == WAIT_OBJECT_0 + 1, "expected WAIT_OBJECT_0 + 1, got %u\n", ret);
+    ret = WaitForSingleObject(sem, 0);
+    ok(ret == WAIT_OBJECT_0, "expected WAIT_OBJECT_0, got %u\n", ret);
+    ret = WaitForMultipleObjects(2, handles, FALSE, 0);
+    ok(ret == WAIT_TIMEOUT, "expected WAIT_TIMEOUT, got %u\n", ret);
+    CloseHandle(sem);
+    CloseHandle(ev);
+
+    /* use the inherited event, then let the parent close it behind our back */
+    ok(SetEvent(event), "SetEvent failed with %u\n", GetLastError());
+    ok(ResetEvent(event), "ResetEvent failed with %u\n", GetLastError());
+    ret = WaitForSingleObject(event, 0);
+    ok(ret == WAIT_TIMEOUT, "expected WAIT_TIMEOUT, got %u\n", ret);
+
+    SetEvent(ready);
+    ret = WaitForSingleObject(done, 10000);
+    ok(ret == WAIT_OBJECT_0, "expected WAIT_OBJECT_0, got %u\n", ret);
+
+    /* the slot of the destroyed event may be used by another object now */
+    SetLastError(0xdeadbeef);
+    ok(!SetEvent(event), "SetEvent succeeded\n");
+    ok(GetLastError() == ERROR_INVALID_HANDLE, "expected ERROR_INVALID_HANDLE, got %u\n", GetLastError());
+    SetLastError(0xdeadbeef);
+    ret = WaitForSingleObject(event, 0);
+    ok(ret == WAIT_FAILED, "expected WAIT_FAILED, got %u\n", ret);
+    ok(GetLastError() == ERROR_INVALID_HANDLE, "expected ERROR_INVALID_HANDLE, got %u\n", GetLastError());
+    SetEvent(ready);
+}
+
+static void test_fast_sync(void)
+{
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), NULL, TRUE };
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    HANDLE event, ready, done, other;
+    char cmdline[MAX_PATH];
+    DWORD ret;
+    char **argv;
+
+    event = CreateEventA(&sa, TRUE, FALSE, NULL);
+    ready = CreateEventA(&sa, FALSE, FALSE, NULL);
+    done = CreateEventA(&sa, FALSE, FALSE, NULL);
+    ok(event && ready && done, "CreateEvent failed with %u\n", GetLastError());
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" sync fast_sync %p %p %p", argv[0], event, ready, done);
+    SetEnvironmentVariableA("WINEFASTSYNC", "1");
+    ok(CreateProcessA(argv[0], cmdline, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi),
+       "CreateProcess failed with %u\n", GetLastError());
+    SetEnvironmentVariableA("WINEFASTSYNC", NULL);
+
+    ret = WaitForSingleObject(ready, 10000);
+    ok(ret == WAIT_OBJECT_0, "expected WAIT_OBJECT_0, got %u\n", ret);
+
+    /* destroy the event and create another one, which is likely to get its slot */
+    ok(DuplicateHandle(pi.hProcess, event, NULL, NULL, 0, FALSE, DUPLICATE_CLOSE_SOURCE),
+       "DuplicateHandle failed with %u\n", GetLastError());
+    CloseHandle(event);
+    other = CreateEventA(NULL, TRUE, FALSE, NULL);
+    ok(other != NULL, "CreateEvent failed with %u\n", GetLastError());
+    SetEvent(done);
+
+    ret = WaitForSingleObject(ready, 10000);
+    ok(ret == WAIT_OBJECT_0, "expected WAIT_OBJECT_0, got %u\n", ret);
+    ret = WaitForSingleObject(other, 0);
+    ok(ret == WAIT_TIMEOUT, "expected WAIT_TIMEOUT, got %u\n", ret);
+
+    winetest_wait_child_process(pi.hProcess);
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    CloseHandle(other);
+    CloseHandle(ready);
+    CloseHandle(done);
+}
+
 START_TEST(sync)
 {
     char **argv;
@@ -2673,6 +2793,15 @@ START_TEST(sync)
         {
             for (;;) SleepEx(INFINITE, TRUE);
         }
+        if (!strcmp(argv[2], "fast_sync") && argc >= 6)
+        {
+            HANDLE event, ready, done;
+
+            sscanf(argv[3], "%p", &event);
+            sscanf(argv[4], "%p", &ready);
+            sscanf(argv[5], "%p", &done);
+            test_fast_sync_child(event, ready, done);
+        }
         return;
     }
 
@@ -2694,4 +2823,5 @@ START_TEST(sync)
     test_srwlock_example();
     test_alertable_wait();
     test_apc_deadlock();
+    test_fast_sync();
 }
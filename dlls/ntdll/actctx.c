@@ -3392,6 +3392,41 @@ static NTSTATUS find_query_actctx( HANDLE *handle, DWORD flags, ULONG class )
     return status;
 }
 
+/* Section indexes are sorted by key so that lookups can use a binary search. Entries with
+ * the same key keep the assembly order, so the first matching entry is still found first. */
+static int string_index_compare(const void *p1, const void *p2)
+{
+    const struct string_index *index1 = p1, *index2 = p2;
+
+    if (index1->hash != index2->hash) return index1->hash > index2->hash ? 1 : -1;
+    if (index1->rosterindex != index2->rosterindex) return index1->rosterindex > index2->rosterindex ? 1 : -1;
+    if (index1->data_offset != index2->data_offset) return index1->data_offset > index2->data_offset ? 1 : -1;
+    return 0;
+}
+
+static void sort_string_section(struct strsection_header *section)
+{
+    qsort((BYTE*)section + section->index_offset, section->count, sizeof(struct string_index),
+          string_index_compare);
+}
+
+static int guid_index_compare(const void *p1, const void *p2)
+{
+    const struct guid_index *index1 = p1, *index2 = p2;
+    int ret;
+
+    if ((ret = memcmp(&index1->guid, &index2->guid, sizeof(GUID)))) return ret;
+    if (index1->rosterindex != index2->rosterindex) return index1->rosterindex > index2->rosterindex ? 1 : -1;
+    if (index1->data_offset != index2->data_offset) return index1->data_offset > index2->data_offset ? 1 : -1;
+    return 0;
+}
+
+static void sort_guid_section(struct guidsection_header *section)
+{
+    qsort((BYTE*)section + section->index_offset, section->count, sizeof(struct guid_index),
+          guid_index_compare);
+}
+
 static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct strsection_header **section)
 {
     unsigned int i, j, total_len = 0, dll_count = 0;
@@ -3469,6 +3504,7 @@ static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct str
         }
     }
 
+    sort_string_section(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -3476,50 +3512,48 @@ static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct str
 
 static struct string_index *find_string_index(const struct strsection_header *section, const UNICODE_STRING *name)
 {
-    struct string_index *iter, *index = NULL;
-    ULONG hash = 0, i;
+    struct string_index *iter;
+    ULONG hash = 0, min = 0, max = section->count;
 
     RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
     iter = (struct string_index*)((BYTE*)section + section->index_offset);
 
-    for (i = 0; i < section->count; i++)
+    /* find the first entry with a matching hash */
+    while (min < max)
     {
-        if (iter->hash == hash)
-        {
-            const WCHAR *nameW = (WCHAR*)((BYTE*)section + iter->name_offset);
+        ULONG pos = (min + max) / 2;
+        if (iter[pos].hash < hash) min = pos + 1;
+        else max = pos;
+    }
 
-            if (!strcmpiW(nameW, name->Buffer))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_w(nameW));
-        }
-        iter++;
+    for (iter += min; min < section->count && iter->hash == hash; min++, iter++)
+    {
+        const WCHAR *nameW = (WCHAR*)((BYTE*)section + iter->name_offset);
+
+        if (!strcmpiW(nameW, name->Buffer)) return iter;
+        WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_w(nameW));
     }
 
-    return index;
+    return NULL;
 }
 
 static struct guid_index *find_guid_index(const struct guidsection_header *section, const GUID *guid)
 {
-    struct guid_index *iter, *index = NULL;
-    ULONG i;
+    struct guid_index *iter;
+    ULONG min = 0, max = section->count;
 
     iter = (struct guid_index*)((BYTE*)section + section->index_offset);
 
-    for (i = 0; i < section->count; i++)
+    /* find the first entry with a matching guid */
+    while (min < max)
     {
-        if (!memcmp(guid, &iter->guid, sizeof(*guid)))
-        {
-            index = iter;
-            break;
-        }
-        iter++;
+        ULONG pos = (min + max) / 2;
+        if (memcmp(&iter[pos].guid, guid, sizeof(*guid)) < 0) min = pos + 1;
+        else max = pos;
     }
 
-    return index;
+    if (min < section->count && !memcmp(guid, &iter[min].guid, sizeof(*guid))) return &iter[min];
+    return NULL;
 }
 
 static inline struct dllredirect_data *get_dllredirect_data(ACTIVATION_CONTEXT *ctxt, struct string_index *index)
@@ -3569,11 +3603,6 @@ static NTSTATUS find_dll_redirection(ACTIVATION_CONTEXT* actctx, const UNICODE_S
     return STATUS_SUCCESS;
 }
 
-static inline struct string_index *get_wndclass_first_index(ACTIVATION_CONTEXT *actctx)
-{
-    return (struct string_index*)((BYTE*)actctx->wndclass_section + actctx->wndclass_section->index_offset);
-}
-
 static inline struct wndclass_redirect_data *get_wndclass_data(ACTIVATION_CONTEXT *ctxt, struct string_index *index)
 {
     return (struct wndclass_redirect_data*)((BYTE*)ctxt->wndclass_section + index->data_offset);
@@ -3712,6 +3741,7 @@ static NTSTATUS build_wndclass_section(ACTIVATION_CONTEXT* actctx, struct strsec
         }
     }
 
+    sort_string_section(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -3720,10 +3750,8 @@ static NTSTATUS build_wndclass_section(ACTIVATION_CONTEXT* actctx, struct strsec
 static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRING *name,
                                   PACTCTX_SECTION_KEYED_DATA data)
 {
-    struct string_index *iter, *index = NULL;
+    struct string_index *index;
     struct wndclass_redirect_data *class;
-    ULONG hash;
-    int i;
 
     if (!(actctx->sections & WINDOWCLASS_SECTION)) return STATUS_SXS_KEY_NOT_FOUND;
 
@@ -3738,27 +3766,7 @@ static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRI
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    hash = 0;
-    RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
-    iter = get_wndclass_first_index(actctx);
-
-    for (i = 0; i < actctx->wndclass_section->count; i++)
-    {
-        if (iter->hash == hash)
-        {
-            const WCHAR *nameW = (WCHAR*)((BYTE*)actctx->wndclass_section + iter->name_offset);
-
-            if (!strcmpiW(nameW, name->Buffer))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_w(nameW));
-        }
-        iter++;
-    }
-
+    index = find_string_index(actctx->wndclass_section, name);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     if (data)
@@ -3901,6 +3909,7 @@ static NTSTATUS build_tlib_section(ACTIVATION_CONTEXT* actctx, struct guidsectio
         }
     }
 
+    sort_guid_section(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -4046,9 +4055,10 @@ static void add_comserver_record(const struct guidsection_header *section, const
             (*index)->data_len = sizeof(*data); /* additional length added later */
             (*index)->rosterindex = rosterindex;
 
-            /* Setup new index entry for alias guid. Alias index records are placed after
-               normal records, so normal guids are hit first on search. Note that class count
-               is doubled. */
+            /* Setup new index entry for alias guid. Note that class count is doubled.
+               The index is sorted once all records are added; when several records have
+               the same guid, the search returns the one with the lowest roster index, then
+               the lowest data offset, i.e. the one declared first. */
             alias_index = (*index) + section->count/2;
             generate_uuid(seed, &alias_index->guid);
             alias_index->data_offset = (*index)->data_offset;
@@ -4236,6 +4246,7 @@ static NTSTATUS build_comserver_section(ACTIVATION_CONTEXT* actctx, struct guids
         }
     }
 
+    sort_guid_section(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -4426,6 +4437,7 @@ static NTSTATUS build_ifaceps_section(ACTIVATION_CONTEXT* actctx, struct guidsec
         }
     }
 
+    sort_guid_section(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -4574,6 +4586,7 @@ static NTSTATUS build_clr_surrogate_section(ACTIVATION_CONTEXT* actctx, struct g
         }
     }
 
+    sort_guid_section(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -4776,6 +4789,7 @@ static NTSTATUS build_progid_section(ACTIVATION_CONTEXT* actctx, struct strsecti
         }
     }
 
+    sort_string_section(header);
     *section = header;
 
     return STATUS_SUCCESS;
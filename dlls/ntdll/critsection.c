@@ -39,6 +39,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
 WINE_DECLARE_DEBUG_CHANNEL(relay);
+WINE_DECLARE_DEBUG_CHANNEL(critsec);
 
 static inline LONG interlocked_inc( PLONG dest )
 {
@@ -59,6 +60,69 @@ static inline void small_pause(void)
 #endif
 }
 
+#define MIN_SPIN_COUNT   16  /* spins always allowed before blocking */
+#define SPIN_PROBE_RATE  16  /* one contended entry out of this many spins the full count */
+
+/* Contention state that doesn't fit in the public debug info. It is allocated along with the
+ * debug info by RtlInitializeCriticalSectionEx, and the debug info ProcessLocksList and the stats
+ * entry form a two-element list, so the stats can be found from the debug info; a debug info
+ * whose list still points to itself, such as a static one, has no stats. */
+struct crit_stats
+{
+    LIST_ENTRY                  entry;          /* linked with the debug info ProcessLocksList */
+    DWORD                       spin_estimate;  /* average number of spins needed to acquire the section */
+};
+
+/* debug info allocated by RtlInitializeCriticalSectionEx */
+struct crit_debug_info
+{
+    RTL_CRITICAL_SECTION_DEBUG  debug;
+    struct crit_stats           stats;
+};
+
+static inline const char *crit_name( RTL_CRITICAL_SECTION *crit )
+{
+    const char *name = NULL;
+    if (crit->DebugInfo) name = (char *)crit->DebugInfo->Spare[0];
+    return name ? name : "?";
+}
+
+static inline struct crit_stats *get_crit_stats( RTL_CRITICAL_SECTION_DEBUG *debug )
+{
+    LIST_ENTRY *entry = debug->ProcessLocksList.Flink;
+
+    if (entry == &debug->ProcessLocksList) return NULL;
+    return CONTAINING_RECORD( entry, struct crit_stats, entry );
+}
+
+/* number of times to spin on a busy section, based on how long it has been held so far */
+static inline ULONG get_spin_limit( RTL_CRITICAL_SECTION *crit )
+{
+    RTL_CRITICAL_SECTION_DEBUG *debug = crit->DebugInfo;
+    struct crit_stats *stats;
+    ULONG limit;
+
+    if (!debug || !(stats = get_crit_stats( debug ))) return crit->SpinCount;
+    /* periodically spin the full count in case hold times became shorter */
+    if (!(debug->EntryCount % SPIN_PROBE_RATE)) return crit->SpinCount;
+    limit = 2 * stats->spin_estimate + MIN_SPIN_COUNT;
+    return min( limit, crit->SpinCount );
+}
+
+/* update the contention statistics; must be called by the owner after a contended entry */
+static inline void update_spin_stats( RTL_CRITICAL_SECTION *crit, ULONG spins, BOOL waited )
+{
+    RTL_CRITICAL_SECTION_DEBUG *debug = crit->DebugInfo;
+    struct crit_stats *stats;
+
+    if (!debug) return;
+    debug->EntryCount++;
+    if (!(stats = get_crit_stats( debug ))) return;
+    /* spinning did not help, back off; otherwise track the average number of spins needed */
+    if (waited) stats->spin_estimate -= stats->spin_estimate / 8;
+    else stats->spin_estimate = (7 * stats->spin_estimate + spins) / 8;
+}
+
 #ifdef __linux__
 
 static int wait_op = 128; /*FUTEX_WAIT|FUTEX_PRIVATE_FLAG*/
@@ -311,6 +375,8 @@ NTSTATUS WINAPI RtlInitializeCriticalSectionAndSpinCount( RTL_CRITICAL_SECTION *
  */
 NTSTATUS WINAPI RtlInitializeCriticalSectionEx( RTL_CRITICAL_SECTION *crit, ULONG spincount, ULONG flags )
 {
+    struct crit_debug_info *info = NULL;
+
     if (flags & (RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN|RTL_CRITICAL_SECTION_FLAG_STATIC_INIT))
         FIXME("(%p,%u,0x%08x) semi-stub\n", crit, spincount, flags);
 
@@ -320,22 +386,23 @@ NTSTATUS WINAPI RtlInitializeCriticalSectionEx( RTL_CRITICAL_SECTION *crit, ULON
      * is done, then debug info should be managed through Rtlp[Allocate|Free]DebugInfo
      * so (e.g.) MakeCriticalSectionGlobal() doesn't free it using HeapFree().
      */
-    if (flags & RTL_CRITICAL_SECTION_FLAG_NO_DEBUG_INFO)
-        crit->DebugInfo = NULL;
-    else
-        crit->DebugInfo = RtlAllocateHeap(GetProcessHeap(), 0, sizeof(RTL_CRITICAL_SECTION_DEBUG));
+    if (!(flags & RTL_CRITICAL_SECTION_FLAG_NO_DEBUG_INFO))
+        info = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*info) );
 
-    if (crit->DebugInfo)
+    if (info)
     {
+        crit->DebugInfo = &info->debug;
         crit->DebugInfo->Type = 0;
         crit->DebugInfo->CreatorBackTraceIndex = 0;
         crit->DebugInfo->CriticalSection = crit;
-        crit->DebugInfo->ProcessLocksList.Blink = &(crit->DebugInfo->ProcessLocksList);
-        crit->DebugInfo->ProcessLocksList.Flink = &(crit->DebugInfo->ProcessLocksList);
         crit->DebugInfo->EntryCount = 0;
         crit->DebugInfo->ContentionCount = 0;
         memset( crit->DebugInfo->Spare, 0, sizeof(crit->DebugInfo->Spare) );
+        info->stats.spin_estimate = 0;
+        info->stats.entry.Flink = info->stats.entry.Blink = &info->debug.ProcessLocksList;
+        info->debug.ProcessLocksList.Flink = info->debug.ProcessLocksList.Blink = &info->stats.entry;
     }
+    else crit->DebugInfo = NULL;
     crit->LockCount      = -1;
     crit->RecursionCount = 0;
     crit->OwningThread   = 0;
@@ -398,6 +465,13 @@ NTSTATUS WINAPI RtlDeleteCriticalSection( RTL_CRITICAL_SECTION *crit )
     crit->OwningThread   = 0;
     if (crit->DebugInfo)
     {
+        struct crit_stats *stats = get_crit_stats( crit->DebugInfo );
+
+        if (crit->DebugInfo->EntryCount)
+            TRACE_(critsec)( "section %p %s: %u contended entries, %u waits, spin estimate %u/%lu\n",
+                             crit, debugstr_a(crit_name( crit )), crit->DebugInfo->EntryCount,
+                             crit->DebugInfo->ContentionCount, stats ? stats->spin_estimate : 0,
+                             (ULONG_PTR)crit->SpinCount );
         /* only free the ones we made in here */
         if (!crit->DebugInfo->Spare[0])
         {
@@ -453,9 +527,7 @@ NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
 
         if ( status == STATUS_TIMEOUT )
         {
-            const char *name = NULL;
-            if (crit->DebugInfo) name = (char *)crit->DebugInfo->Spare[0];
-            if (!name) name = "?";
+            const char *name = crit_name( crit );
             ERR( "section %p %s wait timed out in thread %04x, blocked by %04x, retrying (60 sec)\n",
                  crit, debugstr_a(name), GetCurrentThreadId(), HandleToULong(crit->OwningThread) );
             status = wait_semaphore( crit, 60 );
@@ -547,12 +619,16 @@ NTSTATUS WINAPI RtlpUnWaitCriticalSection( RTL_CRITICAL_SECTION *crit )
  */
 NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
+    ULONG spins = 0;
+    BOOL contended = FALSE, waited = FALSE;
+
     if (crit->SpinCount)
     {
-        ULONG count;
+        ULONG limit;
 
         if (RtlTryEnterCriticalSection( crit )) return STATUS_SUCCESS;
-        for (count = crit->SpinCount; count > 0; count--)
+        contended = TRUE;
+        for (limit = get_spin_limit( crit ); spins < limit; spins++)
         {
             if (crit->LockCount > 0) break;  /* more than one waiter, don't bother spinning */
             if (crit->LockCount == -1)       /* try again */
@@ -573,10 +649,12 @@ NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
 
         /* Now wait for it */
         RtlpWaitForCriticalSection( crit );
+        contended = waited = TRUE;
     }
 done:
     crit->OwningThread   = ULongToHandle(GetCurrentThreadId());
     crit->RecursionCount = 1;
+    if (contended) update_spin_stats( crit, spins, waited );
     return STATUS_SUCCESS;
 }
 
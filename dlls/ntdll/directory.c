@@ -2024,6 +2024,279 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event,
 }
 
 
+/* cache of directory contents for case-insensitive lookups */
+
+#define MAX_DIR_NAME_CACHES 64  /* max number of directories kept in the cache */
+
+struct cached_dir_name
+{
+    unsigned int hash;        /* hash of the lower-case name */
+    int          next;        /* index of the next name in the hash chain */
+    unsigned int name;        /* offset of the lower-case name in the names buffer */
+    unsigned int len;         /* length of the name in WCHARs */
+    unsigned int unix_name;   /* offset of the Unix name in the Unix names buffer */
+    BOOL         short_name;  /* is this the generated short name of the file? */
+};
+
+struct dir_name_cache
+{
+    struct list             entry;        /* entry in the LRU list of cached directories */
+    dev_t                   dev;          /* device of the directory */
+    ino_t                   ino;          /* inode of the directory */
+    time_t                  mtime;        /* modification time of the directory when it was read */
+    time_t                  read_time;    /* time at which the directory was read */
+    struct cached_dir_name  *names;       /* array of names */
+    unsigned int            count;        /* number of names */
+    unsigned int            size;         /* allocated size of the names array */
+    int                     *hash;        /* hash table of indices in the names array */
+    unsigned int            hash_size;    /* size of the hash table, a power of two */
+    WCHAR                   *nameW;       /* buffer for the lower-case names */
+    unsigned int            nameW_len;    /* used length of the lower-case names buffer */
+    unsigned int            nameW_size;   /* allocated size of the lower-case names buffer */
+    char                    *unix_names;  /* buffer for the Unix names */
+    unsigned int            unix_len;     /* used length of the Unix names buffer */
+    unsigned int            unix_size;    /* allocated size of the Unix names buffer */
+};
+
+static struct list dir_name_caches = LIST_INIT( dir_name_caches );
+static unsigned int nb_dir_name_caches;
+
+static RTL_CRITICAL_SECTION dir_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG dir_cache_critsect_debug =
+{
+    0, 0, &dir_cache_section,
+    { &dir_cache_critsect_debug.ProcessLocksList, &dir_cache_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": dir_cache_section") }
+};
+static RTL_CRITICAL_SECTION dir_cache_section = { &dir_cache_critsect_debug, -1, 0, 0, 0, 0 };
+
+
+static unsigned int hash_dir_name( const WCHAR *name, unsigned int len )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < len; i++) hash = hash * 65599 + name[i];
+    return hash;
+}
+
+/* grow a buffer of the dir name cache to hold at least 'needed' elements */
+static void *grow_dir_cache_buffer( void *buffer, unsigned int *size, unsigned int needed,
+                                    unsigned int elem_size )
+{
+    unsigned int new_size;
+    void *ptr;
+
+    if (needed <= *size) return buffer;
+    new_size = max( needed, max( 64, *size * 2 ));
+    if (buffer) ptr = RtlReAllocateHeap( GetProcessHeap(), 0, buffer, new_size * elem_size );
+    else ptr = RtlAllocateHeap( GetProcessHeap(), 0, new_size * elem_size );
+    if (ptr) *size = new_size;
+    return ptr;
+}
+
+static void free_dir_name_cache( struct dir_name_cache *cache )
+{
+    RtlFreeHeap( GetProcessHeap(), 0, cache->names );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->hash );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->nameW );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->unix_names );
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+}
+
+/* add a name to a dir name cache; the Unix name must already be stored at offset unix_name */
+static BOOL add_cached_dir_name( struct dir_name_cache *cache, const WCHAR *name, unsigned int len,
+                                 unsigned int unix_name, BOOL short_name )
+{
+    struct cached_dir_name *entry;
+    unsigned int i;
+    void *ptr;
+
+    if (!(ptr = grow_dir_cache_buffer( cache->names, &cache->size, cache->count + 1,
+                                       sizeof(*cache->names) )))
+        return FALSE;
+    cache->names = ptr;
+    if (!(ptr = grow_dir_cache_buffer( cache->nameW, &cache->nameW_size, cache->nameW_len + len,
+                                       sizeof(WCHAR) )))
+        return FALSE;
+    cache->nameW = ptr;
+
+    for (i = 0; i < len; i++) cache->nameW[cache->nameW_len + i] = tolowerW( name[i] );
+    entry = &cache->names[cache->count++];
+    entry->hash       = hash_dir_name( cache->nameW + cache->nameW_len, len );
+    entry->next       = -1;
+    entry->name       = cache->nameW_len;
+    entry->len        = len;
+    entry->unix_name  = unix_name;
+    entry->short_name = short_name;
+    cache->nameW_len += len;
+    return TRUE;
+}
+
+/***********************************************************************
+ *           read_dir_name_cache
+ *
+ * Read the contents of a directory into a new dir name cache.
+ */
+static NTSTATUS read_dir_name_cache( const char *unix_name, const struct stat *st,
+                                     struct dir_name_cache **ret )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN], short_nameW[12];
+    struct dir_name_cache *cache;
+    UNICODE_STRING str;
+    BOOLEAN spaces;
+    struct dirent *de;
+    DIR *dir;
+    int i, len, name_len;
+    void *ptr;
+
+    if (!(dir = opendir( unix_name )))
+    {
+        if (errno == ENOENT) return STATUS_OBJECT_PATH_NOT_FOUND;
+        else return FILE_GetNtStatus();
+    }
+    if (!(cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache) )))
+    {
+        closedir( dir );
+        return STATUS_NO_MEMORY;
+    }
+    cache->dev       = st->st_dev;
+    cache->ino       = st->st_ino;
+    cache->mtime     = st->st_mtime;
+    cache->read_time = time( NULL );
+
+    str.Buffer = buffer;
+    str.MaximumLength = sizeof(buffer);
+    while ((de = readdir( dir )))
+    {
+        len = strlen( de->d_name );
+        name_len = ntdll_umbstowcs( 0, de->d_name, len, buffer, MAX_DIR_ENTRY_LEN );
+        if (name_len < 0) continue;
+
+        if (!(ptr = grow_dir_cache_buffer( cache->unix_names, &cache->unix_size,
+                                           cache->unix_len + len + 1, 1 )))
+            goto failed;
+        cache->unix_names = ptr;
+        memcpy( cache->unix_names + cache->unix_len, de->d_name, len + 1 );
+
+        if (!add_cached_dir_name( cache, buffer, name_len, cache->unix_len, FALSE )) goto failed;
+        str.Length = name_len * sizeof(WCHAR);
+        if (!RtlIsNameLegalDOS8Dot3( &str, NULL, &spaces ) || spaces)
+        {
+            name_len = hash_short_file_name( &str, short_nameW );
+            if (!add_cached_dir_name( cache, short_nameW, name_len, cache->unix_len, TRUE ))
+                goto failed;
+        }
+        cache->unix_len += len + 1;
+    }
+    closedir( dir );
+
+    cache->hash_size = 16;
+    while (cache->hash_size < cache->count) cache->hash_size *= 2;
+    if (!(cache->hash = RtlAllocateHeap( GetProcessHeap(), 0, cache->hash_size * sizeof(*cache->hash) )))
+    {
+        free_dir_name_cache( cache );
+        return STATUS_NO_MEMORY;
+    }
+    for (i = 0; i < cache->hash_size; i++) cache->hash[i] = -1;
+    /* insert in reverse order so that chains follow the readdir order, the first entry wins */
+    for (i = cache->count - 1; i >= 0; i--)
+    {
+        unsigned int bucket = cache->names[i].hash & (cache->hash_size - 1);
+        cache->names[i].next = cache->hash[bucket];
+        cache->hash[bucket] = i;
+    }
+    TRACE( "read %u names from %s\n", cache->count, debugstr_a(unix_name) );
+    *ret = cache;
+    return STATUS_SUCCESS;
+
+failed:
+    closedir( dir );
+    free_dir_name_cache( cache );
+    return STATUS_NO_MEMORY;
+}
+
+/* look up a lower-case name in a dir name cache */
+static const char *lookup_dir_name_cache( const struct dir_name_cache *cache, const WCHAR *name,
+                                          unsigned int len, unsigned int hash, BOOL short_name )
+{
+    int i;
+
+    for (i = cache->hash[hash & (cache->hash_size - 1)]; i != -1; i = cache->names[i].next)
+    {
+        const struct cached_dir_name *entry = &cache->names[i];
+
+        if (entry->hash != hash || entry->len != len || entry->short_name != short_name) continue;
+        if (!memcmp( cache->nameW + entry->name, name, len * sizeof(WCHAR) ))
+            return cache->unix_names + entry->unix_name;
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *           find_cached_dir_name
+ *
+ * Do a case-insensitive search for a name in a directory, using the cached
+ * directory contents when the directory hasn't been modified since they were read.
+ * The Unix name found is copied to ret_name, which must hold MAX_DIR_ENTRY_LEN+1 chars.
+ */
+static NTSTATUS find_cached_dir_name( const char *unix_name, const WCHAR *name, int length,
+                                      BOOLEAN check_short_names, char *ret_name )
+{
+    WCHAR lower[MAX_DIR_ENTRY_LEN];
+    struct dir_name_cache *cache;
+    const char *found;
+    struct stat st;
+    unsigned int hash;
+    NTSTATUS status;
+    int i;
+
+    if (length > MAX_DIR_ENTRY_LEN) return STATUS_OBJECT_PATH_NOT_FOUND;
+    if (stat( unix_name, &st ) == -1)
+    {
+        if (errno == ENOENT) return STATUS_OBJECT_PATH_NOT_FOUND;
+        else return FILE_GetNtStatus();
+    }
+
+    for (i = 0; i < length; i++) lower[i] = tolowerW( name[i] );
+    hash = hash_dir_name( lower, length );
+
+    RtlEnterCriticalSection( &dir_cache_section );
+
+    LIST_FOR_EACH_ENTRY( cache, &dir_name_caches, struct dir_name_cache, entry )
+    {
+        if (cache->dev != st.st_dev || cache->ino != st.st_ino) continue;
+        list_remove( &cache->entry );
+        /* the directory may have been modified again within the same mtime tick
+         * if it was read too soon after its last modification, so don't trust it then */
+        if (cache->mtime == st.st_mtime && cache->read_time >= cache->mtime + 2) goto done;
+        free_dir_name_cache( cache );
+        nb_dir_name_caches--;
+        break;
+    }
+
+    if ((status = read_dir_name_cache( unix_name, &st, &cache )))
+    {
+        RtlLeaveCriticalSection( &dir_cache_section );
+        return status;
+    }
+    if (nb_dir_name_caches >= MAX_DIR_NAME_CACHES)
+    {
+        struct dir_name_cache *lru = LIST_ENTRY( list_tail( &dir_name_caches ), struct dir_name_cache, entry );
+        list_remove( &lru->entry );
+        free_dir_name_cache( lru );
+    }
+    else nb_dir_name_caches++;
+
+done:
+    list_add_head( &dir_name_caches, &cache->entry );
+    found = lookup_dir_name_cache( cache, lower, length, hash, FALSE );
+    if (!found && check_short_names) found = lookup_dir_name_cache( cache, lower, length, hash, TRUE );
+    if (found) strcpy( ret_name, found );
+    RtlLeaveCriticalSection( &dir_cache_section );
+    return found ? STATUS_SUCCESS : STATUS_OBJECT_PATH_NOT_FOUND;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2034,11 +2307,9 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event,
 static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, int length,
                                   BOOLEAN check_case, BOOLEAN *is_win_dir )
 {
-    WCHAR buffer[MAX_DIR_ENTRY_LEN];
     UNICODE_STRING str;
     BOOLEAN spaces, is_name_8_dot_3;
-    DIR *dir;
-    struct dirent *de;
+    NTSTATUS status;
     struct stat st;
     int ret, used_default;
 
@@ -2083,6 +2354,7 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
         int fd = open( unix_name, O_RDONLY | O_DIRECTORY );
         if (fd != -1)
         {
+            WCHAR buffer[MAX_DIR_ENTRY_LEN];
             KERNEL_DIRENT *kde;
 
             RtlEnterCriticalSection( &dir_section );
@@ -2134,40 +2406,13 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
-    if (!(dir = opendir( unix_name )))
-    {
-        if (errno == ENOENT) return STATUS_OBJECT_PATH_NOT_FOUND;
-        else return FILE_GetNtStatus();
-    }
-    unix_name[pos - 1] = '/';
-    str.Buffer = buffer;
-    str.MaximumLength = sizeof(buffer);
-    while ((de = readdir( dir )))
+    status = find_cached_dir_name( unix_name, name, length, is_name_8_dot_3, unix_name + pos );
+    if (status == STATUS_SUCCESS)
     {
-        ret = ntdll_umbstowcs( 0, de->d_name, strlen(de->d_name), buffer, MAX_DIR_ENTRY_LEN );
-        if (ret == length && !memicmpW( buffer, name, length ))
-        {
-            strcpy( unix_name + pos, de->d_name );
-            closedir( dir );
-            goto success;
-        }
-
-        if (!is_name_8_dot_3) continue;
-
-        str.Length = ret * sizeof(WCHAR);
-        if (!RtlIsNameLegalDOS8Dot3( &str, NULL, &spaces ) || spaces)
-        {
-            WCHAR short_nameW[12];
-            ret = hash_short_file_name( &str, short_nameW );
-            if (ret == length && !memicmpW( short_nameW, name, length ))
-            {
-                strcpy( unix_name + pos, de->d_name );
-                closedir( dir );
-                goto success;
-            }
-        }
+        unix_name[pos - 1] = '/';
+        goto success;
     }
-    closedir( dir );
+    if (status != STATUS_OBJECT_PATH_NOT_FOUND) return status;
 
 not_found:
     unix_name[pos - 1] = 0;
@@ -994,7 +994,8 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
     }
 
 done:
-    send_completion = cvalue != 0;
+    /* completion ports can only be associated with asynchronous handles */
+    send_completion = cvalue != 0 && async_read;
 
 err:
     if (needs_close) close( unix_handle );
@@ -1016,7 +1017,8 @@ err:
     ret_status = async_read && (options & FILE_NO_INTERMEDIATE_BUFFERING) && status == STATUS_SUCCESS
             ? STATUS_PENDING : status;
 
-    if (send_completion) NTDLL_AddCompletion( hFile, cvalue, status, total, ret_status == STATUS_PENDING );
+    if (send_completion && (ret_status == STATUS_PENDING || !server_fd_skips_completion( hFile )))
+        NTDLL_AddCompletion( hFile, cvalue, status, total, ret_status == STATUS_PENDING );
     return ret_status;
 }
 
@@ -1203,7 +1205,7 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
     ULONG total = 0;
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
-    BOOL send_completion = FALSE, async_write, append_write = FALSE, timeout_init_done = FALSE;
+    BOOL send_completion = FALSE, async_write = FALSE, append_write = FALSE, timeout_init_done = FALSE;
     LARGE_INTEGER offset_eof;
 
     TRACE("(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p)\n",
@@ -1386,7 +1388,8 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
     }
 
 done:
-    send_completion = cvalue != 0;
+    /* completion ports can only be associated with asynchronous handles */
+    send_completion = cvalue != 0 && async_write;
 
 err:
     if (needs_close) close( unix_handle );
@@ -1409,7 +1412,8 @@ err:
         if (status != STATUS_PENDING && hEvent) NtResetEvent( hEvent, NULL );
     }
 
-    if (send_completion) NTDLL_AddCompletion( hFile, cvalue, status, total, FALSE );
+    if (send_completion && !server_fd_skips_completion( hFile ))
+        NTDLL_AddCompletion( hFile, cvalue, status, total, FALSE );
 
     return status;
 }
@@ -2642,6 +2646,7 @@ NTSTATUS WINAPI NtSetInformationFile(HANDLE handle, PIO_STATUS_BLOCK io,
         {
             FILE_COMPLETION_INFORMATION *info = ptr;
 
+            move_completion_to_server( info->CompletionPort );
             SERVER_START_REQ( set_completion_info )
             {
                 req->handle   = wine_server_obj_handle( handle );
@@ -2669,6 +2674,8 @@ NTSTATUS WINAPI NtSetInformationFile(HANDLE handle, PIO_STATUS_BLOCK io,
                 io->u.Status  = wine_server_call( req );
             }
             SERVER_END_REQ;
+            if (!io->u.Status && (info->Flags & FILE_SKIP_COMPLETION_PORT_ON_SUCCESS))
+                server_set_fd_skip_completion( handle );
         } else
             io->u.Status = STATUS_INFO_LENGTH_MISMATCH;
         break;
@@ -83,6 +83,7 @@ typedef struct
 /* Value for arena 'magic' field */
 #define ARENA_INUSE_MAGIC      0x455355
 #define ARENA_PENDING_MAGIC    0xbedead
+#define ARENA_CACHED_MAGIC     0xcac4ed
 #define ARENA_FREE_MAGIC       0x45455246
 #define ARENA_LARGE_MAGIC      0x6752614c
 
@@ -164,6 +165,9 @@ typedef struct tagHEAP
     ARENA_INUSE    **pending_free;  /* Ring buffer for pending free requests */
     RTL_CRITICAL_SECTION critSection; /* Critical section for serialization */
     FREE_LIST_ENTRY *freeList;      /* Free lists */
+    LONG             serial;        /* Unique serial number, to detect stale thread caches */
+    LONG             cache_flushes; /* Number of thread caches being given back to the heap */
+    ULONG            compat_level;  /* HeapCompatibilityInformation value */
 } HEAP;
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
@@ -179,6 +183,7 @@ typedef struct tagHEAP
 #define HEAP_VALIDATE_PARAMS  0x40000000
 
 static HEAP *processHeap;  /* main process heap */
+static LONG heap_serial;   /* last heap serial number */
 
 static BOOL HEAP_IsRealArena( HEAP *heapPtr, DWORD flags, LPCVOID block, BOOL quiet );
 
@@ -296,7 +301,8 @@ static void subheap_notify_free_all(SUBHEAP const *subheap)
         {
             ARENA_INUSE const *pArena = (ARENA_INUSE const *)ptr;
             if (pArena->magic == ARENA_INUSE_MAGIC) notify_free(pArena + 1);
-            else if (pArena->magic != ARENA_PENDING_MAGIC) ERR("bad inuse_magic @%p\n", pArena);
+            else if (pArena->magic != ARENA_PENDING_MAGIC && pArena->magic != ARENA_CACHED_MAGIC)
+                ERR("bad inuse_magic @%p\n", pArena);
             ptr += sizeof(*pArena) + (pArena->size & ARENA_SIZE_MASK);
         }
     }
@@ -925,6 +931,9 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
         heap->flags         = flags;
         heap->magic         = HEAP_MAGIC;
         heap->grow_size     = max( HEAP_DEF_SIZE, totalSize );
+        heap->serial        = interlocked_xchg_add( &heap_serial, 1 ) + 1;
+        heap->cache_flushes = 0;
+        heap->compat_level  = 0;
         list_init( &heap->subheap_list );
         list_init( &heap->large_list );
 
@@ -1058,6 +1067,39 @@ static ARENA_FREE *HEAP_FindFreeBlock( HEAP *heap, SIZE_T size,
 }
 
 
+/***********************************************************************
+ *           allocate_block
+ *
+ * Find a free block and turn it into an in-use block of the requested size.
+ * The caller has to set the unused bytes count.
+ */
+static ARENA_INUSE *allocate_block( HEAP *heap, SIZE_T rounded_size, SUBHEAP **subheap )
+{
+    ARENA_FREE *pArena;
+    ARENA_INUSE *pInUse;
+
+    if (!(pArena = HEAP_FindFreeBlock( heap, rounded_size, subheap ))) return NULL;
+
+    /* Remove the arena from the free list */
+
+    list_remove( &pArena->entry );
+
+    /* Build the in-use arena */
+
+    pInUse = (ARENA_INUSE *)pArena;
+
+    /* in-use arena is smaller than free arena,
+     * so we have to add the difference to the size */
+    pInUse->size  = (pInUse->size & ~ARENA_FLAG_FREE) + sizeof(ARENA_FREE) - sizeof(ARENA_INUSE);
+    pInUse->magic = ARENA_INUSE_MAGIC;
+
+    /* Shrink the block */
+
+    HEAP_ShrinkBlock( *subheap, pInUse, rounded_size );
+    return pInUse;
+}
+
+
 /***********************************************************************
  *           HEAP_IsValidArenaPtr
  *
@@ -1214,7 +1256,8 @@ static BOOL HEAP_ValidateInUseArena( const SUBHEAP *subheap, const ARENA_INUSE *
     }
 
     /* Check magic number */
-    if (pArena->magic != ARENA_INUSE_MAGIC && pArena->magic != ARENA_PENDING_MAGIC)
+    if (pArena->magic != ARENA_INUSE_MAGIC && pArena->magic != ARENA_PENDING_MAGIC &&
+        pArena->magic != ARENA_CACHED_MAGIC)
     {
         if (quiet == NOISY) {
             ERR("Heap %p: invalid in-use arena magic %08x for %p\n", subheap->heap, pArena->magic, pArena );
@@ -1429,7 +1472,7 @@ static BOOL validate_block_pointer( HEAP *heap, SUBHEAP **ret_subheap, const ARE
         ret = HEAP_ValidateInUseArena( subheap, arena, QUIET );
     else if ((ULONG_PTR)arena % ALIGNMENT != ARENA_OFFSET)
         WARN( "Heap %p: unaligned arena pointer %p\n", subheap->heap, arena );
-    else if (arena->magic == ARENA_PENDING_MAGIC)
+    else if (arena->magic == ARENA_PENDING_MAGIC || arena->magic == ARENA_CACHED_MAGIC)
         WARN( "Heap %p: block %p used after free\n", subheap->heap, arena + 1 );
     else if (arena->magic != ARENA_INUSE_MAGIC)
         WARN( "Heap %p: invalid in-use arena magic %08x for %p\n", subheap->heap, arena->magic, arena );
@@ -1447,6 +1490,378 @@ static BOOL validate_block_pointer( HEAP *heap, SUBHEAP **ret_subheap, const ARE
 }
 
 
+/* Low fragmentation heap front end
+ *
+ * Once HeapCompatibilityInformation has been set to 2, small blocks freed by
+ * a thread are kept in a per-thread cache, sorted by block size, and handed
+ * out again to the next allocations of the same size without taking the
+ * heap lock. The cached blocks remain in-use blocks for the rest of the heap
+ * code, marked with ARENA_CACHED_MAGIC. The caches are refilled and drained
+ * in batches, so that the heap lock is only taken every few operations.
+ * The caches of a killed thread are flushed later by another thread, and
+ * the amount of memory held by each cache is bounded, so that little is
+ * lost if a thread is killed while it is changing its caches.
+ *
+ * The front end is bypassed when validation or debugging flags are set.
+ */
+
+#define HEAP_LFH_MAX_SIZE    0x400  /* max block size handled by the front end */
+#define HEAP_LFH_NB_BINS     ((HEAP_LFH_MAX_SIZE - HEAP_MIN_DATA_SIZE) / ALIGNMENT + 1)
+#define HEAP_LFH_BIN_DEPTH   32     /* max number of cached blocks of a given size */
+#define HEAP_LFH_BATCH       8      /* number of blocks allocated at once to refill the cache */
+#define HEAP_LFH_NB_RANGES   8      /* number of sub-heaps remembered by a cache */
+#define HEAP_LFH_NB_CACHES   4      /* number of heaps cached by each thread */
+#define HEAP_LFH_MAX_CACHED  0x10000 /* max size of the blocks held by a cache */
+
+struct heap_cache
+{
+    HEAP         *heap;                           /* heap owning the cached blocks */
+    LONG          serial;                         /* serial of the heap, to detect destroyed heaps */
+    unsigned int  next_range;                     /* next sub-heap range to replace */
+    SIZE_T        size;                           /* total size of the cached blocks */
+    const char   *ranges[HEAP_LFH_NB_RANGES][2];  /* known sub-heaps, besides the first one */
+    ARENA_INUSE  *bins[HEAP_LFH_NB_BINS];         /* cached blocks for each size */
+    unsigned int  counts[HEAP_LFH_NB_BINS];       /* number of cached blocks for each size */
+};
+
+struct heap_thread_data
+{
+    struct heap_thread_data *next;                /* next in the list of orphan caches */
+    LONG              busy;                       /* set while the caches are being changed */
+    unsigned int      next_cache;                 /* next cache to evict */
+    struct heap_cache caches[HEAP_LFH_NB_CACHES];
+};
+
+static struct heap_thread_data *orphan_caches;  /* caches of killed threads, to be flushed */
+
+static inline BOOL heap_use_lfh( const HEAP *heap, DWORD flags )
+{
+    return heap->compat_level == 2 && !heap->pending_free &&
+           !(flags & (HEAP_NO_SERIALIZE | HEAP_VALIDATE | HEAP_TAIL_CHECKING_ENABLED |
+                      HEAP_FREE_CHECKING_ENABLED));
+}
+
+static inline unsigned int get_lfh_bin( SIZE_T size )
+{
+    return (size - HEAP_MIN_DATA_SIZE) / ALIGNMENT;
+}
+
+/* check that a heap whose blocks are cached hasn't been destroyed in the meantime, */
+/* and prevent it from being destroyed until release_heap_ref is called */
+static BOOL grab_heap_ref( HEAP *heap, LONG serial )
+{
+    HEAP *ptr;
+    BOOL ret = FALSE;
+
+    if (heap == processHeap) return TRUE;  /* never destroyed */
+
+    RtlEnterCriticalSection( &processHeap->critSection );
+    LIST_FOR_EACH_ENTRY( ptr, &processHeap->entry, HEAP, entry )
+    {
+        if (ptr != heap) continue;
+        if ((ret = (ptr->serial == serial))) interlocked_xchg_add( &heap->cache_flushes, 1 );
+        break;
+    }
+    RtlLeaveCriticalSection( &processHeap->critSection );
+    return ret;
+}
+
+static void release_heap_ref( HEAP *heap )
+{
+    if (heap == processHeap) return;
+    if (interlocked_xchg_add( &heap->cache_flushes, -1 ) == 1) RtlWakeAddressAll( &heap->cache_flushes );
+}
+
+/* give back cached blocks to the heap; the heap lock must be held */
+static void release_cached_blocks( struct heap_cache *cache, unsigned int bin, unsigned int count )
+{
+    ARENA_INUSE *arena;
+
+    while (count-- && (arena = cache->bins[bin]))
+    {
+        cache->bins[bin] = *(ARENA_INUSE **)(arena + 1);
+        cache->counts[bin]--;
+        cache->size -= arena->size & ARENA_SIZE_MASK;
+        arena->magic = ARENA_INUSE_MAGIC;
+        HEAP_MakeInUseBlockFree( HEAP_FindSubHeap( cache->heap, arena ), arena );
+    }
+}
+
+static void flush_heap_cache( struct heap_cache *cache )
+{
+    HEAP *heap = cache->heap;
+    unsigned int i;
+
+    if (heap && grab_heap_ref( heap, cache->serial ))
+    {
+        RtlEnterCriticalSection( &heap->critSection );
+        for (i = 0; i < HEAP_LFH_NB_BINS; i++) release_cached_blocks( cache, i, cache->counts[i] );
+        RtlLeaveCriticalSection( &heap->critSection );
+        release_heap_ref( heap );
+    }
+    memset( cache, 0, sizeof(*cache) );
+}
+
+/* find the current thread cache for a heap, without creating it */
+static struct heap_cache *find_heap_cache( struct heap_thread_data *data, HEAP *heap )
+{
+    unsigned int i;
+
+    for (i = 0; i < HEAP_LFH_NB_CACHES; i++)
+    {
+        struct heap_cache *cache = &data->caches[i];
+
+        if (cache->heap != heap) continue;
+        if (cache->serial != heap->serial)
+        {
+            /* a destroyed heap was at the same address, its blocks are gone */
+            memset( cache, 0, sizeof(*cache) );
+            cache->heap = heap;
+            cache->serial = heap->serial;
+        }
+        return cache;
+    }
+    return NULL;
+}
+
+/* get the current thread cache for a heap, creating it if needed */
+static struct heap_cache *get_heap_cache( struct heap_thread_data *data, HEAP *heap )
+{
+    struct heap_cache *cache;
+    unsigned int i;
+
+    if ((cache = find_heap_cache( data, heap ))) return cache;
+
+    for (i = 0; i < HEAP_LFH_NB_CACHES; i++) if (!data->caches[i].heap) break;
+    if (i == HEAP_LFH_NB_CACHES)
+    {
+        i = data->next_cache++ % HEAP_LFH_NB_CACHES;
+        flush_heap_cache( &data->caches[i] );
+    }
+    cache = &data->caches[i];
+    cache->heap = heap;
+    cache->serial = heap->serial;
+    return cache;
+}
+
+/* give back the blocks of all the caches of a thread, and free them */
+static void free_heap_thread_data( struct heap_thread_data *data )
+{
+    SIZE_T size = 0;
+    void *addr = data;
+    unsigned int i;
+
+    for (i = 0; i < HEAP_LFH_NB_CACHES; i++) flush_heap_cache( &data->caches[i] );
+    NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+}
+
+/* flush the caches left by killed threads; no heap lock must be held */
+static void flush_orphan_caches(void)
+{
+    struct heap_thread_data *data, *next;
+
+    for (data = interlocked_xchg_ptr( (void **)&orphan_caches, NULL ); data; data = next)
+    {
+        next = data->next;
+        free_heap_thread_data( data );
+    }
+}
+
+/* get the caches of the current thread, and mark them as being changed; */
+/* they are left alone if the thread is killed before lfh_leave is called */
+static struct heap_thread_data *lfh_enter( BOOL create )
+{
+    struct heap_thread_data *data = ntdll_get_thread_data()->heap_data;
+
+    if (create && orphan_caches) flush_orphan_caches();
+    if (!data)
+    {
+        SIZE_T size = sizeof(*data);
+        void *ptr = NULL;
+
+        if (!create) return NULL;
+        if (NtAllocateVirtualMemory( NtCurrentProcess(), &ptr, 0, &size, MEM_COMMIT, PAGE_READWRITE ))
+            return NULL;
+        data = ptr;
+        data->busy = 1;
+        ntdll_get_thread_data()->heap_data = data;
+        return data;
+    }
+    interlocked_xchg( &data->busy, 1 );
+    return data;
+}
+
+static inline void lfh_leave( struct heap_thread_data *data )
+{
+    interlocked_xchg( &data->busy, 0 );
+}
+
+/* remember a sub-heap so that its blocks can be freed to the cache */
+static void add_cache_range( struct heap_cache *cache, const SUBHEAP *subheap )
+{
+    const char *start = (const char *)subheap->base + subheap->headerSize;
+    unsigned int i;
+
+    if (subheap == &cache->heap->subheap) return;
+    for (i = 0; i < HEAP_LFH_NB_RANGES; i++) if (cache->ranges[i][0] == start) return;
+    i = cache->next_range++ % HEAP_LFH_NB_RANGES;
+    cache->ranges[i][0] = start;
+    cache->ranges[i][1] = (const char *)subheap->base + subheap->size - sizeof(ARENA_INUSE);
+}
+
+/* check if a block is inside one of the sub-heaps known to the cache */
+static inline BOOL is_cache_range( const struct heap_cache *cache, const ARENA_INUSE *arena )
+{
+    const SUBHEAP *subheap = &cache->heap->subheap;
+    const char *ptr = (const char *)arena;
+    unsigned int i;
+
+    if (ptr >= (const char *)subheap->base + subheap->headerSize &&
+        ptr < (const char *)subheap->base + subheap->size - sizeof(ARENA_INUSE))
+        return TRUE;
+    for (i = 0; i < HEAP_LFH_NB_RANGES; i++)
+        if (ptr >= cache->ranges[i][0] && ptr < cache->ranges[i][1]) return TRUE;
+    return FALSE;
+}
+
+/***********************************************************************
+ *           lfh_add_subheap
+ *
+ * Remember a sub-heap that a block has been freed to; the heap lock must be held.
+ */
+static void lfh_add_subheap( HEAP *heap, const SUBHEAP *subheap )
+{
+    struct heap_thread_data *data;
+    struct heap_cache *cache;
+
+    if (!(data = lfh_enter( FALSE ))) return;
+    if ((cache = find_heap_cache( data, heap ))) add_cache_range( cache, subheap );
+    lfh_leave( data );
+}
+
+/***********************************************************************
+ *           lfh_allocate
+ *
+ * Allocate a block from the thread cache, refilling it if necessary.
+ * The caller has to set the unused bytes count.
+ */
+static ARENA_INUSE *lfh_allocate( HEAP *heap, SIZE_T rounded_size )
+{
+    unsigned int i, bin = get_lfh_bin( rounded_size );
+    struct heap_thread_data *data;
+    struct heap_cache *cache;
+    ARENA_INUSE *arena = NULL;
+    SUBHEAP *subheap;
+
+    if (!(data = lfh_enter( TRUE ))) return NULL;
+    if (!(cache = get_heap_cache( data, heap ))) goto done;
+
+    if (!cache->bins[bin])
+    {
+        /* the blocks may be larger than requested, but they are still in the bin for this size */
+        RtlEnterCriticalSection( &heap->critSection );
+        for (i = 0; i < HEAP_LFH_BATCH; i++)
+        {
+            if (i && cache->size + rounded_size > HEAP_LFH_MAX_CACHED) break;
+            if (!(arena = allocate_block( heap, rounded_size, &subheap ))) break;
+            add_cache_range( cache, subheap );
+            arena->magic = ARENA_CACHED_MAGIC;
+            *(ARENA_INUSE **)(arena + 1) = cache->bins[bin];
+            cache->bins[bin] = arena;
+            cache->counts[bin]++;
+            cache->size += arena->size & ARENA_SIZE_MASK;
+        }
+        RtlLeaveCriticalSection( &heap->critSection );
+    }
+
+    if ((arena = cache->bins[bin]))
+    {
+        cache->bins[bin] = *(ARENA_INUSE **)(arena + 1);
+        cache->counts[bin]--;
+        cache->size -= arena->size & ARENA_SIZE_MASK;
+        arena->magic = ARENA_INUSE_MAGIC;
+    }
+done:
+    lfh_leave( data );
+    return arena;
+}
+
+/***********************************************************************
+ *           lfh_free
+ *
+ * Put a block in the thread cache. Return FALSE if the block can't be
+ * handled by the front end.
+ */
+static BOOL lfh_free( HEAP *heap, ARENA_INUSE *arena )
+{
+    struct heap_thread_data *data;
+    struct heap_cache *cache;
+    unsigned int bin;
+    SIZE_T size;
+    BOOL ret = FALSE;
+
+    if ((ULONG_PTR)arena % ALIGNMENT != ARENA_OFFSET) return FALSE;
+    if (!(data = lfh_enter( TRUE ))) return FALSE;
+    if (!(cache = get_heap_cache( data, heap ))) goto done;
+    if (!is_cache_range( cache, arena )) goto done;
+    if (arena->magic != ARENA_INUSE_MAGIC || (arena->size & ARENA_FLAG_FREE)) goto done;
+    size = arena->size & ARENA_SIZE_MASK;
+    if (size < HEAP_MIN_DATA_SIZE || size > HEAP_LFH_MAX_SIZE) goto done;
+
+    bin = get_lfh_bin( size );
+    if (cache->counts[bin] >= HEAP_LFH_BIN_DEPTH || cache->size + size > HEAP_LFH_MAX_CACHED)
+    {
+        RtlEnterCriticalSection( &heap->critSection );
+        release_cached_blocks( cache, bin, HEAP_LFH_BIN_DEPTH / 2 );
+        RtlLeaveCriticalSection( &heap->critSection );
+        /* the space is used by blocks of other sizes, free this one normally */
+        if (cache->size + size > HEAP_LFH_MAX_CACHED) goto done;
+    }
+    notify_free( arena + 1 );
+    arena->magic = ARENA_CACHED_MAGIC;
+    *(ARENA_INUSE **)(arena + 1) = cache->bins[bin];
+    cache->bins[bin] = arena;
+    cache->counts[bin]++;
+    cache->size += size;
+    ret = TRUE;
+done:
+    lfh_leave( data );
+    return ret;
+}
+
+/***********************************************************************
+ *           heap_thread_detach
+ *
+ * Give back the blocks cached by the current thread.
+ */
+void heap_thread_detach(void)
+{
+    struct heap_thread_data *data = ntdll_get_thread_data()->heap_data;
+
+    if (!data) return;
+    ntdll_get_thread_data()->heap_data = NULL;
+    free_heap_thread_data( data );
+}
+
+
+/***********************************************************************
+ *           heap_thread_abort
+ *
+ * Hand over the blocks cached by a thread that is being killed to the
+ * other threads. The thread may have been interrupted anywhere, so nothing
+ * is locked here, and the caches are dropped if they were being changed.
+ */
+void heap_thread_abort(void)
+{
+    struct heap_thread_data *data = ntdll_get_thread_data()->heap_data;
+
+    if (!data || data->busy) return;
+    ntdll_get_thread_data()->heap_data = NULL;
+    do data->next = orphan_caches;
+    while (interlocked_cmpxchg_ptr( (void **)&orphan_caches, data, data->next ) != data->next);
+}
+
+
 /***********************************************************************
  *           heap_set_debug_flags
  */
@@ -1599,6 +2014,9 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
     HEAP *heapPtr = HEAP_GetPtr( heap );
     SUBHEAP *subheap, *next;
     ARENA_LARGE *arena, *arena_next;
+    struct heap_thread_data *data;
+    struct heap_cache *cache;
+    LONG count;
     SIZE_T size;
     void *addr;
 
@@ -1612,9 +2030,19 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
     list_remove( &heapPtr->entry );
     RtlLeaveCriticalSection( &processHeap->critSection );
 
+    /* wait for other threads still giving back their cached blocks */
+    while ((count = heapPtr->cache_flushes))
+        RtlWaitOnAddress( &heapPtr->cache_flushes, &count, sizeof(count), NULL );
+
     heapPtr->critSection.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &heapPtr->critSection );
 
+    if ((data = lfh_enter( FALSE )))
+    {
+        if ((cache = find_heap_cache( data, heapPtr ))) memset( cache, 0, sizeof(*cache) );
+        lfh_leave( data );
+    }
+
     LIST_FOR_EACH_ENTRY_SAFE( arena, arena_next, &heapPtr->large_list, ARENA_LARGE, entry )
     {
         list_remove( &arena->entry );
@@ -1664,7 +2092,6 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
  */
 void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
 {
-    ARENA_FREE *pArena;
     ARENA_INUSE *pInUse;
     SUBHEAP *subheap;
     HEAP *heapPtr = HEAP_GetPtr( heap );
@@ -1683,6 +2110,16 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
     }
     if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
 
+    if (rounded_size <= HEAP_LFH_MAX_SIZE && heap_use_lfh( heapPtr, flags ) &&
+        (pInUse = lfh_allocate( heapPtr, rounded_size )))
+    {
+        pInUse->unused_bytes = (pInUse->size & ARENA_SIZE_MASK) - size;
+        notify_alloc( pInUse + 1, size, flags & HEAP_ZERO_MEMORY );
+        initialize_block( pInUse + 1, size, pInUse->unused_bytes, flags );
+        TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, pInUse + 1 );
+        return pInUse + 1;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     if (rounded_size >= HEAP_MIN_LARGE_BLOCK_SIZE && (flags & HEAP_GROWABLE))
@@ -1694,9 +2131,7 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
         return ret;
     }
 
-    /* Locate a suitable free block */
-
-    if (!(pArena = HEAP_FindFreeBlock( heapPtr, rounded_size, &subheap )))
+    if (!(pInUse = allocate_block( heapPtr, rounded_size, &subheap )))
     {
         TRACE("(%p,%08x,%08lx): returning NULL\n",
                   heap, flags, size  );
@@ -1705,22 +2140,6 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
         return NULL;
     }
 
-    /* Remove the arena from the free list */
-
-    list_remove( &pArena->entry );
-
-    /* Build the in-use arena */
-
-    pInUse = (ARENA_INUSE *)pArena;
-
-    /* in-use arena is smaller than free arena,
-     * so we have to add the difference to the size */
-    pInUse->size  = (pInUse->size & ~ARENA_FLAG_FREE) + sizeof(ARENA_FREE) - sizeof(ARENA_INUSE);
-    pInUse->magic = ARENA_INUSE_MAGIC;
-
-    /* Shrink the block */
-
-    HEAP_ShrinkBlock( subheap, pInUse, rounded_size );
     pInUse->unused_bytes = (pInUse->size & ARENA_SIZE_MASK) - size;
 
     notify_alloc( pInUse + 1, size, flags & HEAP_ZERO_MEMORY );
@@ -1766,19 +2185,29 @@ BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *pt
 
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
+    pInUse  = (ARENA_INUSE *)ptr - 1;
+
+    if (heap_use_lfh( heapPtr, flags ) && lfh_free( heapPtr, pInUse ))
+    {
+        TRACE("(%p,%08x,%p): returning TRUE\n", heap, flags, ptr );
+        return TRUE;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     /* Inform valgrind we are trying to free memory, so it can throw up an error message */
     notify_free( ptr );
 
     /* Some sanity checks */
-    pInUse  = (ARENA_INUSE *)ptr - 1;
     if (!validate_block_pointer( heapPtr, &subheap, pInUse )) goto error;
 
     if (!subheap)
         free_large_block( heapPtr, flags, ptr );
     else
+    {
+        if (heap_use_lfh( heapPtr, flags )) lfh_add_subheap( heapPtr, subheap );
         HEAP_MakeInUseBlockFree( subheap, pInUse );
+    }
 
     if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
     TRACE("(%p,%08x,%p): returning TRUE\n", heap, flags, ptr );
@@ -1872,23 +2301,13 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
         }
         else  /* Do it the hard way */
         {
-            ARENA_FREE *pNew;
             ARENA_INUSE *pInUse;
             SUBHEAP *newsubheap;
 
             if ((flags & HEAP_REALLOC_IN_PLACE_ONLY) ||
-                !(pNew = HEAP_FindFreeBlock( heapPtr, rounded_size, &newsubheap )))
+                !(pInUse = allocate_block( heapPtr, rounded_size, &newsubheap )))
                 goto oom;
 
-            /* Build the in-use arena */
-
-            list_remove( &pNew->entry );
-            pInUse = (ARENA_INUSE *)pNew;
-            pInUse->size = (pInUse->size & ~ARENA_FLAG_FREE)
-                           + sizeof(ARENA_FREE) - sizeof(ARENA_INUSE);
-            pInUse->magic = ARENA_INUSE_MAGIC;
-            HEAP_ShrinkBlock( newsubheap, pInUse, rounded_size );
-
             mark_block_initialized( pInUse + 1, oldActualSize );
             notify_alloc( pInUse + 1, size, FALSE );
             memcpy( pInUse + 1, pArena + 1, oldActualSize );
@@ -2133,7 +2552,8 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
         }
 
         if (((ARENA_INUSE *)ptr - 1)->magic == ARENA_INUSE_MAGIC ||
-            ((ARENA_INUSE *)ptr - 1)->magic == ARENA_PENDING_MAGIC)
+            ((ARENA_INUSE *)ptr - 1)->magic == ARENA_PENDING_MAGIC ||
+            ((ARENA_INUSE *)ptr - 1)->magic == ARENA_CACHED_MAGIC)
         {
             ARENA_INUSE *pArena = (ARENA_INUSE *)ptr - 1;
             ptr += pArena->size & ARENA_SIZE_MASK;
@@ -2181,7 +2601,7 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
         entry->lpData = pArena + 1;
         entry->cbData = pArena->size & ARENA_SIZE_MASK;
         entry->cbOverhead = sizeof(ARENA_INUSE);
-        entry->wFlags = (pArena->magic == ARENA_PENDING_MAGIC) ?
+        entry->wFlags = (pArena->magic == ARENA_PENDING_MAGIC || pArena->magic == ARENA_CACHED_MAGIC) ?
                         PROCESS_HEAP_UNCOMMITTED_RANGE : PROCESS_HEAP_ENTRY_BUSY;
         /* FIXME: can't handle PROCESS_HEAP_ENTRY_MOVEABLE
         and PROCESS_HEAP_ENTRY_DDESHARE yet */
@@ -2246,6 +2666,8 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
 NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class,
                                          PVOID info, SIZE_T size_in, PSIZE_T size_out)
 {
+    HEAP *heapPtr;
+
     switch (info_class)
     {
     case HeapCompatibilityInformation:
@@ -2254,7 +2676,8 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
         if (size_in < sizeof(ULONG))
             return STATUS_BUFFER_TOO_SMALL;
 
-        *(ULONG *)info = 0; /* standard heap */
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_PARAMETER;
+        *(ULONG *)info = heapPtr->compat_level;
         return STATUS_SUCCESS;
 
     default:
@@ -2268,6 +2691,29 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
  */
 NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class, PVOID info, SIZE_T size)
 {
-    FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
-    return STATUS_SUCCESS;
+    HEAP *heapPtr;
+
+    switch (info_class)
+    {
+    case HeapCompatibilityInformation:
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_PARAMETER;
+
+        if (*(ULONG *)info != 2)
+        {
+            FIXME("%p: unsupported compatibility level %u\n", heap, *(ULONG *)info );
+            return STATUS_SUCCESS;
+        }
+        /* the front end needs a serialized growable heap without debugging flags */
+        if (!(heapPtr->flags & HEAP_GROWABLE) || heapPtr->pending_free ||
+            (heapPtr->flags & (HEAP_NO_SERIALIZE | HEAP_VALIDATE | HEAP_TAIL_CHECKING_ENABLED |
+                               HEAP_FREE_CHECKING_ENABLED)))
+            return STATUS_UNSUCCESSFUL;
+        heapPtr->compat_level = 2;
+        return STATUS_SUCCESS;
+
+    default:
+        FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
+        return STATUS_SUCCESS;
+    }
 }
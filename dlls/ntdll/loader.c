@@ -23,10 +23,17 @@
 #include "wine/port.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -134,6 +141,21 @@ static WINE_MODREF *cached_modref;
 static WINE_MODREF *current_modref;
 static WINE_MODREF *last_failed_modref;
 
+/* persistent cache of the export name indexes that the imports of a module resolve to */
+#define IMPORT_CACHE_MAGIC 0x43504d49  /* "IMPC" */
+
+struct import_cache
+{
+    DWORD magic;
+    DWORD timestamp;    /* TimeDateStamp of the importing module */
+    DWORD image_size;   /* SizeOfImage of the importing module */
+    DWORD checksum;     /* CheckSum of the importing module */
+    DWORD count;        /* number of import thunks */
+    DWORD indexes[1];   /* export name index for each thunk, ~0u if unknown */
+};
+
+static int import_cache_enabled = -1;
+
 static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_MODREF** pwm );
 static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved );
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
@@ -610,15 +632,13 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 
 
 /*************************************************************************
- *		find_named_export
+ *		find_export_name_index
  *
- * Find an exported function by name.
- * The loader_section must be locked while calling this function.
+ * Find the index of an export name in the name table, or -1 if not found.
  */
-static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
-                                  DWORD exp_size, const char *name, int hint, LPCWSTR load_path )
+static int find_export_name_index( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+                                   const char *name, int hint )
 {
-    const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
     int min = 0, max = exports->NumberOfNames - 1;
 
@@ -626,8 +646,7 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
     if (hint >= 0 && hint <= max)
     {
         char *ename = get_rva( module, names[hint] );
-        if (!strcmp( ename, name ))
-            return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
+        if (!strcmp( ename, name )) return hint;
     }
 
     /* then do a binary search */
@@ -635,13 +654,184 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
     {
         int res, pos = (min + max) / 2;
         char *ename = get_rva( module, names[pos] );
-        if (!(res = strcmp( ename, name )))
-            return find_ordinal_export( module, exports, exp_size, ordinals[pos], load_path );
+        if (!(res = strcmp( ename, name ))) return pos;
         if (res > 0) max = pos - 1;
         else min = pos + 1;
     }
-    return NULL;
+    return -1;
+}
+
+
+/*************************************************************************
+ *		find_named_export
+ *
+ * Find an exported function by name.
+ * The loader_section must be locked while calling this function.
+ */
+static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+                                  DWORD exp_size, const char *name, int hint, LPCWSTR load_path )
+{
+    const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
+    int pos = find_export_name_index( module, exports, name, hint );
 
+    if (pos == -1) return NULL;
+    return find_ordinal_export( module, exports, exp_size, ordinals[pos], load_path );
+}
+
+
+/*************************************************************************
+ *		find_cached_named_export
+ *
+ * Find an exported function by name, using the export name index cached
+ * for the import as hint, and update the cache with the index found.
+ * The loader_section must be locked while calling this function.
+ */
+static FARPROC find_cached_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+                                         DWORD exp_size, const IMAGE_IMPORT_BY_NAME *pe_name,
+                                         struct import_cache *cache, DWORD *index, LPCWSTR load_path )
+{
+    const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
+    int pos = find_export_name_index( module, exports, (const char *)pe_name->Name,
+                                      (*index != ~0u) ? *index : pe_name->Hint );
+
+    if ((DWORD)pos != *index)
+    {
+        *index = pos;
+        cache->magic = 0;  /* needs to be saved again */
+    }
+    if (pos == -1) return NULL;
+    return find_ordinal_export( module, exports, exp_size, ordinals[pos], load_path );
+}
+
+
+/*************************************************************************
+ *		get_import_cache_path
+ *
+ * Build the unix name of the import cache file of a module.
+ */
+static char *get_import_cache_path( const WINE_MODREF *wm )
+{
+    const char *config_dir = wine_get_config_dir();
+    ULONG hash;
+    char *path;
+
+    RtlHashUnicodeString( &wm->ldr.FullDllName, TRUE, HASH_STRING_ALGORITHM_X65599, &hash );
+    if (!(path = RtlAllocateHeap( GetProcessHeap(), 0, strlen(config_dir) + sizeof("/importcache/12345678.tmp12345678") )))
+        return NULL;
+    sprintf( path, "%s/importcache/%08x", config_dir, hash );
+    return path;
+}
+
+
+/*************************************************************************
+ *		load_import_cache
+ *
+ * Load the import cache of a module, or create an empty one if the
+ * module has changed since the cache was written.
+ */
+static struct import_cache *load_import_cache( const WINE_MODREF *wm, DWORD count )
+{
+    const IMAGE_NT_HEADERS *nt = RtlImageNtHeader( wm->ldr.BaseAddress );
+    struct import_cache *cache, header;
+    size_t size;
+    char *path, *env;
+    int fd;
+
+    if (import_cache_enabled == -1)
+        import_cache_enabled = (env = getenv( "WINEIMPORTCACHE" )) && atoi( env );
+    if (!import_cache_enabled || !count) return NULL;
+
+    size = FIELD_OFFSET( struct import_cache, indexes[count] );
+    if (!(cache = RtlAllocateHeap( GetProcessHeap(), 0, size ))) return NULL;
+    cache->magic      = IMPORT_CACHE_MAGIC;
+    cache->timestamp  = nt->FileHeader.TimeDateStamp;
+    cache->image_size = nt->OptionalHeader.SizeOfImage;
+    cache->checksum   = nt->OptionalHeader.CheckSum;
+    cache->count      = count;
+
+    if ((path = get_import_cache_path( wm )) && (fd = open( path, O_RDONLY )) != -1)
+    {
+        if (read( fd, &header, sizeof(header) ) == sizeof(header) &&
+            !memcmp( &header, cache, offsetof( struct import_cache, indexes ) ))
+        {
+            cache->indexes[0] = header.indexes[0];
+            size -= sizeof(header);
+            if (read( fd, cache->indexes + 1, size ) == size)
+            {
+                TRACE_(imports)( "using import cache %s for %s\n", path, debugstr_w(wm->ldr.FullDllName.Buffer) );
+                close( fd );
+                RtlFreeHeap( GetProcessHeap(), 0, path );
+                return cache;
+            }
+        }
+        close( fd );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, path );
+
+    memset( cache->indexes, 0xff, count * sizeof(cache->indexes[0]) );
+    cache->magic = 0;  /* not written yet */
+    return cache;
+}
+
+
+/*************************************************************************
+ *		save_import_cache
+ *
+ * Write the import cache of a module if it has been updated, and free it.
+ */
+static void save_import_cache( const WINE_MODREF *wm, struct import_cache *cache )
+{
+    size_t size = FIELD_OFFSET( struct import_cache, indexes[cache->count] );
+    char *path, *tmp, *p;
+    int fd;
+
+    if (cache->magic == IMPORT_CACHE_MAGIC) goto done;
+    cache->magic = IMPORT_CACHE_MAGIC;
+
+    if (!(path = get_import_cache_path( wm ))) goto done;
+    if (!(tmp = RtlAllocateHeap( GetProcessHeap(), 0, strlen(path) + sizeof(".tmp12345678") )))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, path );
+        goto done;
+    }
+    sprintf( tmp, "%s.tmp%x", path, getpid() );
+
+    if ((fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) == -1 && errno == ENOENT)
+    {
+        p = strrchr( path, '/' );
+        *p = 0;
+        mkdir( path, 0777 );
+        *p = '/';
+        fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+    }
+    if (fd != -1)
+    {
+        BOOL ret = (write( fd, cache, size ) == size);
+        close( fd );
+        if (!ret || rename( tmp, path )) unlink( tmp );
+        else TRACE_(imports)( "saved import cache %s for %s\n", path, debugstr_w(wm->ldr.FullDllName.Buffer) );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, tmp );
+    RtlFreeHeap( GetProcessHeap(), 0, path );
+done:
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+}
+
+
+/*************************************************************************
+ *		count_import_thunks
+ */
+static DWORD count_import_thunks( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr )
+{
+    const IMAGE_THUNK_DATA *import_list;
+    DWORD count = 0;
+
+    if (descr->u.OriginalFirstThunk)
+        import_list = get_rva( module, (DWORD)descr->u.OriginalFirstThunk );
+    else
+        import_list = get_rva( module, (DWORD)descr->FirstThunk );
+    while (import_list[count].u1.Ordinal) count++;
+    return count;
 }
 
 
@@ -649,9 +839,12 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
  *		import_dll
  *
  * Import the dll specified by the given import descriptor.
+ * If cache is not NULL, it holds the cached export name index of each
+ * thunk, and is updated with the index that was actually found.
  * The loader_section must be locked while calling this function.
  */
-static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LPCWSTR load_path, WINE_MODREF **pwm )
+static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LPCWSTR load_path,
+                        struct import_cache *cache, DWORD *indexes, WINE_MODREF **pwm )
 {
     NTSTATUS status;
     WINE_MODREF *wmImp;
@@ -767,9 +960,13 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         {
             IMAGE_IMPORT_BY_NAME *pe_name;
             pe_name = get_rva( module, (DWORD)import_list->u1.AddressOfData );
-            thunk_list->u1.Function = (ULONG_PTR)find_named_export( imp_mod, exports, exp_size,
-                                                                    (const char*)pe_name->Name,
-                                                                    pe_name->Hint, load_path );
+            if (indexes)
+                thunk_list->u1.Function = (ULONG_PTR)find_cached_named_export( imp_mod, exports, exp_size,
+                                                                           pe_name, cache, indexes, load_path );
+            else
+                thunk_list->u1.Function = (ULONG_PTR)find_named_export( imp_mod, exports, exp_size,
+                                                                        (const char*)pe_name->Name,
+                                                                        pe_name->Hint, load_path );
             if (!thunk_list->u1.Function)
             {
                 thunk_list->u1.Function = allocate_stub( name, (const char*)pe_name->Name );
@@ -782,6 +979,7 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         }
         import_list++;
         thunk_list++;
+        if (indexes) indexes++;
     }
 
 done:
@@ -1014,7 +1212,8 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     int i, dep, nb_imports;
     const IMAGE_IMPORT_DESCRIPTOR *imports;
     WINE_MODREF *prev, *imp;
-    DWORD size;
+    struct import_cache *cache;
+    DWORD size, count;
     NTSTATUS status;
     ULONG_PTR cookie;
 
@@ -1039,24 +1238,35 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     wm->alloc_deps = nb_imports;
     wm->deps  = RtlAllocateHeap( GetProcessHeap(), 0, nb_imports*sizeof(WINE_MODREF *) );
 
+    for (i = count = 0; i < nb_imports; i++)
+        count += count_import_thunks( wm->ldr.BaseAddress, &imports[i] );
+    cache = load_import_cache( wm, count );
+
     /* load the imported modules. They are automatically
      * added to the modref list of the process.
      */
     prev = current_modref;
     current_modref = wm;
     status = STATUS_SUCCESS;
-    for (i = 0; i < nb_imports; i++)
+    for (i = count = 0; i < nb_imports; i++)
     {
         dep = wm->nDeps++;
 
-        if (!import_dll( wm->ldr.BaseAddress, &imports[i], load_path, &imp ))
+        if (!import_dll( wm->ldr.BaseAddress, &imports[i], load_path, cache,
+                         cache ? cache->indexes + count : NULL, &imp ))
         {
             imp = NULL;
             status = STATUS_DLL_NOT_FOUND;
         }
         wm->deps[dep] = imp;
+        count += count_import_thunks( wm->ldr.BaseAddress, &imports[i] );
     }
     current_modref = prev;
+    if (cache)
+    {
+        if (status) cache->magic = IMPORT_CACHE_MAGIC;  /* don't save partial results */
+        save_import_cache( wm, cache );
+    }
     if (wm->ldr.ActivationContext) RtlDeactivateActivationContext( 0, cookie );
     return status;
 }
@@ -3251,6 +3461,285 @@ PIMAGE_NT_HEADERS WINAPI RtlImageNtHeader(HMODULE hModule)
 }
 
 
+/* prefetching of the files of statically imported dlls */
+struct prefetch_info
+{
+    char        **dirs;         /* unix names of the dll search path directories */
+    unsigned int  nb_dirs;
+    char        **names;        /* names of the dlls to prefetch, grows as imports are found */
+    unsigned int  nb_names;
+    unsigned int  max_names;
+};
+
+#define MAX_PREFETCH_NAMES 1024
+
+/*************************************************************************
+ *		prefetch_add_name
+ *
+ * Add a dll name to the prefetch list, unless it's already there.
+ * Runs on the prefetch thread, must only use unix functions.
+ */
+static void prefetch_add_name( struct prefetch_info *info, const char *name, size_t len )
+{
+    unsigned int i;
+    char **new_names, *str;
+
+    while (len && name[len - 1] == ' ') len--;
+    if (!len || memchr( name, '/', len ) || memchr( name, '\\', len )) return;
+
+    for (i = 0; i < info->nb_names; i++)
+        if (!strncasecmp( info->names[i], name, len ) && !info->names[i][len]) return;
+
+    if (info->nb_names == info->max_names)
+    {
+        unsigned int new_max = max( 32, info->max_names * 2 );
+        if (new_max > MAX_PREFETCH_NAMES) return;
+        if (!(new_names = realloc( info->names, new_max * sizeof(*new_names) ))) return;
+        info->names = new_names;
+        info->max_names = new_max;
+    }
+    if (!(str = malloc( len + 1 ))) return;
+    memcpy( str, name, len );
+    str[len] = 0;
+    info->names[info->nb_names++] = str;
+}
+
+
+/*************************************************************************
+ *		prefetch_rva_to_offset
+ */
+static off_t prefetch_rva_to_offset( const IMAGE_SECTION_HEADER *sec, unsigned int nb_sections, DWORD rva )
+{
+    unsigned int i;
+
+    for (i = 0; i < nb_sections; i++)
+        if (rva >= sec[i].VirtualAddress && rva < sec[i].VirtualAddress + sec[i].SizeOfRawData)
+            return (off_t)sec[i].PointerToRawData + rva - sec[i].VirtualAddress;
+    return -1;
+}
+
+
+/*************************************************************************
+ *		prefetch_add_imports
+ *
+ * Add the static imports of a PE file to the prefetch list.
+ * Runs on the prefetch thread, must only use unix functions.
+ */
+static void prefetch_add_imports( struct prefetch_info *info, int fd )
+{
+    IMAGE_DOS_HEADER dos;
+    union
+    {
+        IMAGE_NT_HEADERS32 nt32;
+        IMAGE_NT_HEADERS64 nt64;
+    } nt;
+    IMAGE_SECTION_HEADER sec[96];
+    IMAGE_IMPORT_DESCRIPTOR descr;
+    unsigned int i, nb_sections;
+    DWORD import_rva;
+    off_t pos, offset;
+    char name[256];
+    ssize_t len;
+
+    if (pread( fd, &dos, sizeof(dos), 0 ) != sizeof(dos) || dos.e_magic != IMAGE_DOS_SIGNATURE) return;
+    if (pread( fd, &nt, sizeof(nt), dos.e_lfanew ) < (ssize_t)sizeof(nt.nt32)) return;
+    if (nt.nt32.Signature != IMAGE_NT_SIGNATURE) return;
+
+    switch (nt.nt32.OptionalHeader.Magic)
+    {
+    case IMAGE_NT_OPTIONAL_HDR32_MAGIC:
+        if (nt.nt32.OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_IMPORT) return;
+        import_rva = nt.nt32.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress;
+        break;
+    case IMAGE_NT_OPTIONAL_HDR64_MAGIC:
+        if (nt.nt64.OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_IMPORT) return;
+        import_rva = nt.nt64.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress;
+        break;
+    default:
+        return;
+    }
+    if (!import_rva) return;
+
+    nb_sections = min( nt.nt32.FileHeader.NumberOfSections, ARRAY_SIZE( sec ));
+    pos = dos.e_lfanew + FIELD_OFFSET( IMAGE_NT_HEADERS32, OptionalHeader ) +
+          nt.nt32.FileHeader.SizeOfOptionalHeader;
+    if (pread( fd, sec, nb_sections * sizeof(sec[0]), pos ) != nb_sections * sizeof(sec[0])) return;
+
+    if ((pos = prefetch_rva_to_offset( sec, nb_sections, import_rva )) == -1) return;
+    for (i = 0; i < MAX_PREFETCH_NAMES; i++, pos += sizeof(descr))
+    {
+        if (pread( fd, &descr, sizeof(descr), pos ) != sizeof(descr)) break;
+        if (!descr.Name || !descr.FirstThunk) break;
+        if ((offset = prefetch_rva_to_offset( sec, nb_sections, descr.Name )) == -1) continue;
+        if ((len = pread( fd, name, sizeof(name), offset )) <= 0) continue;
+        prefetch_add_name( info, name, strnlen( name, len ));
+    }
+}
+
+
+/*************************************************************************
+ *		prefetch_is_placeholder
+ *
+ * Check for a Wine placeholder dll; the builtin dll is loaded instead, so
+ * there is no point in reading it.
+ * Runs on the prefetch thread, must only use unix functions.
+ */
+static BOOL prefetch_is_placeholder( int fd )
+{
+    static const char fakedll_signature[] = "Wine placeholder DLL";
+    char buffer[sizeof(fakedll_signature)];
+
+    if (pread( fd, buffer, sizeof(buffer), sizeof(IMAGE_DOS_HEADER) ) != sizeof(buffer)) return FALSE;
+    return !memcmp( buffer, fakedll_signature, sizeof(fakedll_signature) );
+}
+
+
+/*************************************************************************
+ *		prefetch_file
+ *
+ * Look for a dll in the search path, queue its imports, and read it to
+ * bring it into the page cache.
+ * Runs on the prefetch thread, must only use unix functions.
+ */
+static void prefetch_file( struct prefetch_info *info, const char *name )
+{
+    static char buffer[65536];
+    unsigned int i;
+    char *path, *p;
+    int fd = -1;
+
+    for (i = 0; i < info->nb_dirs && fd == -1; i++)
+    {
+        if (!(path = malloc( strlen(info->dirs[i]) + strlen(name) + 2 ))) return;
+        sprintf( path, "%s/%s", info->dirs[i], name );
+        if ((fd = open( path, O_RDONLY )) == -1)
+        {
+            for (p = strrchr( path, '/' ) + 1; *p; p++) *p = tolower( *p );
+            fd = open( path, O_RDONLY );
+        }
+        free( path );
+    }
+    if (fd == -1) return;
+
+    if (!prefetch_is_placeholder( fd ))
+    {
+        prefetch_add_imports( info, fd );
+        while (read( fd, buffer, sizeof(buffer) ) > 0) /* nothing */;
+    }
+    close( fd );
+}
+
+
+/*************************************************************************
+ *		free_prefetch_info
+ */
+static void free_prefetch_info( struct prefetch_info *info )
+{
+    unsigned int i;
+
+    for (i = 0; i < info->nb_names; i++) free( info->names[i] );
+    for (i = 0; i < info->nb_dirs; i++) free( info->dirs[i] );
+    free( info->names );
+    free( info->dirs );
+    free( info );
+}
+
+
+/*************************************************************************
+ *		prefetch_thread
+ */
+static void *prefetch_thread( void *arg )
+{
+    struct prefetch_info *info = arg;
+    unsigned int i;
+
+    for (i = 0; i < info->nb_names; i++) prefetch_file( info, info->names[i] );
+    free_prefetch_info( info );
+    return NULL;
+}
+
+
+/*************************************************************************
+ *		start_import_prefetch
+ *
+ * Start reading the files of the dlls statically imported by the main
+ * exe, and of their own imports, on a separate unix thread. The loader
+ * then finds them in the page cache while mapping them one by one.
+ * The loader_section must be locked while calling this function.
+ */
+static void start_import_prefetch( WINE_MODREF *wm, LPCWSTR load_path )
+{
+    const IMAGE_IMPORT_DESCRIPTOR *imports;
+    struct prefetch_info *info;
+    UNICODE_STRING nt_name;
+    ANSI_STRING unix_name;
+    sigset_t sigset, old_sigset;
+    pthread_attr_t attr;
+    pthread_t id;
+    const WCHAR *p;
+    WCHAR *dir;
+    char *env;
+    DWORD size;
+    int i;
+
+    if (!(env = getenv( "WINEPREFETCHDLLS" )) || !atoi( env )) return;
+    if (!load_path) return;
+    if (!(imports = RtlImageDirectoryEntryToData( wm->ldr.BaseAddress, TRUE,
+                                                  IMAGE_DIRECTORY_ENTRY_IMPORT, &size )))
+        return;
+    if (!(info = calloc( 1, sizeof(*info) ))) return;
+
+    for (i = 0; imports[i].Name && imports[i].FirstThunk; i++)
+    {
+        const char *name = get_rva( wm->ldr.BaseAddress, imports[i].Name );
+        prefetch_add_name( info, name, strlen( name ));
+    }
+
+    /* convert the search path directories to unix names */
+    if (!(info->dirs = malloc( (strlenW( load_path ) / 2 + 1) * sizeof(*info->dirs) ))) goto failed;
+    if (!(dir = RtlAllocateHeap( GetProcessHeap(), 0, (strlenW( load_path ) + 1) * sizeof(WCHAR) )))
+        goto failed;
+    for (p = load_path; *p; p++)
+    {
+        const WCHAR *end = strchrW( p, ';' );
+        if (!end) end = p + strlenW( p );
+        if (end > p)
+        {
+            memcpy( dir, p, (end - p) * sizeof(WCHAR) );
+            dir[end - p] = 0;
+            if (RtlDosPathNameToNtPathName_U( dir, &nt_name, NULL, NULL ))
+            {
+                if (!wine_nt_to_unix_file_name( &nt_name, &unix_name, FILE_OPEN, FALSE ))
+                {
+                    if ((info->dirs[info->nb_dirs] = strdup( unix_name.Buffer ))) info->nb_dirs++;
+                    RtlFreeAnsiString( &unix_name );
+                }
+                RtlFreeUnicodeString( &nt_name );
+            }
+        }
+        if (!*end) break;
+        p = end;
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, dir );
+    if (!info->nb_dirs || !info->nb_names) goto failed;
+
+    TRACE( "prefetching %u dlls from %u directories\n", info->nb_names, info->nb_dirs );
+
+    /* the thread has no TEB, so it must never receive a signal */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_SETMASK, &sigset, &old_sigset );
+    pthread_attr_init( &attr );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    i = pthread_create( &id, &attr, prefetch_thread, info );
+    pthread_attr_destroy( &attr );
+    pthread_sigmask( SIG_SETMASK, &old_sigset, NULL );
+    if (!i) return;  /* the thread owns the info now */
+
+failed:
+    free_prefetch_info( info );
+}
+
+
 /******************************************************************
  *		LdrInitializeThunk (NTDLL.@)
  *
@@ -3278,7 +3767,10 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, void **entry, ULONG_PTR unknow
         if (wm->ldr.Flags & LDR_COR_ILONLY)
             status = fixup_imports_ilonly( wm, load_path, entry );
         else
+        {
+            start_import_prefetch( wm, load_path );
             status = fixup_imports( wm, load_path );
+        }
 
         if (status)
         {
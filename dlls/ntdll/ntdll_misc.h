@@ -80,6 +80,8 @@ extern void virtual_init(void) DECLSPEC_HIDDEN;
 extern void virtual_init_threading(void) DECLSPEC_HIDDEN;
 extern void fill_cpu_info(void) DECLSPEC_HIDDEN;
 extern void heap_set_debug_flags( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void heap_thread_detach(void) DECLSPEC_HIDDEN;
+extern void heap_thread_abort(void) DECLSPEC_HIDDEN;
 extern void init_user_process_params( SIZE_T data_size ) DECLSPEC_HIDDEN;
 extern void update_user_process_params( const UNICODE_STRING *image ) DECLSPEC_HIDDEN;
 
@@ -99,7 +101,14 @@ extern void server_leave_uninterrupted_section( RTL_CRITICAL_SECTION *cs, sigset
 extern unsigned int server_select( const select_op_t *select_op, data_size_t size,
                                    UINT flags, const LARGE_INTEGER *timeout ) DECLSPEC_HIDDEN;
 extern unsigned int server_queue_process_apc( HANDLE process, const apc_call_t *call, apc_result_t *result ) DECLSPEC_HIDDEN;
+extern int server_receive_fd( obj_handle_t *handle ) DECLSPEC_HIDDEN;
 extern int server_remove_fd_from_cache( HANDLE handle ) DECLSPEC_HIDDEN;
+extern BOOL server_fd_skips_completion( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void server_set_fd_skip_completion( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void remove_fast_sync_from_cache( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void remove_key_values_from_cache( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void move_completion_to_server( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void close_local_completion( HANDLE handle ) DECLSPEC_HIDDEN;
 extern int server_get_unix_fd( HANDLE handle, unsigned int access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options ) DECLSPEC_HIDDEN;
 extern int server_pipe( int fd[2] ) DECLSPEC_HIDDEN;
@@ -191,6 +200,7 @@ extern void virtual_set_large_address_space(void) DECLSPEC_HIDDEN;
 extern void virtual_fill_image_information( const pe_image_info_t *pe_info,
                                             SECTION_IMAGE_INFORMATION *info ) DECLSPEC_HIDDEN;
 extern struct _KUSER_SHARED_DATA *user_shared_data DECLSPEC_HIDDEN;
+extern void init_user_shared_data_time(void) DECLSPEC_HIDDEN;
 
 /* completion */
 extern NTSTATUS NTDLL_AddCompletion( HANDLE hFile, ULONG_PTR CompletionValue,
@@ -237,6 +247,8 @@ struct ntdll_thread_data
     int                wait_fd[2];    /* fd for sleeping server requests */
     BOOL               wow64_redir;   /* Wow64 filesystem redirection flag */
     pthread_t          pthread_id;    /* pthread thread id */
+    struct heap_thread_data *heap_data; /* per-thread heap caches */
+    int                virtual_shared; /* nesting count of shared virtual memory lock */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
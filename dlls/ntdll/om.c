@@ -238,6 +238,9 @@ NTSTATUS WINAPI NtSetInformationObject(IN HANDLE handle,
 
             if (len < sizeof(*p)) return STATUS_INVALID_BUFFER_SIZE;
 
+            /* an inherited handle reaches another process */
+            if (p->InheritHandle) move_completion_to_server( handle );
+
             SERVER_START_REQ( set_handle_info )
             {
                 req->handle = wine_server_obj_handle( handle );
@@ -355,6 +358,11 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
                                    ACCESS_MASK access, ULONG attributes, ULONG options )
 {
     NTSTATUS ret;
+
+    /* source_process may also be a real handle to this process; at worst an
+     * unrelated handle value makes a local port go through the server */
+    move_completion_to_server( source );
+
     SERVER_START_REQ( dup_handle )
     {
         req->src_process = wine_server_obj_handle( source_process );
@@ -371,6 +379,9 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
             {
                 int fd = server_remove_fd_from_cache( source );
                 if (fd != -1) close( fd );
+                remove_fast_sync_from_cache( source );
+                remove_key_values_from_cache( source );
+                close_local_completion( source );
             }
         }
     }
@@ -390,6 +401,9 @@ NTSTATUS close_handle( HANDLE handle )
     NTSTATUS ret;
     int fd = server_remove_fd_from_cache( handle );
 
+    remove_fast_sync_from_cache( handle );
+    remove_key_values_from_cache( handle );
+    close_local_completion( handle );
     SERVER_START_REQ( close_handle )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -31,7 +31,12 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -45,6 +50,163 @@ WINE_DEFAULT_DEBUG_CHANNEL(reg);
 /* maximum length of a value name in bytes (without terminating null) */
 #define MAX_VALUE_LENGTH (16383 * sizeof(WCHAR))
 
+/* cache of recently queried values, validated against the server generation counters */
+
+#define VALUE_CACHE_SIZE      256   /* number of cache entries, must be a power of two */
+#define VALUE_CACHE_MAX_DATA  1024  /* max. data size of a cached value */
+
+struct cached_value
+{
+    HANDLE         key;         /* key handle */
+    unsigned int   gen_index;   /* index of the generation counter of the key */
+    unsigned int   generation;  /* key generation when the value was retrieved */
+    unsigned int   global_gen;  /* global generation when the value was retrieved */
+    NTSTATUS       status;      /* status of the query */
+    int            type;        /* value type */
+    data_size_t    len;         /* length of the value data */
+    unsigned short name_len;    /* length of the value name in bytes */
+    WCHAR         *name;        /* value name, stored after the data */
+    BYTE           data[1];     /* value data */
+};
+
+static RTL_CRITICAL_SECTION value_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG value_cache_section_debug =
+{
+    0, 0, &value_cache_section,
+    { &value_cache_section_debug.ProcessLocksList, &value_cache_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": value_cache_section") }
+};
+static RTL_CRITICAL_SECTION value_cache_section = { &value_cache_section_debug, -1, 0, 0, 0, 0 };
+
+static int value_cache_enabled = -1;
+static const volatile unsigned int *generations;
+static struct cached_value *value_cache[VALUE_CACHE_SIZE];
+static unsigned int value_cache_count;
+
+/* map the generation counters on first use */
+static BOOL init_value_cache(void)
+{
+    const char *env;
+    obj_handle_t fd_handle;
+    void *ptr;
+    int fd, enabled = 0;
+
+    if (value_cache_enabled != -1) return value_cache_enabled;
+
+    RtlEnterCriticalSection( &value_cache_section );
+    if (value_cache_enabled == -1)
+    {
+        if ((env = getenv( "WINEREGISTRYCACHE" )) && atoi( env ))
+        {
+            SERVER_START_REQ( get_registry_generations )
+            {
+                if (!wine_server_call( req ) && (fd = server_receive_fd( &fd_handle )) != -1)
+                {
+                    ptr = mmap( NULL, reply->size, PROT_READ, MAP_SHARED, fd, 0 );
+                    close( fd );
+                    if (ptr != MAP_FAILED && reply->size >= REGISTRY_GENERATIONS * sizeof(*generations))
+                    {
+                        generations = ptr;
+                        enabled = 1;
+                    }
+                }
+            }
+            SERVER_END_REQ;
+        }
+        value_cache_enabled = enabled;
+    }
+    RtlLeaveCriticalSection( &value_cache_section );
+    return value_cache_enabled;
+}
+
+static unsigned int value_cache_hash( HANDLE key, const UNICODE_STRING *name )
+{
+    unsigned int i, hash = (ULONG_PTR)key >> 2;
+
+    for (i = 0; i < name->Length / sizeof(WCHAR); i++) hash = hash * 31 + tolowerW( name->Buffer[i] );
+    return hash & (VALUE_CACHE_SIZE - 1);
+}
+
+/* look for a value in the cache; data is copied up to the buffer size, like the server does */
+static BOOL get_cached_value( HANDLE key, const UNICODE_STRING *name, NTSTATUS *status, int *type,
+                              void *data, DWORD size, data_size_t *len )
+{
+    struct cached_value *value;
+    BOOL ret = FALSE;
+
+    if (!init_value_cache()) return FALSE;
+
+    RtlEnterCriticalSection( &value_cache_section );
+    value = value_cache[value_cache_hash( key, name )];
+    if (value && value->key == key && value->name_len == name->Length &&
+        !memicmpW( value->name, name->Buffer, name->Length / sizeof(WCHAR) ) &&
+        generations[value->gen_index] == value->generation && generations[0] == value->global_gen)
+    {
+        *status = value->status;
+        *type   = value->type;
+        *len    = value->len;
+        if (data) memcpy( data, value->data, min( size, value->len ));
+        ret = TRUE;
+    }
+    RtlLeaveCriticalSection( &value_cache_section );
+    return ret;
+}
+
+/* store the result of a value query in the cache */
+static void cache_value( HANDLE key, const UNICODE_STRING *name, NTSTATUS status, int type,
+                         const void *data, data_size_t len, unsigned int gen_index,
+                         unsigned int generation, unsigned int global_gen )
+{
+    struct cached_value *value, *old;
+    unsigned int hash;
+
+    if (!value_cache_enabled || !gen_index || gen_index >= REGISTRY_GENERATIONS) return;
+    if (len > VALUE_CACHE_MAX_DATA) return;
+    if (!(value = RtlAllocateHeap( GetProcessHeap(), 0, FIELD_OFFSET( struct cached_value, data[len] ) +
+                                   name->Length + sizeof(WCHAR) )))
+        return;
+    value->key        = key;
+    value->gen_index  = gen_index;
+    value->generation = generation;
+    value->global_gen = global_gen;
+    value->status     = status;
+    value->type       = type;
+    value->len        = len;
+    value->name_len   = name->Length;
+    value->name       = (WCHAR *)(((ULONG_PTR)(value->data + len) + 1) & ~1);
+    if (len) memcpy( value->data, data, len );
+    memcpy( value->name, name->Buffer, name->Length );
+
+    hash = value_cache_hash( key, name );
+    RtlEnterCriticalSection( &value_cache_section );
+    if (!(old = value_cache[hash])) value_cache_count++;
+    value_cache[hash] = value;
+    RtlLeaveCriticalSection( &value_cache_section );
+    RtlFreeHeap( GetProcessHeap(), 0, old );
+}
+
+/***********************************************************************
+ *           remove_key_values_from_cache
+ *
+ * Remove the cached values of a key handle that is being closed.
+ */
+void remove_key_values_from_cache( HANDLE handle )
+{
+    unsigned int i;
+
+    if (!value_cache_count) return;
+
+    RtlEnterCriticalSection( &value_cache_section );
+    for (i = 0; i < VALUE_CACHE_SIZE; i++)
+    {
+        if (!value_cache[i] || value_cache[i]->key != handle) continue;
+        RtlFreeHeap( GetProcessHeap(), 0, value_cache[i] );
+        value_cache[i] = NULL;
+        value_cache_count--;
+    }
+    RtlLeaveCriticalSection( &value_cache_section );
+}
+
 /******************************************************************************
  * NtCreateKey [NTDLL.@]
  * ZwCreateKey [NTDLL.@]
@@ -537,6 +699,8 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
     NTSTATUS ret;
     UCHAR *data_ptr;
     unsigned int fixed_size, min_size;
+    data_size_t total;
+    int type;
 
     TRACE( "(%p,%s,%d,%p,%d)\n", handle, debugstr_us(name), info_class, info, length );
 
@@ -574,21 +738,35 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
         return STATUS_INVALID_PARAMETER;
     }
 
-    SERVER_START_REQ( get_key_value )
+    if (get_cached_value( handle, name, &ret, &type, data_ptr,
+                          length > fixed_size ? length - fixed_size : 0, &total ))
     {
-        req->hkey = wine_server_obj_handle( handle );
-        wine_server_add_data( req, name->Buffer, name->Length );
-        if (length > fixed_size && data_ptr) wine_server_set_reply( req, data_ptr, length - fixed_size );
-        if (!(ret = wine_server_call( req )))
+        if (ret) return ret;
+    }
+    else
+    {
+        SERVER_START_REQ( get_key_value )
         {
-            copy_key_value_info( info_class, info, length, reply->type,
-                                 name->Length, reply->total );
-            *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : reply->total);
-            if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
-            else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
+            req->hkey = wine_server_obj_handle( handle );
+            wine_server_add_data( req, name->Buffer, name->Length );
+            if (length > fixed_size && data_ptr) wine_server_set_reply( req, data_ptr, length - fixed_size );
+            ret = wine_server_call( req );
+            type  = reply->type;
+            total = reply->total;
+            /* only cache values whose data we have received entirely */
+            if (ret == STATUS_OBJECT_NAME_NOT_FOUND ||
+                (!ret && data_ptr && wine_server_reply_size( reply ) == total))
+                cache_value( handle, name, ret, type, data_ptr, ret ? 0 : total,
+                             reply->gen_index, reply->generation, reply->global_gen );
         }
+        SERVER_END_REQ;
+        if (ret) return ret;
     }
-    SERVER_END_REQ;
+
+    copy_key_value_info( info_class, info, length, type, name->Length, total );
+    *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : total);
+    if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
+    else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
     return ret;
 }
 
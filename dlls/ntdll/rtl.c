@@ -511,8 +511,19 @@ VOID WINAPI RtlZeroMemory( VOID *Destination, SIZE_T Length )
  */
 SIZE_T WINAPI RtlCompareMemory( const VOID *Source1, const VOID *Source2, SIZE_T Length)
 {
-    SIZE_T i;
-    for(i=0; (i<Length) && (((const BYTE*)Source1)[i]==((const BYTE*)Source2)[i]); i++);
+    const BYTE *s1 = Source1, *s2 = Source2;
+    SIZE_T i = 0, w1, w2;
+
+    /* skip identical blocks with memcmp, which the C library already vectorizes */
+    while (Length - i >= 64 && !memcmp( s1 + i, s2 + i, 64 )) i += 64;
+    /* then locate the differing word, and finally the differing byte */
+    for ( ; Length - i >= sizeof(SIZE_T); i += sizeof(SIZE_T))
+    {
+        memcpy( &w1, s1 + i, sizeof(w1) );
+        memcpy( &w2, s2 + i, sizeof(w2) );
+        if (w1 != w2) break;
+    }
+    while (i < Length && s1[i] == s2[i]) i++;
     return i;
 }
 
@@ -445,7 +445,8 @@ LONG WINAPI RtlCompareString( const STRING *s1, const STRING *s2, BOOLEAN CaseIn
     }
     else
     {
-        while (!ret && len--) ret = *p1++ - *p2++;
+        unsigned int pos = RtlCompareMemory( p1, p2, len );
+        if (pos < len) ret = p1[pos] - p2[pos];
     }
     if (!ret) ret = s1->Length - s2->Length;
     return ret;
@@ -463,11 +464,22 @@ LONG WINAPI RtlCompareUnicodeStrings( const WCHAR *s1, SIZE_T len1, const WCHAR
 
     if (case_insensitive)
     {
-        while (!ret && len--) ret = toupperW(*s1++) - toupperW(*s2++);
+        while (!ret && len)
+        {
+            /* identical characters compare equal in any case, skip them in bulk */
+            SIZE_T same = RtlCompareMemory( s1, s2, len * sizeof(WCHAR) ) / sizeof(WCHAR);
+            s1 += same;
+            s2 += same;
+            len -= same;
+            if (!len) break;
+            ret = toupperW(*s1++) - toupperW(*s2++);
+            len--;
+        }
     }
     else
     {
-        while (!ret && len--) ret = *s1++ - *s2++;
+        SIZE_T pos = RtlCompareMemory( s1, s2, len * sizeof(WCHAR) ) / sizeof(WCHAR);
+        if (pos < len) ret = s1[pos] - s2[pos];
     }
     if (!ret) ret = len1 - len2;
     return ret;
@@ -541,11 +553,7 @@ BOOLEAN WINAPI RtlPrefixString( const STRING *s1, const STRING *s2, BOOLEAN igno
         for (i = 0; i < s1->Length; i++)
             if (RtlUpperChar(s1->Buffer[i]) != RtlUpperChar(s2->Buffer[i])) return FALSE;
     }
-    else
-    {
-        for (i = 0; i < s1->Length; i++)
-            if (s1->Buffer[i] != s2->Buffer[i]) return FALSE;
-    }
+    else if (RtlCompareMemory( s1->Buffer, s2->Buffer, s1->Length ) != s1->Length) return FALSE;
     return TRUE;
 }
 
@@ -567,11 +575,7 @@ BOOLEAN WINAPI RtlPrefixUnicodeString( const UNICODE_STRING *s1,
         for (i = 0; i < s1->Length / sizeof(WCHAR); i++)
             if (toupperW(s1->Buffer[i]) != toupperW(s2->Buffer[i])) return FALSE;
     }
-    else
-    {
-        for (i = 0; i < s1->Length / sizeof(WCHAR); i++)
-            if (s1->Buffer[i] != s2->Buffer[i]) return FALSE;
-    }
+    else if (RtlCompareMemory( s1->Buffer, s2->Buffer, s1->Length ) < (s1->Length & ~1)) return FALSE;
     return TRUE;
 }
 
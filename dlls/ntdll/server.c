@@ -326,6 +326,134 @@ unsigned int wine_server_call( void *req_ptr )
 }
 
 
+/***********************************************************************
+ *           send_batch
+ *
+ * Send a batch of requests to the server; helper for wine_server_call_batch.
+ */
+static unsigned int send_batch( struct __server_request_info **reqs, unsigned int count )
+{
+    static const char padding[8];
+    struct iovec vec[1 + __SERVER_MAX_BATCH * (__SERVER_MAX_DATA + 2)];
+    union generic_request batch;
+    unsigned int i, j, nb_vec = 1;
+    data_size_t size, total = 0, reply_size = 0;
+    int ret;
+
+    for (i = 0; i < count; i++)
+    {
+        struct __server_request_info *req = reqs[i];
+
+        vec[nb_vec].iov_base = (void *)&req->u.req;
+        vec[nb_vec++].iov_len = sizeof(req->u.req);
+        for (j = 0; j < req->data_count; j++)
+        {
+            vec[nb_vec].iov_base = (void *)req->data[j].ptr;
+            vec[nb_vec++].iov_len = req->data[j].size;
+        }
+        if ((size = -req->u.req.request_header.request_size & 7))
+        {
+            vec[nb_vec].iov_base = (void *)padding;
+            vec[nb_vec++].iov_len = size;
+        }
+        total += sizeof(req->u.req) + ((req->u.req.request_header.request_size + 7) & ~7);
+        reply_size += sizeof(req->u.reply) + ((req->u.req.request_header.reply_size + 7) & ~7);
+    }
+
+    memset( &batch, 0, sizeof(batch) );
+    batch.request_header.req = REQ_batch;
+    batch.request_header.request_size = total;
+    batch.request_header.reply_size = reply_size;
+    vec[0].iov_base = &batch;
+    vec[0].iov_len = sizeof(batch);
+
+    if ((ret = writev( ntdll_get_thread_data()->request_fd, vec, nb_vec )) ==
+        total + sizeof(batch)) return STATUS_SUCCESS;
+
+    if (ret >= 0) server_protocol_error( "partial write %d\n", ret );
+    if (errno == EPIPE) abort_thread(0);
+    if (errno == EFAULT) return STATUS_ACCESS_VIOLATION;
+    server_protocol_perror( "write" );
+}
+
+
+/***********************************************************************
+ *           wait_batch_reply
+ *
+ * Wait for the replies to a batch; helper for wine_server_call_batch.
+ */
+static unsigned int wait_batch_reply( struct __server_request_info **reqs, unsigned int count )
+{
+    union generic_reply batch;
+    char padding[8];
+    unsigned int i;
+    data_size_t size;
+
+    read_reply_data( &batch, sizeof(batch) );
+    if (batch.reply_header.error) return batch.reply_header.error;
+    if (batch.batch_reply.count != count)
+        server_protocol_error( "got %u replies for a batch of %u\n", batch.batch_reply.count, count );
+
+    for (i = 0; i < count; i++)
+    {
+        read_reply_data( &reqs[i]->u.reply, sizeof(reqs[i]->u.reply) );
+        if (!(size = reqs[i]->u.reply.reply_header.reply_size)) continue;
+        read_reply_data( reqs[i]->reply_data, size );
+        if ((size = -size & 7)) read_reply_data( padding, size );
+    }
+    return STATUS_SUCCESS;
+}
+
+
+/***********************************************************************
+ *           wine_server_call_batch (NTDLL.@)
+ *
+ * Perform several server calls in a single round trip.
+ *
+ * PARAMS
+ *     reqs  [I/O] Array of request pointers, filled as for wine_server_call
+ *     count [I]   Number of requests, at most __SERVER_MAX_BATCH
+ *
+ * RETURNS
+ *     STATUS_SUCCESS if the requests have been executed, in which case the
+ *     result of each request is in its own reply header. Otherwise none of
+ *     them has been executed.
+ *
+ * NOTES
+ *     The requests are executed in order, and only the requests declared
+ *     as batchable in protocol.def are allowed. E.g:
+ *|     void *batch[2];
+ *|     SERVER_START_REQ( get_window_info )
+ *|     {
+ *|         req->handle = wine_server_user_handle( hwnd );
+ *|         batch[0] = req;
+ *|         SERVER_START_REQ( get_window_text )
+ *|         {
+ *|             req->handle = wine_server_user_handle( hwnd );
+ *|             wine_server_set_reply( req, text, size );
+ *|             batch[1] = req;
+ *|             if (!wine_server_call_batch( batch, 2 ) && !reply->__header.error) ...
+ *|         }
+ *|         SERVER_END_REQ;
+ *|     }
+ *|     SERVER_END_REQ;
+ */
+unsigned int CDECL wine_server_call_batch( void **reqs, unsigned int count )
+{
+    sigset_t old_set;
+    unsigned int ret;
+
+    if (!count) return STATUS_SUCCESS;
+    if (count > __SERVER_MAX_BATCH) return STATUS_INVALID_PARAMETER;
+
+    pthread_sigmask( SIG_BLOCK, &server_block_set, &old_set );
+    if (!(ret = send_batch( (struct __server_request_info **)reqs, count )))
+        ret = wait_batch_reply( (struct __server_request_info **)reqs, count );
+    pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+    return ret;
+}
+
+
 /***********************************************************************
  *           server_enter_uninterrupted_section
  */
@@ -748,11 +876,11 @@ void CDECL wine_server_send_fd( int fd )
 
 
 /***********************************************************************
- *           receive_fd
+ *           server_receive_fd
  *
  * Receive a file descriptor passed from the server.
  */
-static int receive_fd( obj_handle_t *handle )
+int server_receive_fd( obj_handle_t *handle )
 {
     struct iovec vec;
     struct msghdr msghdr;
@@ -818,7 +946,8 @@ union fd_cache_entry
         int fd;
         enum server_fd_type type : 5;
         unsigned int        access : 3;
-        unsigned int        options : 24;
+        unsigned int        options : 23;  /* FILE_OPEN_FOR_FREE_SPACE_QUERY is not cached */
+        unsigned int        skip_completion : 1;
     } s;
 };
 
@@ -844,7 +973,7 @@ static inline unsigned int handle_to_index( HANDLE handle, unsigned int *entry )
  * Caller must hold fd_cache_section.
  */
 static BOOL add_fd_to_cache( HANDLE handle, int fd, enum server_fd_type type,
-                            unsigned int access, unsigned int options )
+                            unsigned int access, unsigned int options, unsigned int comp_flags )
 {
     unsigned int entry, idx = handle_to_index( handle, &entry );
     union fd_cache_entry cache;
@@ -872,6 +1001,7 @@ static BOOL add_fd_to_cache( HANDLE handle, int fd, enum server_fd_type type,
     cache.s.type = type;
     cache.s.access = access;
     cache.s.options = options;
+    cache.s.skip_completion = !!(comp_flags & FILE_SKIP_COMPLETION_PORT_ON_SUCCESS);
     cache.data = interlocked_xchg64( &fd_cache[entry][idx].data, cache.data );
     assert( !cache.s.fd );
     return TRUE;
@@ -922,6 +1052,44 @@ int server_remove_fd_from_cache( HANDLE handle )
 }
 
 
+/***********************************************************************
+ *           server_fd_skips_completion
+ *
+ * Check whether a synchronously completed I/O on the handle doesn't queue a completion.
+ * This is only known for handles in the fd cache; the flag can never be cleared.
+ */
+BOOL server_fd_skips_completion( HANDLE handle )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    union fd_cache_entry cache;
+
+    if (entry >= FD_CACHE_ENTRIES || !fd_cache[entry]) return FALSE;
+    cache.data = interlocked_cmpxchg64( &fd_cache[entry][idx].data, 0, 0 );
+    return cache.s.type != FD_TYPE_INVALID && cache.s.skip_completion;
+}
+
+
+/***********************************************************************
+ *           server_set_fd_skip_completion
+ *
+ * Record in the fd cache that FILE_SKIP_COMPLETION_PORT_ON_SUCCESS was set on the handle.
+ */
+void server_set_fd_skip_completion( HANDLE handle )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    union fd_cache_entry cache, new_cache;
+
+    if (entry >= FD_CACHE_ENTRIES || !fd_cache[entry]) return;
+    do
+    {
+        cache.data = interlocked_cmpxchg64( &fd_cache[entry][idx].data, 0, 0 );
+        if (!cache.data || cache.s.type == FD_TYPE_INVALID) return;
+        new_cache = cache;
+        new_cache.s.skip_completion = 1;
+    } while (interlocked_cmpxchg64( &fd_cache[entry][idx].data, new_cache.data, cache.data ) != cache.data);
+}
+
+
 /***********************************************************************
  *           server_get_unix_fd
  *
@@ -954,18 +1122,18 @@ int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
                 if (type) *type = reply->type;
                 if (options) *options = reply->options;
                 access = reply->access;
-                if ((fd = receive_fd( &fd_handle )) != -1)
+                if ((fd = server_receive_fd( &fd_handle )) != -1)
                 {
                     assert( wine_server_ptr_handle(fd_handle) == handle );
                     *needs_close = (!reply->cacheable ||
-                                    !add_fd_to_cache( handle, fd, reply->type,
-                                                      reply->access, reply->options ));
+                                    !add_fd_to_cache( handle, fd, reply->type, reply->access,
+                                                      reply->options, reply->comp_flags ));
                 }
                 else ret = STATUS_TOO_MANY_OPENED_FILES;
             }
             else if (reply->cacheable)
             {
-                add_fd_to_cache( handle, ret, FD_TYPE_INVALID, 0, 0 );
+                add_fd_to_cache( handle, ret, FD_TYPE_INVALID, 0, 0, 0 );
             }
         }
         SERVER_END_REQ;
@@ -1404,7 +1572,7 @@ void server_init_process(void)
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
 
     /* receive the first thread request fd on the main socket */
-    ntdll_get_thread_data()->request_fd = receive_fd( &version );
+    ntdll_get_thread_data()->request_fd = server_receive_fd( &version );
 
 #ifdef SO_PASSCRED
     /* now that we hopefully received the server_pid, disable SO_PASSCRED */
@@ -28,6 +28,9 @@
 #include <errno.h>
 #include <limits.h>
 #include <signal.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #ifdef HAVE_SYS_SYSCALL_H
 #include <sys/syscall.h>
 #endif
@@ -58,7 +61,9 @@
 #include "windef.h"
 #include "winternl.h"
 #include "wine/server.h"
+#include "wine/library.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 #include "ntdll_misc.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
@@ -132,6 +137,617 @@ static void timespec_from_timeout( struct timespec *timespec, const LARGE_INTEGE
 }
 #endif
 
+/*
+ *	Fast synchronization objects
+ *
+ * When the server is started with WINEFASTSYNC set, the state of events and
+ * semaphores lives in memory shared with the server. As long as the server
+ * has no thread waiting on an object, it can be signaled and acquired here
+ * with atomic operations; otherwise FAST_SYNC_SERVER_OWNED is set in the
+ * state and we fall back to a server call.
+ *
+ * The slot of a handle is cached along with the slot generation, and the
+ * state is only ever modified together with that generation. The server
+ * changes it when the slot is freed or when another process closes one of
+ * our handles, in which case the cached mapping is dropped and we go back
+ * to the server.
+ */
+
+static RTL_CRITICAL_SECTION fast_sync_section;
+static RTL_CRITICAL_SECTION_DEBUG fast_sync_section_debug =
+{
+    0, 0, &fast_sync_section,
+    { &fast_sync_section_debug.ProcessLocksList, &fast_sync_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": fast_sync_section") }
+};
+static RTL_CRITICAL_SECTION fast_sync_section = { &fast_sync_section_debug, -1, 0, 0, 0, 0 };
+
+static int fast_sync_enabled = -1;
+static struct fast_sync_slot *fast_sync_area;
+static unsigned int fast_sync_area_count;
+
+union fast_sync_cache_entry
+{
+    LONGLONG data;
+    struct
+    {
+        unsigned int index : 16;  /* index of the slot in the shared area */
+        unsigned int type : 4;    /* fast_sync_type + 1, so that 0 can be used as the unset value */
+        unsigned int modify : 1;  /* handle has MODIFY_STATE access */
+        unsigned int wait : 1;    /* handle has SYNCHRONIZE access */
+        unsigned int generation;  /* generation of the slot when it was looked up */
+    } s;
+};
+
+C_ASSERT( sizeof(union fast_sync_cache_entry) == sizeof(LONGLONG) );
+
+/* state and generation of a slot, which are always updated together */
+union fast_sync_value
+{
+    LONGLONG data;
+    struct
+    {
+        int          state;
+        unsigned int generation;
+    } s;
+};
+
+C_ASSERT( FIELD_OFFSET( struct fast_sync_slot, generation ) == FIELD_OFFSET( struct fast_sync_slot, state ) + sizeof(int) );
+
+#define FAST_SYNC_CACHE_BLOCK_SIZE  (65536 / sizeof(union fast_sync_cache_entry))
+#define FAST_SYNC_CACHE_ENTRIES     256
+
+static union fast_sync_cache_entry *fast_sync_cache[FAST_SYNC_CACHE_ENTRIES];
+
+static inline unsigned int fast_sync_handle_to_index( HANDLE handle, unsigned int *entry )
+{
+    unsigned int idx = (wine_server_obj_handle(handle) >> 2) - 1;
+    *entry = idx / FAST_SYNC_CACHE_BLOCK_SIZE;
+    return idx % FAST_SYNC_CACHE_BLOCK_SIZE;
+}
+
+static inline LONGLONG read_fast_sync_data( LONGLONG *ptr )
+{
+#ifdef _WIN64
+    return *(volatile LONGLONG *)ptr;
+#else
+    return interlocked_cmpxchg64( ptr, 0, 0 );
+#endif
+}
+
+/* map the shared area on first use */
+static BOOL init_fast_sync(void)
+{
+    const char *env;
+    obj_handle_t fd_handle;
+    sigset_t sigset;
+    void *ptr;
+    int fd, enabled = 0;
+
+    if (fast_sync_enabled != -1) return fast_sync_enabled;
+
+    server_enter_uninterrupted_section( &fast_sync_section, &sigset );
+    if (fast_sync_enabled == -1)
+    {
+        if ((env = getenv( "WINEFASTSYNC" )) && atoi( env ))
+        {
+            SERVER_START_REQ( get_fast_sync_area )
+            {
+                if (!wine_server_call( req ) && (fd = server_receive_fd( &fd_handle )) != -1)
+                {
+                    ptr = mmap( NULL, reply->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+                    close( fd );
+                    if (ptr != MAP_FAILED)
+                    {
+                        fast_sync_area = ptr;
+                        fast_sync_area_count = min( reply->size / sizeof(*fast_sync_area), 65536 );
+                        enabled = 1;
+                    }
+                }
+            }
+            SERVER_END_REQ;
+        }
+        interlocked_xchg( &fast_sync_enabled, enabled );
+    }
+    server_leave_uninterrupted_section( &fast_sync_section, &sigset );
+    return fast_sync_enabled;
+}
+
+/* retrieve the shared slot of an object, if the handle has the needed access */
+static struct fast_sync_slot *get_fast_sync( HANDLE handle, BOOL modify, enum fast_sync_type *type,
+                                             unsigned int *generation )
+{
+    unsigned int entry, idx = fast_sync_handle_to_index( handle, &entry );
+    union fast_sync_cache_entry cache;
+    NTSTATUS ret;
+
+    if (!init_fast_sync() || entry >= FAST_SYNC_CACHE_ENTRIES) return NULL;
+
+    if (!fast_sync_cache[entry])  /* do we need to allocate a new block of entries? */
+    {
+        void *ptr = wine_anon_mmap( NULL, FAST_SYNC_CACHE_BLOCK_SIZE * sizeof(union fast_sync_cache_entry),
+                                    PROT_READ | PROT_WRITE, 0 );
+        if (ptr == MAP_FAILED) return NULL;
+        if (interlocked_cmpxchg_ptr( (void **)&fast_sync_cache[entry], ptr, NULL ))
+            munmap( ptr, FAST_SYNC_CACHE_BLOCK_SIZE * sizeof(union fast_sync_cache_entry) );
+    }
+
+    cache.data = read_fast_sync_data( &fast_sync_cache[entry][idx].data );
+    if (!cache.data)
+    {
+        SERVER_START_REQ( get_fast_sync_obj )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            if (!(ret = wine_server_call( req )))
+            {
+                if (reply->type == FAST_SYNC_NONE || reply->index >= fast_sync_area_count)
+                    cache.s.type = FAST_SYNC_NONE + 1;
+                else
+                {
+                    cache.s.type       = reply->type + 1;
+                    cache.s.index      = reply->index;
+                    cache.s.modify     = !!(reply->access & EVENT_MODIFY_STATE);
+                    cache.s.wait       = !!(reply->access & SYNCHRONIZE);
+                    cache.s.generation = reply->generation;
+                }
+            }
+        }
+        SERVER_END_REQ;
+        if (ret) return NULL;
+        interlocked_cmpxchg64( &fast_sync_cache[entry][idx].data, cache.data, 0 );
+    }
+
+    if (cache.s.type == FAST_SYNC_NONE + 1) return NULL;
+    if (modify ? !cache.s.modify : !cache.s.wait) return NULL;
+    *type = cache.s.type - 1;
+    *generation = cache.s.generation;
+    return &fast_sync_area[cache.s.index];
+}
+
+/***********************************************************************
+ *           remove_fast_sync_from_cache
+ */
+void remove_fast_sync_from_cache( HANDLE handle )
+{
+    unsigned int entry, idx = fast_sync_handle_to_index( handle, &entry );
+    LONGLONG data;
+
+    if (entry < FAST_SYNC_CACHE_ENTRIES && fast_sync_cache[entry])
+    {
+        LONGLONG *ptr = &fast_sync_cache[entry][idx].data;
+
+        do data = read_fast_sync_data( ptr );
+        while (interlocked_cmpxchg64( ptr, 0, data ) != data);
+    }
+}
+
+/* read the state of a slot; fails if the cached mapping of the handle is stale */
+static BOOL read_fast_sync_state( HANDLE handle, struct fast_sync_slot *slot,
+                                  unsigned int generation, int *state )
+{
+    union fast_sync_value value;
+
+    value.data = read_fast_sync_data( (LONGLONG *)&slot->state );
+    if (value.s.generation != generation)
+    {
+        remove_fast_sync_from_cache( handle );
+        return FALSE;
+    }
+    *state = value.s.state;
+    return TRUE;
+}
+
+/* replace the state of a slot if neither it nor the generation changed */
+static BOOL update_fast_sync_state( struct fast_sync_slot *slot, unsigned int generation,
+                                    int new_state, int old_state )
+{
+    union fast_sync_value new_value, old_value;
+
+    new_value.s.state = new_state;
+    new_value.s.generation = generation;
+    old_value.s.state = old_state;
+    old_value.s.generation = generation;
+    return interlocked_cmpxchg64( (LONGLONG *)&slot->state, new_value.data, old_value.data ) == old_value.data;
+}
+
+static NTSTATUS fast_set_event( HANDLE handle, int signaled )
+{
+    struct fast_sync_slot *slot;
+    enum fast_sync_type type;
+    unsigned int generation;
+    int state;
+
+    if (!(slot = get_fast_sync( handle, TRUE, &type, &generation ))) return STATUS_NOT_IMPLEMENTED;
+    if (type != FAST_SYNC_MANUAL_EVENT && type != FAST_SYNC_AUTO_EVENT) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        if (!read_fast_sync_state( handle, slot, generation, &state )) return STATUS_NOT_IMPLEMENTED;
+        /* the server has waiters, let it wake them up */
+        if (state & FAST_SYNC_SERVER_OWNED) return STATUS_NOT_IMPLEMENTED;
+    } while (!update_fast_sync_state( slot, generation, signaled, state ));
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS fast_release_semaphore( HANDLE handle, ULONG count, ULONG *previous )
+{
+    struct fast_sync_slot *slot;
+    enum fast_sync_type type;
+    unsigned int generation;
+    int state;
+
+    if (!(slot = get_fast_sync( handle, TRUE, &type, &generation ))) return STATUS_NOT_IMPLEMENTED;
+    if (type != FAST_SYNC_SEMAPHORE) return STATUS_NOT_IMPLEMENTED;
+
+    do
+    {
+        if (!read_fast_sync_state( handle, slot, generation, &state )) return STATUS_NOT_IMPLEMENTED;
+        if (state & FAST_SYNC_SERVER_OWNED) return STATUS_NOT_IMPLEMENTED;
+        if ((unsigned int)state + count < (unsigned int)state || (unsigned int)state + count > slot->max)
+            return STATUS_SEMAPHORE_LIMIT_EXCEEDED;
+    } while (!update_fast_sync_state( slot, generation, state + count, state ));
+
+    if (previous) *previous = state;
+    return STATUS_SUCCESS;
+}
+
+/* try to satisfy a wait without blocking; anything else is left to the server */
+static NTSTATUS fast_wait( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
+                           BOOLEAN alertable, const LARGE_INTEGER *timeout )
+{
+    struct fast_sync_slot *slots[MAXIMUM_WAIT_OBJECTS];
+    enum fast_sync_type types[MAXIMUM_WAIT_OBJECTS];
+    unsigned int generations[MAXIMUM_WAIT_OBJECTS];
+    DWORD i;
+    int state;
+
+    if (!wait_any && count > 1) return STATUS_NOT_IMPLEMENTED;
+
+    for (i = 0; i < count; i++)
+        if (!(slots[i] = get_fast_sync( handles[i], FALSE, &types[i], &generations[i] )))
+            return STATUS_NOT_IMPLEMENTED;
+
+    for (i = 0; i < count; i++)
+    {
+        for (;;)
+        {
+            if (!read_fast_sync_state( handles[i], slots[i], generations[i], &state ))
+                return STATUS_NOT_IMPLEMENTED;
+            /* objects before this one may become signaled in the server, don't skip them */
+            if (state & FAST_SYNC_SERVER_OWNED) return STATUS_NOT_IMPLEMENTED;
+            if (!state) break;
+            if (types[i] == FAST_SYNC_MANUAL_EVENT) return STATUS_WAIT_0 + i;
+            if (update_fast_sync_state( slots[i], generations[i],
+                                        types[i] == FAST_SYNC_SEMAPHORE ? state - 1 : 0, state ))
+                return STATUS_WAIT_0 + i;
+        }
+    }
+
+    /* nothing is signaled; a poll can fail right away unless APCs may have to run */
+    if (!alertable && timeout && !timeout->QuadPart) return STATUS_TIMEOUT;
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+/*
+ *	Process-local completion ports
+ *
+ * When WINELOCALIOCP is set, unnamed and non-inheritable completion ports
+ * queue the packets posted with NtSetIoCompletion in the process, and their
+ * waiters block on a futex. As soon as the port becomes reachable from
+ * outside of this code (a file or job is associated with it, the handle is
+ * duplicated, made inheritable or waited upon, or an alertable wait is
+ * needed), the queued packets are handed to the server object and the port
+ * uses it from then on. Until then the server refuses to duplicate the
+ * handle for other processes, so the port can only be closed from here.
+ */
+
+struct local_completion_msg
+{
+    struct list entry;
+    ULONG_PTR   ckey;
+    ULONG_PTR   cvalue;
+    ULONG_PTR   information;
+    NTSTATUS    status;
+};
+
+struct local_completion
+{
+    struct list          entry;     /* entry in local_completions */
+    HANDLE               handle;
+    LONG                 refcount;
+    RTL_CRITICAL_SECTION cs;
+    struct list          queue;     /* queued packets */
+    ULONG                depth;
+    ULONG                waiters;   /* number of threads waiting on seq */
+    int                  seq;       /* futex, bumped whenever waiters have to recheck the port */
+    BOOL                 server;    /* packets are queued in the server object */
+    BOOL                 closed;
+};
+
+static struct list local_completions = LIST_INIT( local_completions );
+static RTL_SRWLOCK local_completions_lock = RTL_SRWLOCK_INIT;
+static LONG local_completions_count;
+
+static BOOL use_local_completions(void)
+{
+#ifdef __linux__
+    static int enabled = -1;
+    const char *env;
+
+    if (enabled == -1) enabled = (env = getenv( "WINELOCALIOCP" )) && atoi( env ) && use_futexes();
+    return enabled;
+#else
+    return FALSE;
+#endif
+}
+
+static struct local_completion *grab_local_completion( HANDLE handle )
+{
+    struct local_completion *port, *ret = NULL;
+
+    if (!local_completions_count) return NULL;
+
+    RtlAcquireSRWLockShared( &local_completions_lock );
+    LIST_FOR_EACH_ENTRY( port, &local_completions, struct local_completion, entry )
+    {
+        if (port->handle != handle) continue;
+        interlocked_xchg_add( &port->refcount, 1 );
+        ret = port;
+        break;
+    }
+    RtlReleaseSRWLockShared( &local_completions_lock );
+    return ret;
+}
+
+static void release_local_completion( struct local_completion *port )
+{
+    struct local_completion_msg *msg, *next;
+
+    if (interlocked_xchg_add( &port->refcount, -1 ) > 1) return;
+
+    LIST_FOR_EACH_ENTRY_SAFE( msg, next, &port->queue, struct local_completion_msg, entry )
+        RtlFreeHeap( GetProcessHeap(), 0, msg );
+    port->cs.DebugInfo->Spare[0] = 0;
+    RtlDeleteCriticalSection( &port->cs );
+    RtlFreeHeap( GetProcessHeap(), 0, port );
+}
+
+/* wake up the waiters of a port; caller must hold the port section */
+static void wake_local_completion( struct local_completion *port, int count )
+{
+    port->seq++;
+#ifdef __linux__
+    if (port->waiters) futex_wake( &port->seq, count );
+#endif
+}
+
+/* wait until the port sequence changes; caller must not hold the port section */
+static NTSTATUS wait_local_completion( struct local_completion *port, int seq, const LARGE_INTEGER *timeout )
+{
+#ifdef __linux__
+    struct timespec timespec;
+    LARGE_INTEGER now;
+
+    if (timeout)
+    {
+        NtQuerySystemTime( &now );
+        if (timeout->QuadPart <= now.QuadPart) return STATUS_TIMEOUT;
+        timespec_from_timeout( &timespec, timeout );
+    }
+    if (futex_wait( &port->seq, seq, timeout ? &timespec : NULL ) == -1 && errno == ETIMEDOUT)
+        return STATUS_TIMEOUT;
+#endif
+    return STATUS_SUCCESS;
+}
+
+static void create_local_completion( HANDLE handle )
+{
+    struct local_completion *port;
+
+    if (!(port = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*port) )))
+    {
+        /* use the server object, which then has to be shareable */
+        SERVER_START_REQ( share_completion )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            wine_server_call( req );
+        }
+        SERVER_END_REQ;
+        return;
+    }
+    port->handle = handle;
+    port->refcount = 1;
+    list_init( &port->queue );
+    RtlInitializeCriticalSection( &port->cs );
+    port->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": local_completion.cs");
+
+    RtlAcquireSRWLockExclusive( &local_completions_lock );
+    list_add_tail( &local_completions, &port->entry );
+    local_completions_count++;
+    RtlReleaseSRWLockExclusive( &local_completions_lock );
+}
+
+/***********************************************************************
+ *           move_completion_to_server
+ *
+ * Hand the queued packets of a process-local port to the server object,
+ * which is used for all further operations on the port.
+ */
+void move_completion_to_server( HANDLE handle )
+{
+    struct local_completion *port;
+    struct local_completion_msg *msg, *next;
+
+    if (!(port = grab_local_completion( handle ))) return;
+
+    RtlEnterCriticalSection( &port->cs );
+    if (!port->server && !port->closed)
+    {
+        TRACE( "port %p, %u packets\n", handle, port->depth );
+        LIST_FOR_EACH_ENTRY_SAFE( msg, next, &port->queue, struct local_completion_msg, entry )
+        {
+            SERVER_START_REQ( add_completion )
+            {
+                req->handle      = wine_server_obj_handle( handle );
+                req->ckey        = msg->ckey;
+                req->cvalue      = msg->cvalue;
+                req->status      = msg->status;
+                req->information = msg->information;
+                wine_server_call( req );
+            }
+            SERVER_END_REQ;
+            list_remove( &msg->entry );
+            RtlFreeHeap( GetProcessHeap(), 0, msg );
+        }
+        SERVER_START_REQ( share_completion )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            wine_server_call( req );
+        }
+        SERVER_END_REQ;
+        port->depth = 0;
+        port->server = TRUE;
+        wake_local_completion( port, INT_MAX );
+    }
+    RtlLeaveCriticalSection( &port->cs );
+    release_local_completion( port );
+}
+
+/***********************************************************************
+ *           close_local_completion
+ *
+ * Forget about a port handle that is being closed.
+ */
+void close_local_completion( HANDLE handle )
+{
+    struct local_completion *port;
+
+    if (!local_completions_count) return;
+
+    RtlAcquireSRWLockExclusive( &local_completions_lock );
+    LIST_FOR_EACH_ENTRY( port, &local_completions, struct local_completion, entry )
+    {
+        if (port->handle != handle) continue;
+        list_remove( &port->entry );
+        local_completions_count--;
+        RtlReleaseSRWLockExclusive( &local_completions_lock );
+
+        RtlEnterCriticalSection( &port->cs );
+        port->closed = TRUE;
+        wake_local_completion( port, INT_MAX );
+        RtlLeaveCriticalSection( &port->cs );
+        release_local_completion( port );
+        return;
+    }
+    RtlReleaseSRWLockExclusive( &local_completions_lock );
+}
+
+static NTSTATUS fast_add_completion( HANDLE handle, ULONG_PTR key, ULONG_PTR value,
+                                     NTSTATUS status, SIZE_T information )
+{
+    struct local_completion *port;
+    struct local_completion_msg *msg;
+    NTSTATUS ret = STATUS_NOT_IMPLEMENTED;
+
+    if (!(port = grab_local_completion( handle ))) return STATUS_NOT_IMPLEMENTED;
+
+    if ((msg = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*msg) )))
+    {
+        msg->ckey        = key;
+        msg->cvalue      = value;
+        msg->status      = status;
+        msg->information = information;
+
+        RtlEnterCriticalSection( &port->cs );
+        if (!port->server && !port->closed)
+        {
+            list_add_tail( &port->queue, &msg->entry );
+            port->depth++;
+            wake_local_completion( port, 1 );
+            ret = STATUS_SUCCESS;
+        }
+        RtlLeaveCriticalSection( &port->cs );
+        if (ret) RtlFreeHeap( GetProcessHeap(), 0, msg );
+    }
+    release_local_completion( port );
+    return ret;
+}
+
+static NTSTATUS fast_remove_completion( HANDLE handle, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
+                                        ULONG *written, const LARGE_INTEGER *timeout, BOOLEAN alertable )
+{
+    struct local_completion *port;
+    struct local_completion_msg *msg;
+    struct list *entry;
+    LARGE_INTEGER end;
+    NTSTATUS ret;
+    ULONG i = 0;
+    BOOL timed_out = FALSE;
+    int seq;
+
+    if (!(port = grab_local_completion( handle ))) return STATUS_NOT_IMPLEMENTED;
+
+    if (timeout && timeout->QuadPart < 0)
+    {
+        NtQuerySystemTime( &end );
+        end.QuadPart -= timeout->QuadPart;
+        timeout = &end;
+    }
+
+    for (;;)
+    {
+        RtlEnterCriticalSection( &port->cs );
+        if (port->server) ret = STATUS_NOT_IMPLEMENTED;
+        else if (port->closed) ret = STATUS_ABANDONED_WAIT_0;
+        else
+        {
+            while (i < count && (entry = list_head( &port->queue )))
+            {
+                msg = LIST_ENTRY( entry, struct local_completion_msg, entry );
+                info[i].CompletionKey             = msg->ckey;
+                info[i].CompletionValue           = msg->cvalue;
+                info[i].IoStatusBlock.Information = msg->information;
+                info[i].IoStatusBlock.u.Status    = msg->status;
+                list_remove( &msg->entry );
+                RtlFreeHeap( GetProcessHeap(), 0, msg );
+                port->depth--;
+                i++;
+            }
+            ret = i ? STATUS_SUCCESS : STATUS_PENDING;
+            /* pass on a wakeup we may have consumed on behalf of the remaining packets */
+            if (i && port->depth) wake_local_completion( port, 1 );
+        }
+        if (ret == STATUS_PENDING && !timed_out && !alertable) port->waiters++;
+        seq = port->seq;
+        RtlLeaveCriticalSection( &port->cs );
+
+        if (ret != STATUS_PENDING) break;
+        if (timed_out)
+        {
+            ret = STATUS_TIMEOUT;
+            break;
+        }
+        if (alertable)
+        {
+            /* user APCs are delivered by the server */
+            move_completion_to_server( handle );
+            ret = STATUS_NOT_IMPLEMENTED;
+            break;
+        }
+
+        /* check the queue once more after a timeout, in case we consumed a wakeup */
+        timed_out = wait_local_completion( port, seq, timeout ) == STATUS_TIMEOUT;
+
+        RtlEnterCriticalSection( &port->cs );
+        port->waiters--;
+        RtlLeaveCriticalSection( &port->cs );
+    }
+
+    release_local_completion( port );
+    *written = i;
+    return ret;
+}
+
 /* creates a struct security_descriptor and contained information in one contiguous piece of memory */
 NTSTATUS alloc_object_attributes( const OBJECT_ATTRIBUTES *attr, struct object_attributes **ret,
                                   data_size_t *ret_len )
@@ -328,6 +944,10 @@ NTSTATUS WINAPI NtQuerySemaphore( HANDLE handle, SEMAPHORE_INFORMATION_CLASS cla
 NTSTATUS WINAPI NtReleaseSemaphore( HANDLE handle, ULONG count, PULONG previous )
 {
     NTSTATUS ret;
+
+    if ((ret = fast_release_semaphore( handle, count, previous )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     SERVER_START_REQ( release_semaphore )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -408,6 +1028,8 @@ NTSTATUS WINAPI NtSetEvent( HANDLE handle, PULONG NumberOfThreadsReleased )
 
     /* FIXME: set NumberOfThreadsReleased */
 
+    if ((ret = fast_set_event( handle, 1 )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -428,6 +1050,8 @@ NTSTATUS WINAPI NtResetEvent( HANDLE handle, PULONG NumberOfThreadsReleased )
     /* resetting an event can't release any thread... */
     if (NumberOfThreadsReleased) *NumberOfThreadsReleased = 0;
 
+    if ((ret = fast_set_event( handle, 0 )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -462,6 +1086,9 @@ NTSTATUS WINAPI NtPulseEvent( HANDLE handle, PULONG PulseCount )
     if (PulseCount)
       FIXME("(%p,%d)\n", handle, *PulseCount);
 
+    /* without waiters, pulsing is the same as resetting */
+    if ((ret = fast_set_event( handle, 0 )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -804,6 +1431,7 @@ NTSTATUS WINAPI NtSetInformationJobObject( HANDLE handle, JOBOBJECTINFOCLASS cla
         if (len != sizeof(JOBOBJECT_ASSOCIATE_COMPLETION_PORT))
             return STATUS_INVALID_PARAMETER;
 
+        move_completion_to_server( ((JOBOBJECT_ASSOCIATE_COMPLETION_PORT *)info)->CompletionPort );
         SERVER_START_REQ( set_job_completion_port )
         {
             JOBOBJECT_ASSOCIATE_COMPLETION_PORT *port_info = info;
@@ -1084,12 +1712,20 @@ static NTSTATUS wait_objects( DWORD count, const HANDLE *handles,
 {
     select_op_t select_op;
     UINT i, flags = SELECT_INTERRUPTIBLE;
+    NTSTATUS ret;
 
     if (!count || count > MAXIMUM_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
 
+    if ((ret = fast_wait( count, handles, wait_any, alertable, timeout )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.wait.op = wait_any ? SELECT_WAIT : SELECT_WAIT_ALL;
-    for (i = 0; i < count; i++) select_op.wait.handles[i] = wine_server_obj_handle( handles[i] );
+    for (i = 0; i < count; i++)
+    {
+        move_completion_to_server( handles[i] );
+        select_op.wait.handles[i] = wine_server_obj_handle( handles[i] );
+    }
     return server_select( &select_op, offsetof( select_op_t, wait.handles[count] ), flags, timeout );
 }
 
@@ -1126,6 +1762,7 @@ NTSTATUS WINAPI NtSignalAndWaitForSingleObject( HANDLE hSignalObject, HANDLE hWa
     if (!hSignalObject) return STATUS_INVALID_HANDLE;
 
     if (alertable) flags |= SELECT_ALERTABLE;
+    move_completion_to_server( hWaitObject );
     select_op.signal_and_wait.op = SELECT_SIGNAL_AND_WAIT;
     select_op.signal_and_wait.wait = wine_server_obj_handle( hWaitObject );
     select_op.signal_and_wait.signal = wine_server_obj_handle( hSignalObject );
@@ -1293,6 +1930,7 @@ NTSTATUS WINAPI NtCreateIoCompletion( PHANDLE CompletionPort, ACCESS_MASK Desire
     NTSTATUS status;
     data_size_t len;
     struct object_attributes *objattr;
+    BOOL local;
 
     TRACE("(%p, %x, %p, %d)\n", CompletionPort, DesiredAccess, attr, NumberOfConcurrentThreads);
 
@@ -1301,16 +1939,23 @@ NTSTATUS WINAPI NtCreateIoCompletion( PHANDLE CompletionPort, ACCESS_MASK Desire
 
     if ((status = alloc_object_attributes( attr, &objattr, &len ))) return status;
 
+    local = use_local_completions() &&
+            (DesiredAccess & IO_COMPLETION_ALL_ACCESS) == IO_COMPLETION_ALL_ACCESS &&
+            (!attr || (!attr->ObjectName && !(attr->Attributes & OBJ_INHERIT)));
+
     SERVER_START_REQ( create_completion )
     {
         req->access     = DesiredAccess;
         req->concurrent = NumberOfConcurrentThreads;
+        req->local      = local;
         wine_server_add_data( req, objattr, len );
         if (!(status = wine_server_call( req )))
             *CompletionPort = wine_server_ptr_handle( reply->handle );
     }
     SERVER_END_REQ;
 
+    if (!status && local) create_local_completion( *CompletionPort );
+
     RtlFreeHeap( GetProcessHeap(), 0, objattr );
     return status;
 }
@@ -1337,6 +1982,10 @@ NTSTATUS WINAPI NtSetIoCompletion( HANDLE CompletionPort, ULONG_PTR CompletionKe
     TRACE("(%p, %lx, %lx, %x, %lx)\n", CompletionPort, CompletionKey,
           CompletionValue, Status, NumberOfBytesTransferred);
 
+    if ((status = fast_add_completion( CompletionPort, CompletionKey, CompletionValue,
+                                       Status, NumberOfBytesTransferred )) != STATUS_NOT_IMPLEMENTED)
+        return status;
+
     SERVER_START_REQ( add_completion )
     {
         req->handle      = wine_server_obj_handle( CompletionPort );
@@ -1368,11 +2017,25 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE CompletionPort, PULONG_PTR Completi
                                       PULONG_PTR CompletionValue, PIO_STATUS_BLOCK iosb,
                                       PLARGE_INTEGER WaitTime )
 {
+    FILE_IO_COMPLETION_INFORMATION info;
     NTSTATUS status;
+    ULONG count;
 
     TRACE("(%p, %p, %p, %p, %p)\n", CompletionPort, CompletionKey,
           CompletionValue, iosb, WaitTime);
 
+    if ((status = fast_remove_completion( CompletionPort, &info, 1, &count,
+                                          WaitTime, FALSE )) != STATUS_NOT_IMPLEMENTED)
+    {
+        if (!status)
+        {
+            *CompletionKey    = info.CompletionKey;
+            *CompletionValue  = info.CompletionValue;
+            *iosb             = info.IoStatusBlock;
+        }
+        return status;
+    }
+
     for(;;)
     {
         SERVER_START_REQ( remove_completion )
@@ -1407,6 +2070,12 @@ NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE port, FILE_IO_COMPLETION_INFORMAT
 
     TRACE("%p %p %u %p %p %u\n", port, info, count, written, timeout, alertable);
 
+    if ((ret = fast_remove_completion( port, info, count, &i, timeout, alertable )) != STATUS_NOT_IMPLEMENTED)
+    {
+        *written = i ? i : 1;
+        return ret;
+    }
+
     for (;;)
     {
         while (i < count)
@@ -1511,6 +2180,22 @@ NTSTATUS WINAPI NtQueryIoCompletion( HANDLE CompletionPort, IO_COMPLETION_INFORM
                     status = STATUS_INFO_LENGTH_MISMATCH;
                 else
                 {
+                    struct local_completion *port;
+
+                    if ((port = grab_local_completion( CompletionPort )))
+                    {
+                        BOOL local;
+
+                        RtlEnterCriticalSection( &port->cs );
+                        if ((local = !port->server && !port->closed)) *info = port->depth;
+                        RtlLeaveCriticalSection( &port->cs );
+                        release_local_completion( port );
+                        if (local)
+                        {
+                            status = STATUS_SUCCESS;
+                            break;
+                        }
+                    }
                     SERVER_START_REQ( query_completion )
                     {
                         req->handle = wine_server_obj_handle( CompletionPort );
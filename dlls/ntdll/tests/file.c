@@ -1052,6 +1052,93 @@ static void test_set_io_completion(void)
     pNtClose( h );
 }
 
+/* in Wine, WINELOCALIOCP queues the packets of private ports in the process,
+ * they must still be seen through every handle to the port */
+static void test_local_io_completion(void)
+{
+    LARGE_INTEGER timeout = {{0}};
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    HANDLE h, h2, process;
+    NTSTATUS res;
+    DWORD flags;
+    BOOL ret;
+
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+
+    /* duplicated through the current process pseudo-handle */
+    res = pNtSetIoCompletion( h, CKEY_FIRST, CVALUE_FIRST, STATUS_SUCCESS, 1 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ret = DuplicateHandle( GetCurrentProcess(), h, GetCurrentProcess(), &h2, 0, FALSE, DUPLICATE_SAME_ACCESS );
+    ok( ret, "DuplicateHandle failed: %u\n", GetLastError() );
+    ok( get_pending_msgs( h2 ) == 1, "wrong msg count\n" );
+    res = pNtSetIoCompletion( h, CKEY_SECOND, CVALUE_FIRST, STATUS_SUCCESS, 2 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    res = pNtRemoveIoCompletion( h2, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == CKEY_FIRST, "wrong key %#lx\n", key );
+    res = pNtRemoveIoCompletion( h2, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == CKEY_SECOND, "wrong key %#lx\n", key );
+    pNtClose( h2 );
+    pNtClose( h );
+
+    /* duplicated through a real handle to the current process, closing the source */
+    process = OpenProcess( PROCESS_DUP_HANDLE, FALSE, GetCurrentProcessId() );
+    ok( process != NULL, "OpenProcess failed: %u\n", GetLastError() );
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+    res = pNtSetIoCompletion( h, CKEY_FIRST, CVALUE_FIRST, STATUS_SUCCESS, 1 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ret = DuplicateHandle( process, h, process, &h2, 0, FALSE,
+                           DUPLICATE_SAME_ACCESS | DUPLICATE_CLOSE_SOURCE );
+    ok( ret, "DuplicateHandle failed: %u\n", GetLastError() );
+    ok( get_pending_msgs( h2 ) == 1, "wrong msg count\n" );
+    res = pNtRemoveIoCompletion( h2, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == CKEY_FIRST, "wrong key %#lx\n", key );
+    res = pNtRemoveIoCompletion( h2, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_TIMEOUT, "NtRemoveIoCompletion failed: %#x\n", res );
+    pNtClose( h2 );
+    CloseHandle( process );
+
+    /* made inheritable after creation, then duplicated */
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+    res = pNtSetIoCompletion( h, CKEY_FIRST, CVALUE_FIRST, STATUS_SUCCESS, 1 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ret = SetHandleInformation( h, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT );
+    ok( ret, "SetHandleInformation failed: %u\n", GetLastError() );
+    ret = GetHandleInformation( h, &flags );
+    ok( ret && (flags & HANDLE_FLAG_INHERIT), "handle not inheritable\n" );
+    res = pNtSetIoCompletion( h, CKEY_SECOND, CVALUE_FIRST, STATUS_SUCCESS, 2 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ret = DuplicateHandle( GetCurrentProcess(), h, GetCurrentProcess(), &h2, 0, FALSE, DUPLICATE_SAME_ACCESS );
+    ok( ret, "DuplicateHandle failed: %u\n", GetLastError() );
+    ok( get_pending_msgs( h2 ) == 2, "wrong msg count\n" );
+    pNtClose( h2 );
+    pNtClose( h );
+}
+
+static void test_local_io_completion_child(void)
+{
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = { sizeof(si) };
+    char cmdline[MAX_PATH + 32];
+    char **argv;
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" file local_iocp", argv[0] );
+    SetEnvironmentVariableA( "WINELOCALIOCP", "1" );
+    ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi ),
+        "CreateProcess failed: %u\n", GetLastError() );
+    SetEnvironmentVariableA( "WINELOCALIOCP", NULL );
+    winetest_wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+}
+
 static void test_file_io_completion(void)
 {
     static const char pipe_name[] = "\\\\.\\pipe\\iocompletiontestnamedpipe";
@@ -4764,6 +4851,7 @@ static void test_flush_buffers_file(void)
 
 START_TEST(file)
 {
+    char **argv;
     HMODULE hkernel32 = GetModuleHandleA("kernel32.dll");
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
     if (!hntdll)
@@ -4803,6 +4891,12 @@ START_TEST(file)
     pNtQueryFullAttributesFile = (void *)GetProcAddress(hntdll, "NtQueryFullAttributesFile");
     pNtFlushBuffersFile = (void *)GetProcAddress(hntdll, "NtFlushBuffersFile");
 
+    if (winetest_get_mainargs( &argv ) >= 3 && !strcmp( argv[2], "local_iocp" ))
+    {
+        test_local_io_completion();
+        return;
+    }
+
     test_read_write();
     test_NtCreateFile();
     create_file_test();
@@ -4812,6 +4906,8 @@ START_TEST(file)
     append_file_test();
     nt_mailslot_test();
     test_set_io_completion();
+    test_local_io_completion();
+    test_local_io_completion_child();
     test_file_io_completion();
     test_file_basic_information();
     test_file_all_information();
@@ -24,6 +24,7 @@
 #include "stdio.h"
 #include "winnt.h"
 #include "stdlib.h"
+#include "wine/server.h"
 
 static HANDLE   (WINAPI *pCreateWaitableTimerA)(SECURITY_ATTRIBUTES*, BOOL, LPCSTR);
 static BOOLEAN  (WINAPI *pRtlCreateUnicodeStringFromAsciiz)(PUNICODE_STRING, LPCSTR);
@@ -33,6 +34,7 @@ static NTSTATUS (WINAPI *pNtCreateEvent) ( PHANDLE, ACCESS_MASK, const POBJECT_A
 static NTSTATUS (WINAPI *pNtOpenEvent)   ( PHANDLE, ACCESS_MASK, const POBJECT_ATTRIBUTES);
 static NTSTATUS (WINAPI *pNtPulseEvent)  ( HANDLE, PULONG );
 static NTSTATUS (WINAPI *pNtQueryEvent)  ( HANDLE, EVENT_INFORMATION_CLASS, PVOID, ULONG, PULONG );
+static unsigned int (CDECL *pwine_server_call_batch)( void **, unsigned int );
 static NTSTATUS (WINAPI *pNtCreateJobObject)( PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES );
 static NTSTATUS (WINAPI *pNtOpenJobObject)( PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES );
 static NTSTATUS (WINAPI *pNtCreateKey)( PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES, ULONG,
@@ -2113,6 +2115,89 @@ static void test_wait_on_address(void)
     ok(address == 0, "got %s\n", wine_dbgstr_longlong(address));
 }
 
+static void test_server_batch(void)
+{
+    HANDLE event, semaphore;
+    void *batch[__SERVER_MAX_BATCH + 1];
+    unsigned int status, i;
+
+    if (!pwine_server_call_batch)
+    {
+        win_skip( "wine_server_call_batch not supported\n" );
+        return;
+    }
+
+    event = CreateEventA( NULL, TRUE, TRUE, NULL );
+    semaphore = CreateSemaphoreA( NULL, 2, 5, NULL );
+
+    status = pwine_server_call_batch( batch, 0 );
+    ok( !status, "got %#x\n", status );
+
+    /* each request gets its own reply and status */
+    SERVER_START_REQ( query_event )
+    {
+        req->handle = wine_server_obj_handle( event );
+        batch[0] = req;
+        SERVER_START_REQ( query_event )
+        {
+            req->handle = wine_server_obj_handle( (HANDLE)0xdeadbeef );
+            batch[1] = req;
+            SERVER_START_REQ( query_semaphore )
+            {
+                req->handle = wine_server_obj_handle( semaphore );
+                batch[2] = req;
+                status = pwine_server_call_batch( batch, 3 );
+                ok( !status, "got %#x\n", status );
+                ok( !reply->__header.error, "got %#x\n", reply->__header.error );
+                ok( reply->current == 2, "got current %u\n", reply->current );
+                ok( reply->max == 5, "got max %u\n", reply->max );
+            }
+            SERVER_END_REQ;
+            ok( reply->__header.error == STATUS_INVALID_HANDLE, "got %#x\n", reply->__header.error );
+        }
+        SERVER_END_REQ;
+        ok( !reply->__header.error, "got %#x\n", reply->__header.error );
+        ok( reply->manual_reset == 1, "got manual_reset %d\n", reply->manual_reset );
+        ok( reply->state == 1, "got state %d\n", reply->state );
+    }
+    SERVER_END_REQ;
+
+    /* a request that can't be batched fails the whole batch before anything runs */
+    SERVER_START_REQ( query_event )
+    {
+        req->handle = wine_server_obj_handle( event );
+        batch[0] = req;
+        SERVER_START_REQ( event_op )
+        {
+            req->handle = wine_server_obj_handle( event );
+            req->op     = RESET_EVENT;
+            batch[1] = req;
+            status = pwine_server_call_batch( batch, 2 );
+            ok( status == STATUS_INVALID_PARAMETER, "got %#x\n", status );
+        }
+        SERVER_END_REQ;
+    }
+    SERVER_END_REQ;
+    ok( !WaitForSingleObject( event, 0 ), "event was reset\n" );
+
+    /* too many requests */
+    SERVER_START_REQ( query_event )
+    {
+        req->handle = wine_server_obj_handle( event );
+        for (i = 0; i < ARRAY_SIZE(batch); i++) batch[i] = req;
+        status = pwine_server_call_batch( batch, ARRAY_SIZE(batch) );
+        ok( status == STATUS_INVALID_PARAMETER, "got %#x\n", status );
+        status = pwine_server_call_batch( batch, __SERVER_MAX_BATCH );
+        ok( !status, "got %#x\n", status );
+        ok( !reply->__header.error, "got %#x\n", reply->__header.error );
+        ok( reply->state == 1, "got state %d\n", reply->state );
+    }
+    SERVER_END_REQ;
+
+    CloseHandle( event );
+    CloseHandle( semaphore );
+}
+
 START_TEST(om)
 {
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
@@ -2138,6 +2223,7 @@ START_TEST(om)
     pNtCreateMutant         = (void *)GetProcAddress(hntdll, "NtCreateMutant");
     pNtOpenEvent            = (void *)GetProcAddress(hntdll, "NtOpenEvent");
     pNtQueryEvent           = (void *)GetProcAddress(hntdll, "NtQueryEvent");
+    pwine_server_call_batch = (void *)GetProcAddress(hntdll, "wine_server_call_batch");
     pNtPulseEvent           = (void *)GetProcAddress(hntdll, "NtPulseEvent");
     pNtOpenMutant           = (void *)GetProcAddress(hntdll, "NtOpenMutant");
     pNtQueryMutant          = (void *)GetProcAddress(hntdll, "NtQueryMutant");
@@ -2184,4 +2270,5 @@ START_TEST(om)
     test_keyed_events();
     test_null_device();
     test_wait_on_address();
+    test_server_batch();
 }
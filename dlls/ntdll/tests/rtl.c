@@ -198,7 +198,8 @@ static void InitFunctionPtrs(void)
 
 static void test_RtlCompareMemory(void)
 {
-  SIZE_T size;
+  BYTE buf1[300], buf2[300];
+  SIZE_T size, i, j;
 
   if (!pRtlCompareMemory)
   {
@@ -212,6 +213,21 @@ static void test_RtlCompareMemory(void)
   COMP(src,src,LEN,LEN);
   dest[0] = 'x';
   COMP(src,dest,LEN,0);
+
+  /* differences at every position, with misaligned buffers */
+  for (i = 0; i < sizeof(buf1); i++) buf1[i] = buf2[i] = i * 7;
+  for (i = 0; i < 8; i++)
+  {
+    for (j = 0; j < 200; j++)
+    {
+      buf2[i + j] ^= 0x80;
+      COMP(buf1 + i, buf2 + i, j, j);
+      COMP(buf1 + i, buf2 + i, j + 1, j);
+      COMP(buf1 + i, buf2 + i, 250, j);
+      buf2[i + j] ^= 0x80;
+    }
+    COMP(buf1 + i, buf2 + i, sizeof(buf1) - 8, sizeof(buf1) - 8);
+  }
 }
 
 static void test_RtlCompareMemoryUlong(void)
@@ -1852,7 +1852,8 @@ static void test_RtlIsTextUnicode(void)
 
 static void test_RtlCompareUnicodeString(void)
 {
-    WCHAR ch1, ch2;
+    WCHAR ch1, ch2, buf1[100], buf2[100];
+    unsigned int i, j;
     UNICODE_STRING str1, str2;
 
     str1.Buffer = &ch1;
@@ -1878,6 +1879,39 @@ static void test_RtlCompareUnicodeString(void)
             }
         }
     }
+
+    /* longer strings, differing at every position */
+    for (i = 0; i < ARRAY_SIZE(buf1); i++)
+    {
+        buf1[i] = 'a' + i % 26;
+        buf2[i] = 'A' + i % 26;
+    }
+    str1.Buffer = buf1;
+    str2.Buffer = buf2;
+    for (i = 0; i < ARRAY_SIZE(buf1); i++)
+    {
+        LONG res;
+
+        str1.Length = str1.MaximumLength = sizeof(buf1);
+        str2.Length = str2.MaximumLength = sizeof(buf2);
+        res = pRtlCompareUnicodeString( &str1, &str2, FALSE );
+        ok( res == 'a' - 'A', "%u: wrong result %d\n", i, res );
+        res = pRtlCompareUnicodeString( &str1, &str2, TRUE );
+        ok( !res, "%u: wrong result %d\n", i, res );
+
+        buf2[i] = '0';
+        res = pRtlCompareUnicodeString( &str1, &str2, TRUE );
+        ok( res == 'A' + i % 26 - '0', "%u: wrong result %d\n", i, res );
+        memcpy( buf2, buf1, sizeof(buf1) );
+        buf2[i]++;
+        res = pRtlCompareUnicodeString( &str1, &str2, FALSE );
+        ok( res == -1, "%u: wrong result %d\n", i, res );
+        buf2[i]--;
+        str2.Length = i * sizeof(WCHAR);
+        res = pRtlCompareUnicodeString( &str1, &str2, FALSE );
+        ok( res == ARRAY_SIZE(buf1) - i, "%u: wrong result %d\n", i, res );
+        for (j = 0; j < ARRAY_SIZE(buf2); j++) buf2[j] = 'A' + j % 26;
+    }
 }
 
 static const WCHAR szGuid[] = { '{','0','1','0','2','0','3','0','4','-',
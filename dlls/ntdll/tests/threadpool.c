@@ -705,6 +705,83 @@ static void test_tp_work_scheduler(void)
     pTpReleasePool(pool);
 }
 
+static void CALLBACK work_counter_cb(TP_CALLBACK_INSTANCE *instance, void *userdata, TP_WORK *work)
+{
+    InterlockedIncrement((LONG *)userdata);
+}
+
+struct work_post_info
+{
+    TP_WORK *work;
+    int count;
+};
+
+static DWORD CALLBACK work_post_thread(void *param)
+{
+    struct work_post_info *info = param;
+    int i;
+
+    for (i = 0; i < info->count; i++)
+        pTpPostWork(info->work);
+    return 0;
+}
+
+static void test_tp_work_throughput(void)
+{
+    static const int num_items = 20000;
+    struct work_post_info info[4];
+    TP_CALLBACK_ENVIRON environment;
+    HANDLE threads[4];
+    LONG userdata[4];
+    TP_POOL *pool;
+    NTSTATUS status;
+    DWORD ticks;
+    int i;
+
+    /* allocate new threadpool */
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    ok(pool != NULL, "expected pool != NULL\n");
+
+    /* allocate one work item per posting thread */
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 1;
+    environment.Pool = pool;
+    for (i = 0; i < 4; i++)
+    {
+        userdata[i] = 0;
+        info[i].work = NULL;
+        info[i].count = num_items;
+        status = pTpAllocWork(&info[i].work, work_counter_cb, &userdata[i], &environment);
+        ok(!status, "TpAllocWork failed with status %x\n", status);
+        ok(info[i].work != NULL, "expected work != NULL\n");
+    }
+
+    /* post many small work items from several threads at once */
+    ticks = GetTickCount();
+    for (i = 0; i < 4; i++)
+    {
+        threads[i] = CreateThread(NULL, 0, work_post_thread, &info[i], 0, NULL);
+        ok(threads[i] != NULL, "CreateThread failed with error %u\n", GetLastError());
+    }
+    WaitForMultipleObjects(4, threads, TRUE, INFINITE);
+    for (i = 0; i < 4; i++)
+    {
+        pTpWaitForWork(info[i].work, FALSE);
+        ok(userdata[i] == num_items, "expected userdata[%d] = %d, got %u\n", i, num_items, userdata[i]);
+    }
+    trace("executed %d work callbacks in %u ms\n", 4 * num_items, GetTickCount() - ticks);
+
+    /* cleanup */
+    for (i = 0; i < 4; i++)
+    {
+        CloseHandle(threads[i]);
+        pTpReleaseWork(info[i].work);
+    }
+    pTpReleasePool(pool);
+}
+
 static void CALLBACK simple_release_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
 {
     HANDLE *semaphores = userdata;
@@ -1908,6 +1985,7 @@ START_TEST(threadpool)
     test_tp_simple();
     test_tp_work();
     test_tp_work_scheduler();
+    test_tp_work_throughput();
     test_tp_group_wait();
     test_tp_group_cancel();
     test_tp_instance();
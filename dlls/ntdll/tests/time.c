@@ -18,7 +18,9 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
  */
 
+#include <stdio.h>
 #include "ntdll_test.h"
+#include "ddk/wdm.h"
 
 #define TICKSPERSEC        10000000
 #define TICKSPERMSEC       10000
@@ -117,6 +119,69 @@ static void test_NtQueryPerformanceCounter(void)
     ok(status == STATUS_SUCCESS, "expected STATUS_SUCCESS, got %08x\n", status);
 }
 
+static ULONGLONG read_ksystem_time( volatile const KSYSTEM_TIME *time )
+{
+    ULONG low;
+    LONG high;
+
+    do
+    {
+        high = time->High1Time;
+        low = time->LowPart;
+    } while (high != time->High2Time);
+    return (ULONGLONG)high << 32 | low;
+}
+
+static void test_user_shared_data_time(void)
+{
+    const KSHARED_USER_DATA *user_shared_data = (void *)0x7ffe0000;
+    ULONGLONG t1, t2, tick, interrupt;
+    LARGE_INTEGER now;
+    const char *env;
+    DWORD ticks;
+
+    ticks = GetTickCount();
+    tick = GetTickCount64();
+    ok( (DWORD)tick - ticks < 32, "GetTickCount %u, GetTickCount64 %s\n", ticks, wine_dbgstr_longlong(tick) );
+
+    /* Wine only keeps the fields current when WINESHAREDTIME is set */
+    if (!strcmp( winetest_platform, "wine" ) && (!(env = getenv( "WINESHAREDTIME" )) || !atoi( env )))
+    {
+        PROCESS_INFORMATION pi;
+        STARTUPINFOA si = { sizeof(si) };
+        char cmdline[MAX_PATH + 32];
+        char **argv;
+
+        winetest_get_mainargs( &argv );
+        sprintf( cmdline, "\"%s\" time shared_time", argv[0] );
+        SetEnvironmentVariableA( "WINESHAREDTIME", "1" );
+        ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi ),
+            "CreateProcess failed: %u\n", GetLastError() );
+        SetEnvironmentVariableA( "WINESHAREDTIME", NULL );
+        winetest_wait_child_process( pi.hProcess );
+        CloseHandle( pi.hProcess );
+        CloseHandle( pi.hThread );
+        return;
+    }
+
+    NtQuerySystemTime( &now );
+    t1 = read_ksystem_time( &user_shared_data->SystemTime );
+    interrupt = read_ksystem_time( &user_shared_data->InterruptTime );
+    tick = read_ksystem_time( &user_shared_data->TickCount );
+    ok( now.QuadPart - t1 < TICKSPERSEC, "system time %s is too far behind %s\n",
+        wine_dbgstr_longlong(t1), wine_dbgstr_longlong(now.QuadPart) );
+    Sleep( 100 );
+    t2 = read_ksystem_time( &user_shared_data->SystemTime );
+    ok( t2 > t1, "system time didn't advance\n" );
+    ok( read_ksystem_time( &user_shared_data->InterruptTime ) > interrupt,
+        "interrupt time didn't advance\n" );
+    ok( read_ksystem_time( &user_shared_data->TickCount ) > tick, "tick count didn't advance\n" );
+
+    ticks = GetTickCount();
+    tick = read_ksystem_time( &user_shared_data->TickCount ) * user_shared_data->TickCountMultiplier >> 24;
+    ok( ticks - (DWORD)tick < 100, "GetTickCount %u, shared tick count %u\n", ticks, (DWORD)tick );
+}
+
 static void test_RtlQueryTimeZoneInformation(void)
 {
     RTL_DYNAMIC_TIME_ZONE_INFORMATION tzinfo;
@@ -156,6 +221,14 @@ static void test_RtlQueryTimeZoneInformation(void)
 START_TEST(time)
 {
     HMODULE mod = GetModuleHandleA("ntdll.dll");
+    char **argv;
+
+    if (winetest_get_mainargs( &argv ) >= 3 && !strcmp( argv[2], "shared_time" ))
+    {
+        test_user_shared_data_time();
+        return;
+    }
+
     pRtlTimeToTimeFields = (void *)GetProcAddress(mod,"RtlTimeToTimeFields");
     pRtlTimeFieldsToTime = (void *)GetProcAddress(mod,"RtlTimeFieldsToTime");
     pNtQueryPerformanceCounter = (void *)GetProcAddress(mod, "NtQueryPerformanceCounter");
@@ -170,4 +243,5 @@ START_TEST(time)
         win_skip("Required time conversion functions are not available\n");
     test_NtQueryPerformanceCounter();
     test_RtlQueryTimeZoneInformation();
+    test_user_shared_data_time();
 }
@@ -160,7 +160,6 @@ void thread_init(void)
     void *addr;
     BOOL suspend;
     SIZE_T size, info_size;
-    LARGE_INTEGER now;
     NTSTATUS status;
     struct ntdll_thread_data *thread_data;
     static struct debug_info debug_info;  /* debug info for initial thread */
@@ -253,14 +252,7 @@ void thread_init(void)
 
     init_user_process_params( info_size );
 
-    /* initialize time values in user_shared_data */
-    NtQuerySystemTime( &now );
-    user_shared_data->SystemTime.LowPart = now.u.LowPart;
-    user_shared_data->SystemTime.High1Time = user_shared_data->SystemTime.High2Time = now.u.HighPart;
-    user_shared_data->u.TickCountQuad = (now.QuadPart - server_start_time) / 10000;
-    user_shared_data->u.TickCount.High2Time = user_shared_data->u.TickCount.High1Time;
-    user_shared_data->TickCountLowDeprecated = user_shared_data->u.TickCount.LowPart;
-    user_shared_data->TickCountMultiplier = 1 << 24;
+    init_user_shared_data_time();
 
     fill_cpu_info();
 
@@ -297,6 +289,7 @@ void abort_thread( int status )
 {
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
     if (interlocked_xchg_add( &nb_threads, -1 ) <= 1) _exit( status );
+    heap_thread_abort();
     signal_exit_thread( status );
 }
 
@@ -342,6 +335,7 @@ void WINAPI RtlExitUserThread( ULONG status )
 
     LdrShutdownThread();
     RtlFreeThreadActivationContextStack();
+    heap_thread_detach();
 
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
 
@@ -114,8 +114,17 @@ struct timer_queue
  */
 
 #define THREADPOOL_WORKER_TIMEOUT 5000
+#define THREADPOOL_MAX_QUEUES 64
 #define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
 
+/* queue of pending work items, one per processor */
+struct threadpool_queue
+{
+    CRITICAL_SECTION        cs;
+    /* objects with pending callbacks, locked via .cs */
+    struct list             objects;
+};
+
 /* internal threadpool representation */
 struct threadpool
 {
@@ -123,14 +132,20 @@ struct threadpool
     LONG                    objcount;
     BOOL                    shutdown;
     CRITICAL_SECTION        cs;
-    /* pool of work items, locked via .cs */
-    struct list             pool;
     RTL_CONDITION_VARIABLE  update_event;
     /* information about worker threads, locked via .cs */
     int                     max_workers;
     int                     min_workers;
-    int                     num_workers;
-    int                     num_busy_workers;
+    /* changed with .cs held, but may be read without locking */
+    LONG                    num_workers;
+    /* updated with interlocked operations, may be read without locking */
+    LONG                    num_busy_workers;
+    LONG                    num_idle_workers;
+    LONG                    num_queued_callbacks;
+    LONG                    next_queue;
+    /* work item queues, workers steal from other queues when their own is empty */
+    unsigned int            num_queues;
+    struct threadpool_queue queues[1];
 };
 
 enum threadpool_objtype
@@ -155,10 +170,11 @@ struct threadpool_object
     PTP_SIMPLE_CALLBACK     finalization_callback;
     BOOL                    may_run_long;
     HMODULE                 race_dll;
+    struct threadpool_queue *queue;
     /* information about the group, locked via .group->cs */
     struct list             group_entry;
     BOOL                    is_group_member;
-    /* information about the pool, locked via .pool->cs */
+    /* information about the pool, locked via .queue->cs */
     struct list             pool_entry;
     RTL_CONDITION_VARIABLE  finished_event;
     RTL_CONDITION_VARIABLE  group_finished_event;
@@ -1311,7 +1327,7 @@ static NTSTATUS tp_new_worker_thread( struct threadpool *pool )
     {
         interlocked_inc( &pool->refcount );
         pool->num_workers++;
-        pool->num_busy_workers++;
+        interlocked_inc( &pool->num_busy_workers );
         NtClose( thread );
     }
     return status;
@@ -1647,9 +1663,11 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
  */
 static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
 {
+    unsigned int i, num_queues = NtCurrentTeb()->Peb->NumberOfProcessors;
     struct threadpool *pool;
 
-    pool = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*pool) );
+    num_queues = max( 1, min( num_queues, THREADPOOL_MAX_QUEUES ) );
+    pool = RtlAllocateHeap( GetProcessHeap(), 0, FIELD_OFFSET( struct threadpool, queues[num_queues] ) );
     if (!pool)
         return STATUS_NO_MEMORY;
 
@@ -1660,13 +1678,23 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     RtlInitializeCriticalSection( &pool->cs );
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 
-    list_init( &pool->pool );
     RtlInitializeConditionVariable( &pool->update_event );
 
     pool->max_workers           = 500;
     pool->min_workers           = 0;
     pool->num_workers           = 0;
     pool->num_busy_workers      = 0;
+    pool->num_idle_workers      = 0;
+    pool->num_queued_callbacks  = 0;
+    pool->next_queue            = 0;
+
+    pool->num_queues            = num_queues;
+    for (i = 0; i < num_queues; i++)
+    {
+        RtlInitializeCriticalSection( &pool->queues[i].cs );
+        pool->queues[i].cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool_queue.cs");
+        list_init( &pool->queues[i].objects );
+    }
 
     TRACE( "allocated threadpool %p\n", pool );
 
@@ -1696,6 +1724,8 @@ static void tp_threadpool_shutdown( struct threadpool *pool )
  */
 static BOOL tp_threadpool_release( struct threadpool *pool )
 {
+    unsigned int i;
+
     if (interlocked_dec( &pool->refcount ))
         return FALSE;
 
@@ -1703,7 +1733,14 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
 
     assert( pool->shutdown );
     assert( !pool->objcount );
-    assert( list_empty( &pool->pool ) );
+    assert( !pool->num_queued_callbacks );
+
+    for (i = 0; i < pool->num_queues; i++)
+    {
+        assert( list_empty( &pool->queues[i].objects ) );
+        pool->queues[i].cs.DebugInfo->Spare[0] = 0;
+        RtlDeleteCriticalSection( &pool->queues[i].cs );
+    }
 
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
@@ -1860,6 +1897,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     object->finalization_callback   = NULL;
     object->may_run_long            = 0;
     object->race_dll                = NULL;
+    object->queue                   = &pool->queues[(ULONG)interlocked_inc( &pool->next_queue ) % pool->num_queues];
 
     memset( &object->group_entry, 0, sizeof(object->group_entry) );
     object->is_group_member         = FALSE;
@@ -1925,27 +1963,41 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
 static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
 {
     struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
     NTSTATUS status = STATUS_UNSUCCESSFUL;
 
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
-    RtlEnterCriticalSection( &pool->cs );
-
-    /* Start new worker threads if required. */
-    if (pool->num_busy_workers >= pool->num_workers &&
-        pool->num_workers < pool->max_workers)
-        status = tp_new_worker_thread( pool );
+    RtlEnterCriticalSection( &queue->cs );
 
     /* Queue work item and increment refcount. */
     interlocked_inc( &object->refcount );
     if (!object->num_pending_callbacks++)
-        list_add_tail( &pool->pool, &object->pool_entry );
+        list_add_tail( &queue->objects, &object->pool_entry );
+    interlocked_inc( &pool->num_queued_callbacks );
 
     /* Count how often the object was signaled. */
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
+    RtlLeaveCriticalSection( &queue->cs );
+
+    /* Nothing to do if all workers are busy and no new thread can be
+     * started - a worker will pick up the item when it finishes. A worker
+     * about to time out checks the queue again after leaving num_workers,
+     * so it can't exit without seeing the item queued above. */
+    if (!pool->num_idle_workers && (pool->num_busy_workers < pool->num_workers ||
+        pool->num_workers >= pool->max_workers))
+        return;
+
+    RtlEnterCriticalSection( &pool->cs );
+
+    /* Start new worker threads if required. */
+    if (pool->num_busy_workers >= pool->num_workers &&
+        pool->num_workers < pool->max_workers)
+        status = tp_new_worker_thread( pool );
+
     /* No new thread started - wake up one existing thread. */
     if (status != STATUS_SUCCESS)
     {
@@ -1966,17 +2018,18 @@ static void tp_object_cancel( struct threadpool_object *object )
     struct threadpool *pool = object->pool;
     LONG pending_callbacks = 0;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &object->queue->cs );
     if (object->num_pending_callbacks)
     {
         pending_callbacks = object->num_pending_callbacks;
         object->num_pending_callbacks = 0;
         list_remove( &object->pool_entry );
+        interlocked_xchg_add( &pool->num_queued_callbacks, -pending_callbacks );
 
         if (object->type == TP_OBJECT_TYPE_WAIT)
             object->u.wait.signaled = 0;
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &object->queue->cs );
 
     while (pending_callbacks--)
         tp_object_release( object );
@@ -1990,20 +2043,20 @@ static void tp_object_cancel( struct threadpool_object *object )
  */
 static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
 {
-    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &queue->cs );
     if (group_wait)
     {
         while (object->num_pending_callbacks || object->num_running_callbacks)
-            RtlSleepConditionVariableCS( &object->group_finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->group_finished_event, &queue->cs, NULL );
     }
     else
     {
         while (object->num_pending_callbacks || object->num_associated_callbacks)
-            RtlSleepConditionVariableCS( &object->finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->finished_event, &queue->cs, NULL );
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
 }
 
 /***********************************************************************
@@ -2061,6 +2114,63 @@ static BOOL tp_object_release( struct threadpool_object *object )
     return TRUE;
 }
 
+/***********************************************************************
+ *           tp_threadpool_dequeue    (internal)
+ *
+ * Takes the next pending callback from the queues of a threadpool. The
+ * search starts at the queue following the one used last, so that all
+ * queues are served in turn, and steals work from the queues of other
+ * processors when that one is empty.
+ */
+static struct threadpool_object *tp_threadpool_dequeue( struct threadpool *pool, unsigned int *index,
+                                                        TP_WAIT_RESULT *wait_result )
+{
+    struct threadpool_object *object;
+    struct threadpool_queue *queue;
+    unsigned int i;
+    struct list *ptr;
+
+    for (i = 0; i < pool->num_queues; i++)
+    {
+        queue = &pool->queues[(*index + i) % pool->num_queues];
+        if (list_empty( &queue->objects )) continue;
+
+        RtlEnterCriticalSection( &queue->cs );
+        if (!(ptr = list_head( &queue->objects )))
+        {
+            RtlLeaveCriticalSection( &queue->cs );
+            continue;
+        }
+
+        object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+        assert( object->num_pending_callbacks > 0 );
+
+        /* If further pending callbacks are queued, move the work item to
+         * the end of the queue. Otherwise remove it from the queue. */
+        list_remove( &object->pool_entry );
+        if (--object->num_pending_callbacks)
+            list_add_tail( &queue->objects, &object->pool_entry );
+        interlocked_dec( &pool->num_queued_callbacks );
+
+        /* For wait objects check if they were signaled or have timed out. */
+        if (object->type == TP_OBJECT_TYPE_WAIT)
+        {
+            *wait_result = object->u.wait.signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+            if (*wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
+        }
+
+        object->num_associated_callbacks++;
+        object->num_running_callbacks++;
+        interlocked_inc( &pool->num_busy_workers );
+        RtlLeaveCriticalSection( &queue->cs );
+
+        *index = (*index + i + 1) % pool->num_queues;
+        return object;
+    }
+
+    return NULL;
+}
+
 /***********************************************************************
  *           threadpool_worker_proc    (internal)
  */
@@ -2068,41 +2178,23 @@ static void CALLBACK threadpool_worker_proc( void *param )
 {
     TP_CALLBACK_INSTANCE *callback_instance;
     struct threadpool_instance instance;
+    struct threadpool_object *object;
     struct threadpool *pool = param;
     TP_WAIT_RESULT wait_result = 0;
     LARGE_INTEGER timeout;
-    struct list *ptr;
+    unsigned int index;
     NTSTATUS status;
 
     TRACE( "starting worker thread for pool %p\n", pool );
 
-    RtlEnterCriticalSection( &pool->cs );
-    pool->num_busy_workers--;
+    interlocked_dec( &pool->num_busy_workers );
     for (;;)
     {
-        while ((ptr = list_head( &pool->pool )))
-        {
-            struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
-            assert( object->num_pending_callbacks > 0 );
-
-            /* If further pending callbacks are queued, move the work item to
-             * the end of the pool list. Otherwise remove it from the pool. */
-            list_remove( &object->pool_entry );
-            if (--object->num_pending_callbacks)
-                list_add_tail( &pool->pool, &object->pool_entry );
-
-            /* For wait objects check if they were signaled or have timed out. */
-            if (object->type == TP_OBJECT_TYPE_WAIT)
-            {
-                wait_result = object->u.wait.signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
-                if (wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
-            }
+        /* Start looking for work on the queue of the current processor. */
+        index = NtGetCurrentProcessorNumber() % pool->num_queues;
 
-            /* Leave critical section and do the actual callback. */
-            object->num_associated_callbacks++;
-            object->num_running_callbacks++;
-            pool->num_busy_workers++;
-            RtlLeaveCriticalSection( &pool->cs );
+        while ((object = tp_threadpool_dequeue( pool, &index, &wait_result )))
+        {
 
             /* Initialize threadpool instance struct. */
             callback_instance = (TP_CALLBACK_INSTANCE *)&instance;
@@ -2195,8 +2287,8 @@ static void CALLBACK threadpool_worker_proc( void *param )
             }
 
         skip_cleanup:
-            RtlEnterCriticalSection( &pool->cs );
-            pool->num_busy_workers--;
+            RtlEnterCriticalSection( &object->queue->cs );
+            interlocked_dec( &pool->num_busy_workers );
 
             /* Simple callbacks are automatically shutdown after execution. */
             if (object->type == TP_OBJECT_TYPE_SIMPLE)
@@ -2216,27 +2308,48 @@ static void CALLBACK threadpool_worker_proc( void *param )
                     RtlWakeAllConditionVariable( &object->finished_event );
             }
 
+            RtlLeaveCriticalSection( &object->queue->cs );
             tp_object_release( object );
         }
 
+        RtlEnterCriticalSection( &pool->cs );
+
         /* Shutdown worker thread if requested. */
         if (pool->shutdown)
             break;
 
-        /* Wait for new tasks or until the timeout expires. A thread only terminates
+        /* Wait for new tasks or until the timeout expires. Submitters only
+         * wake up idle workers, so the idle count has to be raised before
+         * checking for queued callbacks. A thread only terminates
          * when no new tasks are available, and the number of threads can be
          * decreased without violating the min_workers limit. An exception is when
          * min_workers == 0, then objcount is used to detect if the last thread
          * can be terminated. */
-        timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
-        if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !list_head( &pool->pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
+        interlocked_inc( &pool->num_idle_workers );
+        status = STATUS_SUCCESS;
+        if (!pool->num_queued_callbacks)
+        {
+            timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
+            status = RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout );
+        }
+        interlocked_dec( &pool->num_idle_workers );
+
+        if (status == STATUS_TIMEOUT && !pool->num_queued_callbacks &&
+            (pool->num_workers > max( pool->min_workers, 1 ) ||
             (!pool->min_workers && !pool->objcount)))
         {
-            break;
+            /* Submitters look at the worker counts without taking pool->cs,
+             * and may have seen this thread as available. Check the queue
+             * again once it is no longer counted, and keep running if
+             * anything was submitted in the meantime. */
+            interlocked_dec( &pool->num_workers );
+            if (!pool->num_queued_callbacks) goto done;
+            interlocked_inc( &pool->num_workers );
         }
+        RtlLeaveCriticalSection( &pool->cs );
     }
     pool->num_workers--;
+done:
     RtlLeaveCriticalSection( &pool->cs );
 
     TRACE( "terminating worker thread for pool %p\n", pool );
@@ -2495,7 +2608,6 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
 {
     struct threadpool_instance *this = impl_from_TP_CALLBACK_INSTANCE( instance );
     struct threadpool_object *object = this->object;
-    struct threadpool *pool;
 
     TRACE( "%p\n", instance );
 
@@ -2508,14 +2620,13 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
     if (!this->associated)
         return;
 
-    pool = object->pool;
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &object->queue->cs );
 
     object->num_associated_callbacks--;
     if (!object->num_pending_callbacks && !object->num_associated_callbacks)
         RtlWakeAllConditionVariable( &object->finished_event );
 
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &object->queue->cs );
     this->associated = FALSE;
 }
 
@@ -50,6 +50,7 @@
 #include "wine/unicode.h"
 #include "wine/debug.h"
 #include "ntdll_misc.h"
+#include "ddk/wdm.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
 
@@ -503,6 +504,72 @@ ULONG WINAPI NtGetTickCount(void)
     return monotonic_counter() / TICKSPERMSEC;
 }
 
+
+/* store a time value so that readers never see a torn update; the stores
+ * must become visible in this order, also on weakly ordered CPUs */
+static inline void set_ksystem_time( volatile KSYSTEM_TIME *time, LONGLONG value )
+{
+    interlocked_xchg( (int *)&time->High2Time, value >> 32 );
+    interlocked_xchg( (int *)&time->LowPart, value );
+    interlocked_xchg( (int *)&time->High1Time, value >> 32 );
+}
+
+/* update the time fields of the shared user data */
+static void update_user_shared_data_time(void)
+{
+    LARGE_INTEGER now;
+    ULONGLONG irq = monotonic_counter();
+
+    NtQuerySystemTime( &now );
+    set_ksystem_time( &user_shared_data->SystemTime, now.QuadPart );
+    set_ksystem_time( &user_shared_data->InterruptTime, irq );
+    set_ksystem_time( &user_shared_data->TickCount, irq / TICKSPERMSEC );
+    user_shared_data->TickCountLowDeprecated = irq / TICKSPERMSEC;
+}
+
+static void *user_shared_data_thread( void *arg )
+{
+    /* the default clock interrupt period on Windows */
+    struct timespec delay = { 0, 15625000 };
+
+    for (;;)
+    {
+        nanosleep( &delay, NULL );
+        update_user_shared_data_time();
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *           init_user_shared_data_time
+ *
+ * Initialize the time fields of the shared user data. When WINESHAREDTIME
+ * is set, also start a thread that keeps them current, for applications
+ * that read them directly instead of calling the time functions.
+ */
+void init_user_shared_data_time(void)
+{
+    sigset_t sigset, old_sigset;
+    pthread_attr_t attr;
+    pthread_t id;
+    const char *env;
+
+    user_shared_data->TickCountMultiplier = 1 << 24;
+    update_user_shared_data_time();
+
+    if (!(env = getenv( "WINESHAREDTIME" )) || !atoi( env )) return;
+
+    /* the thread has no TEB, so it must never receive a signal */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_SETMASK, &sigset, &old_sigset );
+    pthread_attr_init( &attr );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    pthread_attr_setstacksize( &attr, 65536 );
+    pthread_create( &id, &attr, user_shared_data_thread, NULL );
+    pthread_attr_destroy( &attr );
+    pthread_sigmask( SIG_SETMASK, &old_sigset, NULL );
+}
+
 /* calculate the mday of dst change date, so that for instance Sun 5 Oct 2007
  * (last Sunday in October of 2007) becomes Sun Oct 28 2007
  *
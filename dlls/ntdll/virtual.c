@@ -119,6 +119,12 @@ static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
 };
 static RTL_CRITICAL_SECTION csVirtual = { &critsect_debug, -1, 0, 0, 0, 0 };
 
+/* Threads that only look up views and page protections take the lock shared, anything that
+ * changes them holds csVirtual and waits for the shared owners to leave. Shared sections
+ * must not access client memory, since a fault there may need exclusive access. */
+static LONG virtual_shared_count;   /* number of shared owners */
+static LONG virtual_writer;         /* set while csVirtual is held */
+
 #ifdef __i386__
 static const UINT page_shift = 12;
 static const UINT_PTR page_mask = 0xfff;
@@ -284,6 +290,115 @@ static int compare_view( const void *addr, const struct wine_rb_entry *entry )
 /***********************************************************************
  *           VIRTUAL_GetProtStr
  */
+/***********************************************************************
+ *           lock_virtual_signal
+ *
+ * Acquire the virtual memory lock for exclusive access without changing
+ * the signal mask, for use inside signal handlers.
+ */
+static void lock_virtual_signal(void)
+{
+    LONG count;
+
+    RtlEnterCriticalSection( &csVirtual );
+    if (csVirtual.RecursionCount > 1) return;
+
+    interlocked_xchg( &virtual_writer, 1 );
+    /* shared sections of the current thread cannot be waited for, they are
+     * suspended by a fault and resume after the exclusive section */
+    while ((count = virtual_shared_count) > ntdll_get_thread_data()->virtual_shared)
+        RtlWaitOnAddress( &virtual_shared_count, &count, sizeof(count), NULL );
+}
+
+
+/***********************************************************************
+ *           unlock_virtual_signal
+ */
+static void unlock_virtual_signal(void)
+{
+    if (csVirtual.RecursionCount == 1) interlocked_xchg( &virtual_writer, 0 );
+    RtlLeaveCriticalSection( &csVirtual );
+}
+
+
+/***********************************************************************
+ *           lock_virtual
+ *
+ * Acquire the virtual memory lock for exclusive access. Signals are blocked
+ * while the lock is held.
+ */
+static void lock_virtual( sigset_t *sigset )
+{
+    pthread_sigmask( SIG_BLOCK, &server_block_set, sigset );
+    lock_virtual_signal();
+}
+
+
+/***********************************************************************
+ *           unlock_virtual
+ */
+static void unlock_virtual( sigset_t *sigset )
+{
+    unlock_virtual_signal();
+    pthread_sigmask( SIG_SETMASK, sigset, NULL );
+}
+
+
+/***********************************************************************
+ *           lock_virtual_shared
+ *
+ * Acquire the virtual memory lock for lookups only. The views and page
+ * protections must not be modified while the lock is held shared.
+ */
+static void lock_virtual_shared( sigset_t *sigset )
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+
+    pthread_sigmask( SIG_BLOCK, &server_block_set, sigset );
+
+    /* nested inside an exclusive section of this thread */
+    if (csVirtual.OwningThread == ULongToHandle(GetCurrentThreadId()))
+    {
+        RtlEnterCriticalSection( &csVirtual );
+        return;
+    }
+
+    /* nested inside a shared section, a waiting writer is already waiting for us */
+    if (thread_data->virtual_shared++)
+    {
+        interlocked_xchg_add( &virtual_shared_count, 1 );
+        return;
+    }
+
+    for (;;)
+    {
+        interlocked_xchg_add( &virtual_shared_count, 1 );
+        if (!virtual_writer) break;
+        interlocked_xchg_add( &virtual_shared_count, -1 );
+        /* wait for the writer to finish */
+        RtlEnterCriticalSection( &csVirtual );
+        RtlLeaveCriticalSection( &csVirtual );
+    }
+}
+
+
+/***********************************************************************
+ *           unlock_virtual_shared
+ */
+static void unlock_virtual_shared( sigset_t *sigset )
+{
+    if (csVirtual.OwningThread == ULongToHandle(GetCurrentThreadId()))
+        RtlLeaveCriticalSection( &csVirtual );
+    else
+    {
+        ntdll_get_thread_data()->virtual_shared--;
+        interlocked_xchg_add( &virtual_shared_count, -1 );
+        if (virtual_writer) RtlWakeAddressAll( &virtual_shared_count );
+    }
+    pthread_sigmask( SIG_SETMASK, sigset, NULL );
+}
+
+
 static const char *VIRTUAL_GetProtStr( BYTE prot )
 {
     static char buffer[6];
@@ -365,12 +480,12 @@ static void VIRTUAL_Dump(void)
     struct file_view *view;
 
     TRACE( "Dump of all virtual memory views:\n" );
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     WINE_RB_FOR_EACH_ENTRY( view, &views_tree, struct file_view, entry )
     {
         VIRTUAL_DumpView( view );
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 }
 #endif
 
@@ -1384,7 +1499,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
 
     /* zero-map the whole range */
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if (base >= (char *)address_space_start)  /* make sure the DOS area remains free */
         status = map_view( &view, base, total_size, mask, FALSE, SEC_IMAGE | SEC_FILE |
@@ -1586,7 +1701,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
     if (status) goto error;
 
     VIRTUAL_DEBUG_DUMP_VIEW( view );
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 
     *addr_ptr = ptr;
 #ifdef VALGRIND_LOAD_PDB_DEBUGINFO
@@ -1597,7 +1712,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
 
  error:
     if (view) delete_view( view );
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -1708,7 +1823,7 @@ NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, S
 
     /* Reserve a properly aligned area */
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     get_vprot_flags( protect, &vprot, sec_flags & SEC_IMAGE );
     vprot |= sec_flags;
@@ -1716,7 +1831,7 @@ NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, S
     res = map_view( &view, *addr_ptr, size, mask, FALSE, vprot );
     if (res)
     {
-        server_leave_uninterrupted_section( &csVirtual, &sigset );
+        unlock_virtual( &sigset );
         goto done;
     }
 
@@ -1751,7 +1866,7 @@ NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, S
         delete_view( view );
     }
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 
 done:
     if (needs_close) close( unix_handle );
@@ -1894,7 +2009,7 @@ NTSTATUS virtual_create_builtin_view( void *module )
 
     size = ROUND_SIZE( module, size );
     base = ROUND_ADDR( module, page_mask );
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     status = create_view( &view, base, size, SEC_IMAGE | SEC_FILE | VPROT_SYSTEM |
                           VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY | VPROT_EXEC );
     if (!status)
@@ -1916,7 +2031,7 @@ NTSTATUS virtual_create_builtin_view( void *module )
         }
         VIRTUAL_DEBUG_DUMP_VIEW( view );
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -1943,7 +2058,7 @@ NTSTATUS virtual_alloc_thread_stack( TEB *teb, SIZE_T reserve_size, SIZE_T commi
     size = (size + 0xffff) & ~0xffff;  /* round to 64K boundary */
     if (pthread_size) *pthread_size = extra_size = max( page_size, ROUND_SIZE( 0, *pthread_size ));
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if ((status = map_view( &view, NULL, size + extra_size, 0xffff, 0,
                             VPROT_READ | VPROT_WRITE | VPROT_COMMITTED )) != STATUS_SUCCESS)
@@ -1982,7 +2097,7 @@ NTSTATUS virtual_alloc_thread_stack( TEB *teb, SIZE_T reserve_size, SIZE_T commi
     teb->Tib.StackBase     = (char *)view->base + view->size;
     teb->Tib.StackLimit    = (char *)view->base + 2 * page_size;
 done:
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -2009,11 +2124,21 @@ NTSTATUS virtual_handle_fault( LPCVOID addr, DWORD err, BOOL on_signal_stack )
 {
     NTSTATUS ret = STATUS_ACCESS_VIOLATION;
     void *page = ROUND_ADDR( addr, page_mask );
+    BOOL exclusive = FALSE;
     sigset_t sigset;
     BYTE vprot;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual_shared( &sigset );
     vprot = get_page_vprot( page );
+    if ((!on_signal_stack && (vprot & VPROT_GUARD)) ||
+        ((err & EXCEPTION_WRITE_FAULT) && (vprot & VPROT_WRITEWATCH)))
+    {
+        /* the page protections have to be changed, start over with exclusive access */
+        unlock_virtual_shared( &sigset );
+        lock_virtual( &sigset );
+        exclusive = TRUE;
+        vprot = get_page_vprot( page );
+    }
     if (!on_signal_stack && (vprot & VPROT_GUARD))
     {
         set_page_vprot_bits( page, page_size, 0, VPROT_GUARD );
@@ -2034,7 +2159,8 @@ NTSTATUS virtual_handle_fault( LPCVOID addr, DWORD err, BOOL on_signal_stack )
                 ret = STATUS_SUCCESS;
         }
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    if (exclusive) unlock_virtual( &sigset );
+    else unlock_virtual_shared( &sigset );
     return ret;
 }
 
@@ -2077,13 +2203,13 @@ unsigned int virtual_locked_server_call( void *req_ptr )
 
     if (!size) return wine_server_call( req_ptr );
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         ret = server_call_unlocked( req );
         if (has_write_watch) update_write_watches( addr, size, wine_server_reply_size( req ));
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return ret;
 }
 
@@ -2100,14 +2226,14 @@ ssize_t virtual_locked_read( int fd, void *addr, size_t size )
     ssize_t ret = read( fd, addr, size );
     if (ret != -1 || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = read( fd, addr, size );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     errno = err;
     return ret;
 }
@@ -2125,14 +2251,14 @@ ssize_t virtual_locked_pread( int fd, void *addr, size_t size, off_t offset )
     ssize_t ret = pread( fd, addr, size, offset );
     if (ret != -1 || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = pread( fd, addr, size, offset );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     errno = err;
     return ret;
 }
@@ -2151,7 +2277,7 @@ ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     ssize_t ret = recvmsg( fd, hdr, flags );
     if (ret != -1 || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     for (i = 0; i < hdr->msg_iovlen; i++)
         if (check_write_access( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, &has_write_watch ))
             break;
@@ -2163,7 +2289,7 @@ ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     if (has_write_watch)
         while (i--) update_write_watches( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, 0 );
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     errno = err;
     return ret;
 }
@@ -2178,10 +2304,10 @@ BOOL virtual_is_valid_code_address( const void *addr, SIZE_T size )
     BOOL ret = FALSE;
     sigset_t sigset;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual_shared( &sigset );
     if ((view = VIRTUAL_FindView( addr, size )))
         ret = !(view->protect & VPROT_SYSTEM);  /* system views are not visible to the app */
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual_shared( &sigset );
     return ret;
 }
 
@@ -2194,9 +2320,14 @@ BOOL virtual_is_valid_code_address( const void *addr, SIZE_T size )
  */
 BOOL virtual_handle_stack_fault( void *addr )
 {
+    /* A writer cannot get past lock_virtual_signal while this thread holds the lock
+     * shared, and would never release csVirtual. No views can change until the shared
+     * section ends, so only the thread's own stack pages are updated here, without it. */
+    BOOL shared = ntdll_get_thread_data()->virtual_shared &&
+                  csVirtual.OwningThread != ULongToHandle(GetCurrentThreadId());
     BOOL ret = FALSE;
 
-    RtlEnterCriticalSection( &csVirtual );  /* no need for signal masking inside signal handler */
+    if (!shared) lock_virtual_signal();  /* no need for signal masking inside signal handler */
     if (get_page_vprot( addr ) & VPROT_GUARD)
     {
         char *page = ROUND_ADDR( addr, page_mask );
@@ -2211,7 +2342,7 @@ BOOL virtual_handle_stack_fault( void *addr )
         }
         ret = TRUE;
     }
-    RtlLeaveCriticalSection( &csVirtual );
+    if (!shared) unlock_virtual_signal();
     return ret;
 }
 
@@ -2298,7 +2429,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
 
     if (!size) return 0;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if ((view = VIRTUAL_FindView( addr, size )))
     {
         if (!(view->protect & VPROT_SYSTEM))
@@ -2317,7 +2448,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
             }
         }
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return bytes_read;
 }
 
@@ -2337,13 +2468,13 @@ NTSTATUS virtual_uninterrupted_write_memory( void *addr, const void *buffer, SIZ
 
     if (!size) return STATUS_SUCCESS;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         memcpy( addr, buffer, size );
         if (has_write_watch) update_write_watches( addr, size, size );
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return ret;
 }
 
@@ -2358,7 +2489,7 @@ void VIRTUAL_SetForceExec( BOOL enable )
     struct file_view *view;
     sigset_t sigset;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!force_exec_prot != !enable)  /* change all existing views */
     {
         force_exec_prot = enable;
@@ -2371,7 +2502,7 @@ void VIRTUAL_SetForceExec( BOOL enable )
             mprotect_range( view->base, view->size, commit, 0 );
         }
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 }
 
 struct free_range
@@ -2409,7 +2540,7 @@ void virtual_release_address_space(void)
 
     if (is_win64) return;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     range.base  = (char *)0x82000000;
     range.limit = user_space_limit;
@@ -2433,7 +2564,7 @@ void virtual_release_address_space(void)
         while (wine_mmap_enum_reserved_areas( free_reserved_memory, &range, 0 )) /* nothing */;
     }
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 }
 
 
@@ -2538,7 +2669,7 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
 
     /* Reserve the memory */
 
-    if (use_locks) server_enter_uninterrupted_section( &csVirtual, &sigset );
+    if (use_locks) lock_virtual( &sigset );
 
     if ((type & MEM_RESERVE) || !base)
     {
@@ -2579,7 +2710,7 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
 
     if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
 
-    if (use_locks) server_leave_uninterrupted_section( &csVirtual, &sigset );
+    if (use_locks) unlock_virtual( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -2635,7 +2766,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
     /* avoid freeing the DOS area when a broken app passes a NULL pointer */
     if (!base) return STATUS_INVALID_PARAMETER;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if (!(view = VIRTUAL_FindView( base, size )) || !is_view_valloc( view ))
     {
@@ -2668,7 +2799,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
         status = STATUS_INVALID_PARAMETER;
     }
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -2722,7 +2853,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
     size = ROUND_SIZE( addr, size );
     base = ROUND_ADDR( addr, page_mask );
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if ((view = VIRTUAL_FindView( base, size )))
     {
@@ -2738,7 +2869,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
 
     if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -2802,7 +2933,7 @@ NTSTATUS WINAPI NtQueryVirtualMemory( HANDLE process, LPCVOID addr,
     struct file_view *view;
     char *base, *alloc_base = 0, *alloc_end = working_set_limit;
     struct wine_rb_entry *ptr;
-    MEMORY_BASIC_INFORMATION *info = buffer;
+    MEMORY_BASIC_INFORMATION *info = buffer, mbi;
     sigset_t sigset;
 
     if (info_class != MemoryBasicInformation)
@@ -2858,7 +2989,7 @@ NTSTATUS WINAPI NtQueryVirtualMemory( HANDLE process, LPCVOID addr,
 
     /* Find the view containing the address */
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual_shared( &sigset );
     ptr = views_tree.root;
     while (ptr)
     {
@@ -2883,31 +3014,31 @@ NTSTATUS WINAPI NtQueryVirtualMemory( HANDLE process, LPCVOID addr,
 
     /* Fill the info structure */
 
-    info->AllocationBase = alloc_base;
-    info->BaseAddress    = base;
-    info->RegionSize     = alloc_end - base;
+    mbi.AllocationBase = alloc_base;
+    mbi.BaseAddress    = base;
+    mbi.RegionSize     = alloc_end - base;
 
     if (!ptr)
     {
-        if (!wine_mmap_enum_reserved_areas( get_free_mem_state_callback, info, 0 ))
+        if (!wine_mmap_enum_reserved_areas( get_free_mem_state_callback, &mbi, 0 ))
         {
             /* not in a reserved area at all, pretend it's allocated */
 #ifdef __i386__
             if (base >= (char *)address_space_start)
             {
-                info->State             = MEM_RESERVE;
-                info->Protect           = PAGE_NOACCESS;
-                info->AllocationProtect = PAGE_NOACCESS;
-                info->Type              = MEM_PRIVATE;
+                mbi.State             = MEM_RESERVE;
+                mbi.Protect           = PAGE_NOACCESS;
+                mbi.AllocationProtect = PAGE_NOACCESS;
+                mbi.Type              = MEM_PRIVATE;
             }
             else
 #endif
             {
-                info->State             = MEM_FREE;
-                info->Protect           = PAGE_NOACCESS;
-                info->AllocationBase    = 0;
-                info->AllocationProtect = 0;
-                info->Type              = 0;
+                mbi.State             = MEM_FREE;
+                mbi.Protect           = PAGE_NOACCESS;
+                mbi.AllocationBase    = 0;
+                mbi.AllocationProtect = 0;
+                mbi.Type              = 0;
             }
         }
     }
@@ -2917,18 +3048,20 @@ NTSTATUS WINAPI NtQueryVirtualMemory( HANDLE process, LPCVOID addr,
         char *ptr;
         SIZE_T range_size = get_committed_size( view, base, &vprot );
 
-        info->State = (vprot & VPROT_COMMITTED) ? MEM_COMMIT : MEM_RESERVE;
-        info->Protect = (vprot & VPROT_COMMITTED) ? VIRTUAL_GetWin32Prot( vprot, view->protect ) : 0;
-        info->AllocationProtect = VIRTUAL_GetWin32Prot( view->protect, view->protect );
-        if (view->protect & SEC_IMAGE) info->Type = MEM_IMAGE;
-        else if (view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT)) info->Type = MEM_MAPPED;
-        else info->Type = MEM_PRIVATE;
+        mbi.State = (vprot & VPROT_COMMITTED) ? MEM_COMMIT : MEM_RESERVE;
+        mbi.Protect = (vprot & VPROT_COMMITTED) ? VIRTUAL_GetWin32Prot( vprot, view->protect ) : 0;
+        mbi.AllocationProtect = VIRTUAL_GetWin32Prot( view->protect, view->protect );
+        if (view->protect & SEC_IMAGE) mbi.Type = MEM_IMAGE;
+        else if (view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT)) mbi.Type = MEM_MAPPED;
+        else mbi.Type = MEM_PRIVATE;
         for (ptr = base; ptr < base + range_size; ptr += page_size)
             if ((get_page_vprot( ptr ) ^ vprot) & ~VPROT_WRITEWATCH) break;
-        info->RegionSize = ptr - base;
+        mbi.RegionSize = ptr - base;
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual_shared( &sigset );
 
+    /* only copy to the caller buffer once the lock is released, it may have write watches */
+    *info = mbi;
     if (res_len) *res_len = sizeof(*info);
     return STATUS_SUCCESS;
 }
@@ -3159,7 +3292,7 @@ NTSTATUS WINAPI NtUnmapViewOfSection( HANDLE process, PVOID addr )
         return status;
     }
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if ((view = VIRTUAL_FindView( addr, 0 )) && !is_view_valloc( view ))
     {
         if (!(view->protect & VPROT_SYSTEM))
@@ -3179,7 +3312,7 @@ NTSTATUS WINAPI NtUnmapViewOfSection( HANDLE process, PVOID addr )
             status = STATUS_SUCCESS;
         }
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -3304,7 +3437,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
         return result.virtual_flush.status;
     }
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
     if (!(view = VIRTUAL_FindView( addr, *size_ptr ))) status = STATUS_INVALID_PARAMETER;
     else
     {
@@ -3314,7 +3447,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
         if (msync( addr, *size_ptr, MS_ASYNC )) status = STATUS_NOT_MAPPED_DATA;
 #endif
     }
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -3341,7 +3474,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     TRACE( "%p %x %p-%p %p %lu\n", process, flags, base, (char *)base + size,
            addresses, *count );
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if (is_write_watch_range( base, size ))
     {
@@ -3360,7 +3493,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     }
     else status = STATUS_INVALID_PARAMETER;
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -3381,14 +3514,14 @@ NTSTATUS WINAPI NtResetWriteWatch( HANDLE process, PVOID base, SIZE_T size )
 
     if (!size) return STATUS_INVALID_PARAMETER;
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     if (is_write_watch_range( base, size ))
         reset_write_watches( base, size );
     else
         status = STATUS_INVALID_PARAMETER;
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
 
@@ -3465,7 +3598,7 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
 
     TRACE("%p %p\n", addr1, addr2);
 
-    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    lock_virtual( &sigset );
 
     view1 = VIRTUAL_FindView( addr1, 0 );
     view2 = VIRTUAL_FindView( addr2, 0 );
@@ -3489,6 +3622,6 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
         SERVER_END_REQ;
     }
 
-    server_leave_uninterrupted_section( &csVirtual, &sigset );
+    unlock_virtual( &sigset );
     return status;
 }
@@ -24,6 +24,7 @@
 
 #include <assert.h>
 #include <stdarg.h>
+#include <stdlib.h>
 
 #define NONAMELESSUNION
 #define NONAMELESSSTRUCT
@@ -2740,6 +2741,246 @@ static inline void call_sendmsg_callback( SENDASYNCPROC callback, HWND hwnd, UIN
 }
 
 
+/* When WINEFASTMSG is set, the server shares the queue state, and messages that a thread
+ * posts to itself are buffered here and only handed over to the server when
+ * it needs to see them. They record the sequence number of the next message
+ * posted through the server, so that the server can merge them in order with
+ * messages posted by others. The shared state is read-only here. */
+
+#define LOCAL_QUEUE_SIZE  64  /* maximum number of buffered messages */
+#define LOCAL_PEEK_LIMIT  64  /* messages retrieved before checking with the server again */
+#define LOCAL_PEEK_TIME   100 /* ms before checking with the server again, so that it knows the
+                               * thread isn't hung, and the active hooks are up to date */
+
+struct local_msg_queue
+{
+    const volatile struct queue_shared *shared; /* queue state shared with the server */
+    unsigned int                  count;       /* number of buffered messages */
+    unsigned int                  changed;     /* changed bits not reported to the server yet */
+    unsigned int                  local_peeks; /* messages retrieved since the last server call */
+    DWORD                         server_time; /* time of the last server call */
+    POINT                         pt;          /* last known cursor position */
+    struct posted_message         msgs[LOCAL_QUEUE_SIZE];
+};
+
+static const struct queue_shared *queue_shared_area;
+static int queue_shared_enabled = -1;
+
+/***********************************************************************
+ *           get_local_queue
+ *
+ * Get the client side message buffer of the current thread, if the server supports it.
+ */
+static struct local_msg_queue *get_local_queue(void)
+{
+    struct local_msg_queue *queue = get_user_thread_info()->local_queue;
+    struct queue_shared *area;
+    unsigned int index = 0;
+    HANDLE handle = 0;
+    SIZE_T size = 0;
+    NTSTATUS status;
+    POINT pt = { 0, 0 };
+
+    if (queue) return queue->shared ? queue : NULL;
+    if (queue_shared_enabled == -1)
+    {
+        const char *env = getenv( "WINEFASTMSG" );
+        queue_shared_enabled = env && atoi( env );
+    }
+    if (!queue_shared_enabled) return NULL;
+
+    SERVER_START_REQ( get_queue_shared )
+    {
+        req->map = !queue_shared_area;
+        if (!(status = wine_server_call( req )))
+        {
+            handle = wine_server_ptr_handle( reply->handle );
+            size   = reply->size;
+            index  = reply->index;
+            pt.x   = reply->x;
+            pt.y   = reply->y;
+        }
+    }
+    SERVER_END_REQ;
+
+    if (status == STATUS_NOT_SUPPORTED)
+    {
+        queue_shared_enabled = 0;
+        return NULL;
+    }
+    if (!(queue = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*queue) )))
+    {
+        if (handle) CloseHandle( handle );
+        return NULL;
+    }
+    /* from now on a NULL shared pointer means that this thread can't use it */
+    get_user_thread_info()->local_queue = queue;
+    if (status) return NULL;
+
+    if (handle)
+    {
+        if ((area = MapViewOfFile( handle, FILE_MAP_READ, 0, 0, size )) &&
+            InterlockedCompareExchangePointer( (void **)&queue_shared_area, area, NULL ))
+            UnmapViewOfFile( area );  /* another thread mapped it first */
+        CloseHandle( handle );
+    }
+    if (!queue_shared_area || index >= size / sizeof(*queue_shared_area)) return NULL;
+
+    queue->shared = &queue_shared_area[index];
+    queue->pt = pt;
+    return queue;
+}
+
+
+/***********************************************************************
+ *           flush_local_messages
+ *
+ * Hand the buffered messages over to the server queue. Called before
+ * anything that makes the server look at the queue.
+ */
+static void flush_local_messages(void)
+{
+    struct local_msg_queue *queue = get_user_thread_info()->local_queue;
+
+    if (!queue || !queue->count) return;
+
+    SERVER_START_REQ( post_local_messages )
+    {
+        req->changed_bits = queue->changed;
+        wine_server_add_data( req, queue->msgs, queue->count * sizeof(queue->msgs[0]) );
+        wine_server_call( req );
+    }
+    SERVER_END_REQ;
+    queue->count = 0;
+    queue->changed = 0;
+}
+
+
+/***********************************************************************
+ *           post_local_message
+ *
+ * Buffer a message posted by the current thread to itself.
+ */
+static BOOL post_local_message( const struct send_message_info *info )
+{
+    struct local_msg_queue *queue;
+    struct posted_message *msg;
+
+    if (info->msg & 0x80000000) return FALSE;  /* internal message */
+    if (info->msg == WM_HOTKEY) return FALSE;
+    if (info->msg >= WM_DDE_FIRST && info->msg <= WM_DDE_LAST) return FALSE;
+    if (!(queue = get_local_queue())) return FALSE;
+
+    if (queue->count == LOCAL_QUEUE_SIZE) flush_local_messages();
+
+    msg = &queue->msgs[queue->count++];
+    msg->win    = wine_server_user_handle( info->hwnd ? WIN_GetFullHandle( info->hwnd ) : 0 );
+    msg->msg    = info->msg;
+    msg->wparam = info->wparam;
+    msg->lparam = info->lparam;
+    msg->x      = queue->pt.x;
+    msg->y      = queue->pt.y;
+    msg->time   = GetTickCount();
+    msg->seq    = queue->shared->post_seq;
+    queue->changed |= QS_POSTMESSAGE | QS_ALLPOSTMESSAGE;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           peek_local_message
+ *
+ * Retrieve a buffered message if nothing in the server queue must come first.
+ */
+static BOOL peek_local_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags )
+{
+    struct local_msg_queue *queue = get_user_thread_info()->local_queue;
+    unsigned int i;
+
+    if (!queue || !queue->count) return FALSE;
+    if (HIWORD(flags) && !(HIWORD(flags) & QS_POSTMESSAGE)) return FALSE;
+    if (queue->local_peeks >= LOCAL_PEEK_LIMIT) return FALSE;
+    if (GetTickCount() - queue->server_time >= LOCAL_PEEK_TIME) return FALSE;
+    /* sent messages have priority, and messages queued in the server may be older */
+    if (queue->shared->wake_bits & (QS_SENDMESSAGE | QS_POSTMESSAGE)) return FALSE;
+
+    if (hwnd && hwnd != HWND_TOPMOST && hwnd != (HWND)1) hwnd = WIN_GetFullHandle( hwnd );
+
+    for (i = 0; i < queue->count; i++)
+    {
+        struct posted_message *posted = &queue->msgs[i];
+        HWND win = wine_server_ptr_handle( posted->win );
+
+        if (win && !WIN_IsCurrentThread( win ))
+        {
+            /* the window has been destroyed, let the server turn it into a pending quit message */
+            if (posted->msg == WM_QUIT) return FALSE;
+            /* drop the message like the server would */
+            memmove( posted, posted + 1, (--queue->count - i) * sizeof(*posted) );
+            i--;
+            continue;
+        }
+        if (posted->msg < first || posted->msg > last) continue;
+        if (hwnd == HWND_TOPMOST || hwnd == (HWND)1)
+        {
+            if (win) continue;
+        }
+        else if (hwnd && win != hwnd && (!win || !IsChild( hwnd, win ))) continue;
+
+        msg->hwnd    = win;
+        msg->message = posted->msg;
+        msg->wParam  = posted->wparam;
+        msg->lParam  = posted->lparam;
+        msg->time    = posted->time;
+        msg->pt.x    = posted->x;
+        msg->pt.y    = posted->y;
+
+        queue->changed &= ~QS_POSTMESSAGE;
+        if (!first && last == ~0U) queue->changed &= ~QS_ALLPOSTMESSAGE;
+        if (flags & PM_REMOVE) memmove( posted, posted + 1, (--queue->count - i) * sizeof(*posted) );
+        queue->local_peeks++;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+
+/***********************************************************************
+ *           get_queue_bits
+ *
+ * Retrieve the queue wake and changed bits, clearing the specified changed bits.
+ */
+void get_queue_bits( UINT clear_bits, UINT *wake_bits, UINT *changed_bits )
+{
+    struct local_msg_queue *queue = get_local_queue();
+
+    if (queue && !(queue->shared->changed_bits & clear_bits))
+    {
+        /* nothing to clear in the server, the shared state is enough */
+        *wake_bits = queue->shared->wake_bits;
+        *changed_bits = queue->shared->changed_bits;
+    }
+    else
+    {
+        SERVER_START_REQ( get_queue_status )
+        {
+            req->clear_bits = clear_bits;
+            wine_server_call( req );
+            *wake_bits = reply->wake_bits;
+            *changed_bits = reply->changed_bits;
+        }
+        SERVER_END_REQ;
+    }
+
+    if (queue && queue->count)
+    {
+        *wake_bits |= QS_POSTMESSAGE | QS_ALLPOSTMESSAGE;
+        *changed_bits |= queue->changed;
+        queue->changed &= ~clear_bits;
+    }
+}
+
+
 /***********************************************************************
  *           peek_message
  *
@@ -2769,33 +3010,51 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
 
         thread_info->msg_source = prev_source;
 
-        SERVER_START_REQ( get_message )
+        if (peek_local_message( &info.msg, hwnd, first, last, flags ))
         {
-            req->flags     = flags;
-            req->get_win   = wine_server_user_handle( hwnd );
-            req->get_first = first;
-            req->get_last  = last;
-            req->hw_id     = hw_id;
-            req->wake_mask = changed_mask & (QS_SENDMESSAGE | QS_SMRESULT);
-            req->changed_mask = changed_mask;
-            wine_server_set_reply( req, buffer, buffer_size );
-            if (!(res = wine_server_call( req )))
+            info.type = MSG_POSTED;
+            hw_id     = 0;
+            res       = 0;
+        }
+        else
+        {
+            flush_local_messages();
+
+            SERVER_START_REQ( get_message )
             {
-                size = wine_server_reply_size( reply );
-                info.type        = reply->type;
-                info.msg.hwnd    = wine_server_ptr_handle( reply->win );
-                info.msg.message = reply->msg;
-                info.msg.wParam  = reply->wparam;
-                info.msg.lParam  = reply->lparam;
-                info.msg.time    = reply->time;
-                info.msg.pt.x    = reply->x;
-                info.msg.pt.y    = reply->y;
-                hw_id            = 0;
-                thread_info->active_hooks = reply->active_hooks;
+                req->flags     = flags;
+                req->get_win   = wine_server_user_handle( hwnd );
+                req->get_first = first;
+                req->get_last  = last;
+                req->hw_id     = hw_id;
+                req->wake_mask = changed_mask & (QS_SENDMESSAGE | QS_SMRESULT);
+                req->changed_mask = changed_mask;
+                wine_server_set_reply( req, buffer, buffer_size );
+                if (!(res = wine_server_call( req )))
+                {
+                    size = wine_server_reply_size( reply );
+                    info.type        = reply->type;
+                    info.msg.hwnd    = wine_server_ptr_handle( reply->win );
+                    info.msg.message = reply->msg;
+                    info.msg.wParam  = reply->wparam;
+                    info.msg.lParam  = reply->lparam;
+                    info.msg.time    = reply->time;
+                    info.msg.pt.x    = reply->x;
+                    info.msg.pt.y    = reply->y;
+                    hw_id            = 0;
+                    thread_info->active_hooks = reply->active_hooks;
+                }
+                else buffer_size = reply->total;
+            }
+            SERVER_END_REQ;
+
+            if (thread_info->local_queue)
+            {
+                thread_info->local_queue->local_peeks = 0;
+                thread_info->local_queue->server_time = GetTickCount();
+                if (!res) thread_info->local_queue->pt = info.msg.pt;
             }
-            else buffer_size = reply->total;
         }
-        SERVER_END_REQ;
 
         if (res)
         {
@@ -3072,6 +3331,7 @@ static DWORD wait_objects( DWORD count, const HANDLE *handles, DWORD timeout,
     assert( count );  /* we must have at least the server queue */
 
     flush_window_surfaces( TRUE );
+    flush_local_messages();
 
     if (thread_info->wake_mask != wake_mask || thread_info->changed_mask != changed_mask)
     {
@@ -3697,6 +3957,8 @@ BOOL WINAPI PostMessageW( HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam )
 
     if (USER_IsExitingThread( info.dest_tid )) return TRUE;
 
+    if (info.dest_tid == GetCurrentThreadId() && post_local_message( &info )) return TRUE;
+
     return put_message_in_queue( &info, NULL );
 }
 
@@ -3732,6 +3994,9 @@ BOOL WINAPI PostThreadMessageW( DWORD thread, UINT msg, WPARAM wparam, LPARAM lp
     info.wparam   = wparam;
     info.lparam   = lparam;
     info.flags    = 0;
+
+    if (thread == GetCurrentThreadId() && post_local_message( &info )) return TRUE;
+
     return put_message_in_queue( &info, NULL );
 }
 
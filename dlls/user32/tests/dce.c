@@ -629,6 +629,79 @@ static void test_dc_layout(void)
     DestroyWindow(hwnd_cache_rtl);
 }
 
+#define check_clip_box(hwnd, left, top, right, bottom) check_clip_box_( __LINE__, hwnd, left, top, right, bottom )
+static void check_clip_box_( unsigned int line, HWND hwnd, int left, int top, int right, int bottom )
+{
+    RECT rect, expect;
+    HDC dc;
+
+    dc = GetDCEx( hwnd, 0, DCX_CACHE | DCX_CLIPSIBLINGS );
+    GetClipBox( dc, &rect );
+    ReleaseDC( hwnd, dc );
+    SetRect( &expect, left, top, right, bottom );
+    ok_(__FILE__, line)( EqualRect( &rect, &expect ), "got clip box %s, expected %s\n",
+                         wine_dbgstr_rect( &rect ), wine_dbgstr_rect( &expect ));
+}
+
+/* the visible region must follow the changes of the siblings and parents */
+static void test_visrgn_changes(void)
+{
+    HWND parent, child, sibling;
+    LONG style;
+
+    parent = CreateWindowA( "cache_class", NULL, WS_POPUP | WS_VISIBLE | WS_CLIPCHILDREN,
+                            0, 0, 200, 200, 0, 0, GetModuleHandleA(0), NULL );
+    child = CreateWindowA( "cache_class", NULL, WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS,
+                           0, 0, 100, 100, parent, 0, GetModuleHandleA(0), NULL );
+    sibling = CreateWindowA( "cache_class", NULL, WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS,
+                             50, 0, 50, 100, parent, 0, GetModuleHandleA(0), NULL );
+    check_clip_box( child, 0, 0, 50, 100 );
+
+    /* moving a sibling */
+    SetWindowPos( sibling, 0, 80, 0, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE );
+    check_clip_box( child, 0, 0, 80, 100 );
+
+    /* restacking */
+    SetWindowPos( sibling, HWND_BOTTOM, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE );
+    check_clip_box( child, 0, 0, 100, 100 );
+    SetWindowPos( sibling, HWND_TOP, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE );
+    check_clip_box( child, 0, 0, 80, 100 );
+
+    /* restyling */
+    style = GetWindowLongA( sibling, GWL_STYLE );
+    SetWindowLongA( sibling, GWL_STYLE, style & ~WS_VISIBLE );
+    check_clip_box( child, 0, 0, 100, 100 );
+    SetWindowLongA( sibling, GWL_STYLE, style );
+    check_clip_box( child, 0, 0, 80, 100 );
+
+    /* window region of a sibling */
+    SetWindowRgn( sibling, CreateRectRgn( 0, 0, 10, 100 ), TRUE );
+    check_clip_box( child, 0, 0, 100, 100 );
+    SetWindowRgn( sibling, 0, TRUE );
+    check_clip_box( child, 0, 0, 80, 100 );
+
+    /* moving the parent partly off the screen */
+    SetWindowPos( parent, 0, -50, 0, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE );
+    check_clip_box( child, 50, 0, 80, 100 );
+    SetWindowPos( parent, 0, 0, 0, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE );
+    check_clip_box( child, 0, 0, 80, 100 );
+
+    /* window region of the parent */
+    SetWindowRgn( parent, CreateRectRgn( 0, 0, 200, 40 ), TRUE );
+    check_clip_box( child, 0, 0, 80, 40 );
+    SetWindowRgn( parent, 0, TRUE );
+    check_clip_box( child, 0, 0, 80, 100 );
+
+    /* restyling the parent */
+    style = GetWindowLongA( parent, GWL_STYLE );
+    SetWindowLongA( parent, GWL_STYLE, style & ~WS_VISIBLE );
+    check_clip_box( child, 0, 0, 0, 0 );
+    SetWindowLongA( parent, GWL_STYLE, style );
+    check_clip_box( child, 0, 0, 80, 100 );
+
+    DestroyWindow( parent );
+}
+
 static void test_destroyed_window(void)
 {
     HDC dc, old_dc;
@@ -759,6 +832,7 @@ START_TEST(dce)
     test_scroll_window();
     test_invisible_create();
     test_dc_layout();
+    test_visrgn_changes();
     /* this should be last */
     test_destroyed_window();
 }
@@ -15741,6 +15741,124 @@ static void test_PostMessage(void)
     flush_events();
 }
 
+static DWORD WINAPI post_message_thread( void *arg )
+{
+    DWORD tid = *(DWORD *)arg;
+
+    PostThreadMessageA( tid, WM_USER + 2, 0, 0 );
+    return 0;
+}
+
+static void test_PostMessage_order(void)
+{
+    DWORD tid = GetCurrentThreadId();
+    HANDLE thread;
+    DWORD status;
+    MSG msg;
+    UINT i;
+
+    flush_events();
+
+    /* messages posted by the thread itself and by another thread stay in order */
+    PostThreadMessageA( tid, WM_USER + 1, 0, 0 );
+    thread = CreateThread( NULL, 0, post_message_thread, &tid, 0, NULL );
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+    PostThreadMessageA( tid, WM_USER + 3, 0, 0 );
+    PostThreadMessageA( tid, WM_USER + 4, 0, 0 );
+
+    status = GetQueueStatus( QS_POSTMESSAGE );
+    ok( status == MAKELONG( QS_POSTMESSAGE, QS_POSTMESSAGE ), "got status %08x\n", status );
+    status = GetQueueStatus( QS_POSTMESSAGE );
+    ok( status == MAKELONG( 0, QS_POSTMESSAGE ), "got status %08x\n", status );
+
+    ok( PeekMessageA( &msg, 0, WM_USER + 4, WM_USER + 4, PM_REMOVE ), "no message\n" );
+    ok( msg.message == WM_USER + 4, "got message %04x\n", msg.message );
+    for (i = 1; i <= 3; i++)
+    {
+        ok( PeekMessageA( &msg, 0, WM_USER, WM_USER + 10, PM_REMOVE ), "%u: no message\n", i );
+        ok( msg.message == WM_USER + i, "%u: got message %04x\n", i, msg.message );
+    }
+    ok( !PeekMessageA( &msg, 0, WM_USER, WM_USER + 10, PM_REMOVE ), "got message %04x\n", msg.message );
+    status = GetQueueStatus( QS_POSTMESSAGE );
+    ok( !(HIWORD(status) & QS_POSTMESSAGE), "got status %08x\n", status );
+}
+
+/* run the posted message tests again with the client side message buffer */
+static void test_fast_messages( const char *argv0 )
+{
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = { sizeof(si) };
+    char cmdline[MAX_PATH + 32];
+
+    sprintf( cmdline, "\"%s\" msg fastmsg", argv0 );
+    SetEnvironmentVariableA( "WINEFASTMSG", "1" );
+    ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi ),
+        "CreateProcess failed: %u\n", GetLastError() );
+    SetEnvironmentVariableA( "WINEFASTMSG", NULL );
+    winetest_wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+}
+
+static void test_PeekMessage_depth(void)
+{
+    static const UINT depths[] = { 100, 1000, 5000 };
+    LARGE_INTEGER start, end, freq;
+    HWND hwnd, other;
+    UINT i, j, count;
+    MSG msg;
+    BOOL ret;
+
+    hwnd = CreateWindowExA( 0, "static", NULL, WS_POPUP, 0, 0, 0, 0, 0, 0, 0, NULL );
+    ok( hwnd != NULL, "CreateWindow failed\n" );
+    other = CreateWindowExA( 0, "static", NULL, WS_POPUP, 0, 0, 0, 0, 0, 0, 0, NULL );
+    ok( other != NULL, "CreateWindow failed\n" );
+    flush_events();
+    QueryPerformanceFrequency( &freq );
+
+    for (i = 0; i < ARRAY_SIZE(depths); i++)
+    {
+        /* fill the queue with messages that don't match the filters */
+        for (j = 0; j < depths[i]; j++)
+            if (!PostMessageA( j & 1 ? other : hwnd, WM_USER + 1, j, 0 )) break;
+        count = j;
+        PostMessageA( hwnd, WM_USER + 2, 0, 0 );
+
+        QueryPerformanceCounter( &start );
+        for (j = 0; j < 1000; j++)
+        {
+            ret = PeekMessageA( &msg, hwnd, WM_USER + 2, WM_USER + 2, PM_NOREMOVE );
+            if (!ret) break;
+        }
+        QueryPerformanceCounter( &end );
+        ok( ret && msg.message == WM_USER + 2, "%u: got %d msg %04x\n", depths[i], ret, msg.message );
+        trace( "depth %u: message filter %u ns\n", count,
+               (UINT)((end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart) );
+
+        QueryPerformanceCounter( &start );
+        for (j = 0; j < 1000; j++)
+        {
+            ret = PeekMessageA( &msg, other, WM_USER, WM_USER + 1, PM_NOREMOVE );
+            if (!ret) break;
+        }
+        QueryPerformanceCounter( &end );
+        ok( ret && msg.hwnd == other, "%u: got %d hwnd %p\n", depths[i], ret, msg.hwnd );
+        trace( "depth %u: window filter %u ns\n", count,
+               (UINT)((end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart) );
+
+        /* the first matching message must still be returned first */
+        ok( PeekMessageA( &msg, 0, WM_USER + 1, WM_USER + 2, PM_REMOVE ), "%u: no message\n", depths[i] );
+        ok( msg.message == WM_USER + 1 && msg.wParam == 0, "%u: got msg %04x wp %lx\n",
+            depths[i], msg.message, msg.wParam );
+        while (PeekMessageA( &msg, 0, WM_USER, WM_USER + 10, PM_REMOVE ));
+    }
+
+    DestroyWindow( other );
+    DestroyWindow( hwnd );
+    flush_events();
+}
+
 static LPARAM g_broadcast_lparam;
 static LRESULT WINAPI broadcast_test_proc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
@@ -17548,7 +17666,7 @@ START_TEST(msg)
     init_funcs();
 
     argc = winetest_get_mainargs( &test_argv );
-    if (argc >= 3)
+    if (argc >= 3 && strcmp( test_argv[2], "fastmsg" ))
     {
         unsigned int arg;
         /* Child process. */
@@ -17571,6 +17689,15 @@ START_TEST(msg)
 
     if (!RegisterWindowClasses()) assert(0);
 
+    if (argc >= 3)
+    {
+        /* child process of test_fast_messages */
+        test_PostMessage();
+        test_PostMessage_order();
+        test_quit_message();
+        return;
+    }
+
     if (pSetWinEventHook)
     {
         hEvent_hook = pSetWinEventHook(EVENT_MIN, EVENT_MAX,
@@ -17607,6 +17734,9 @@ START_TEST(msg)
     test_SetFocus();
     test_SetParent();
     test_PostMessage();
+    test_PostMessage_order();
+    test_fast_messages( test_argv[0] );
+    test_PeekMessage_depth();
     test_broadcast();
     test_ShowWindow();
     test_PeekMessage();
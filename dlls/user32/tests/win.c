@@ -9081,6 +9081,88 @@ todo_wine
     ok(ret, "UnregisterClass(my_window) failed\n");
 }
 
+static void test_window_from_point_grid(void)
+{
+    WNDCLASSA cls;
+    HWND parent, overlap, window[100], hwnd;
+    POINT pt;
+    int i, ret;
+
+    memset(&cls, 0, sizeof(cls));
+    cls.lpfnWndProc = DefWindowProcA;
+    cls.hInstance = GetModuleHandleA(NULL);
+    cls.lpszClassName = "grid_window";
+    ret = RegisterClassA(&cls);
+    ok(ret, "RegisterClass(grid_window) failed\n");
+
+    parent = CreateWindowExA(0, "grid_window", NULL, WS_POPUP | WS_VISIBLE,
+                             100, 100, 200, 200, 0, 0, NULL, NULL);
+    ok(parent != 0, "CreateWindowEx failed\n");
+
+    pt.x = pt.y = 200;
+    hwnd = WindowFromPoint(pt);
+    if (hwnd != parent)
+    {
+        skip("there's another window covering test window\n");
+        DestroyWindow(parent);
+        UnregisterClassA("grid_window", cls.hInstance);
+        return;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(window); i++)
+    {
+        window[i] = CreateWindowExA(0, "grid_window", NULL, WS_CHILD | WS_VISIBLE,
+                                    20 * (i % 10), 20 * (i / 10), 20, 20, parent, 0, NULL, NULL);
+        ok(window[i] != 0, "CreateWindowEx failed\n");
+    }
+
+    for (i = 0; i < ARRAY_SIZE(window); i++)
+    {
+        pt.x = 110 + 20 * (i % 10);
+        pt.y = 110 + 20 * (i / 10);
+        hwnd = WindowFromPoint(pt);
+        ok(hwnd == window[i], "%d: WindowFromPoint returned %p, expected %p\n", i, hwnd, window[i]);
+    }
+
+    overlap = CreateWindowExA(0, "grid_window", NULL, WS_CHILD | WS_VISIBLE,
+                              50, 50, 40, 40, parent, 0, NULL, NULL);
+    ok(overlap != 0, "CreateWindowEx failed\n");
+    SetWindowPos(overlap, HWND_TOP, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+    pt.x = pt.y = 165;
+    hwnd = WindowFromPoint(pt);
+    ok(hwnd == overlap, "WindowFromPoint returned %p, expected %p\n", hwnd, overlap);
+    SetWindowPos(overlap, HWND_BOTTOM, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+    hwnd = WindowFromPoint(pt);
+    ok(hwnd == window[33], "WindowFromPoint returned %p, expected %p\n", hwnd, window[33]);
+
+    /* moved and hidden windows */
+    ShowWindow(window[0], SW_HIDE);
+    pt.x = pt.y = 110;
+    hwnd = WindowFromPoint(pt);
+    ok(hwnd == parent, "WindowFromPoint returned %p, expected %p\n", hwnd, parent);
+    SetWindowPos(window[99], HWND_TOP, 0, 0, 0, 0, SWP_NOSIZE | SWP_NOACTIVATE);
+    hwnd = WindowFromPoint(pt);
+    ok(hwnd == window[99], "WindowFromPoint returned %p, expected %p\n", hwnd, window[99]);
+    pt.x = pt.y = 290;
+    hwnd = WindowFromPoint(pt);
+    ok(hwnd == parent, "WindowFromPoint returned %p, expected %p\n", hwnd, parent);
+
+    /* children spread over the whole coordinate range */
+    SetWindowPos(window[98], 0, -0x7ffffff0, -0x7ffffff0, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
+    SetWindowPos(window[97], 0, 0x7fffffe0, 0x7fffffe0, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
+    pt.x = 130;
+    pt.y = 110;
+    hwnd = WindowFromPoint(pt);
+    ok(hwnd == window[1], "WindowFromPoint returned %p, expected %p\n", hwnd, window[1]);
+    pt.x = pt.y = 285;
+    hwnd = WindowFromPoint(pt);
+    ok(hwnd == parent, "WindowFromPoint returned %p, expected %p\n", hwnd, parent);
+
+    DestroyWindow(parent);
+    ret = UnregisterClassA("grid_window", cls.hInstance);
+    ok(ret, "UnregisterClass(grid_window) failed\n");
+}
+
 static void simulate_click(int x, int y)
 {
     INPUT input[2];
@@ -9242,6 +9324,147 @@ static void test_window_from_point(const char *argv0)
     DestroyWindow(hwnd);
 }
 
+static void other_process_window_proc(HWND parent)
+{
+    HANDLE start_event, end_event;
+    HWND child, grandchild;
+
+    start_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_opw_start");
+    ok(start_event != 0, "OpenEvent failed\n");
+    end_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_opw_end");
+    ok(end_event != 0, "OpenEvent failed\n");
+
+    child = CreateWindowExA(0, "static", "static", WS_CHILD | WS_VISIBLE,
+            10, 10, 100, 50, parent, (HMENU)0x1234, NULL, NULL);
+    ok(child != 0, "CreateWindowEx failed\n");
+    grandchild = CreateWindowExA(0, "static", "static", WS_CHILD | WS_VISIBLE,
+            5, 5, 20, 20, child, (HMENU)0x5678, NULL, NULL);
+    ok(grandchild != 0, "CreateWindowEx failed\n");
+    SetWindowLongPtrA(child, GWLP_USERDATA, 0xbeef);
+    SetEvent(start_event);
+
+    ok(wait_for_event(end_event, 5000), "didn't get end_event\n");
+    CloseHandle(start_event);
+    CloseHandle(end_event);
+}
+
+static void test_other_process_window(const char *argv0)
+{
+    HWND hwnd, child, grandchild;
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmd[MAX_PATH];
+    HANDLE start_event, end_event;
+    DWORD tid, pid;
+    POINT origin;
+    RECT rect;
+
+    hwnd = CreateWindowExA(0, "MainWindowClass", NULL, WS_POPUP | WS_VISIBLE,
+            100, 100, 200, 100, 0, 0, NULL, NULL);
+    ok(hwnd != 0, "CreateWindowEx failed\n");
+
+    start_event = CreateEventA(NULL, FALSE, FALSE, "test_opw_start");
+    ok(start_event != 0, "CreateEvent failed\n");
+    end_event = CreateEventA(NULL, FALSE, FALSE, "test_opw_end");
+    ok(end_event != 0, "CreateEvent failed\n");
+
+    sprintf(cmd, "%s win other_process_window %p\n", argv0, hwnd);
+    memset(&startup, 0, sizeof(startup));
+    startup.cb = sizeof(startup);
+    ok(CreateProcessA(NULL, cmd, NULL, NULL, FALSE, 0, NULL, NULL,
+                &startup, &info), "CreateProcess failed.\n");
+    ok(wait_for_event(start_event, 5000), "didn't get start_event\n");
+
+    child = GetWindow(hwnd, GW_CHILD);
+    ok(child != 0, "child window not found\n");
+    grandchild = GetWindow(child, GW_CHILD);
+    ok(grandchild != 0, "grandchild window not found\n");
+
+    ok(IsWindow(child), "IsWindow failed\n");
+    tid = GetWindowThreadProcessId(child, &pid);
+    ok(tid == info.dwThreadId, "got tid %04x, expected %04x\n", tid, info.dwThreadId);
+    ok(pid == info.dwProcessId, "got pid %04x, expected %04x\n", pid, info.dwProcessId);
+    ok(GetParent(grandchild) == child, "GetParent returned %p, expected %p\n", GetParent(grandchild), child);
+    ok(GetAncestor(grandchild, GA_PARENT) == child, "GetAncestor returned %p, expected %p\n",
+       GetAncestor(grandchild, GA_PARENT), child);
+    ok(GetAncestor(grandchild, GA_ROOT) == hwnd, "GetAncestor returned %p, expected %p\n",
+       GetAncestor(grandchild, GA_ROOT), hwnd);
+    ok(GetWindowLongA(child, GWL_STYLE) == (WS_CHILD | WS_VISIBLE), "got style %08x\n",
+       GetWindowLongA(child, GWL_STYLE));
+    ok(GetWindowLongPtrA(grandchild, GWLP_ID) == 0x5678, "got id %lx\n",
+       GetWindowLongPtrA(grandchild, GWLP_ID));
+    ok(GetWindowLongPtrA(child, GWLP_USERDATA) == 0xbeef, "got user data %lx\n",
+       GetWindowLongPtrA(child, GWLP_USERDATA));
+    ok(IsWindowVisible(grandchild), "grandchild is not visible\n");
+
+    origin.x = origin.y = 0;
+    ClientToScreen(hwnd, &origin);
+    GetWindowRect(grandchild, &rect);
+    ok(rect.left == origin.x + 15 && rect.top == origin.y + 15 &&
+       rect.right == origin.x + 35 && rect.bottom == origin.y + 35,
+       "got window rect %s\n", wine_dbgstr_rect(&rect));
+
+    /* changes made by the owner thread must be visible right away */
+    SetWindowPos(child, 0, 30, 20, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
+    GetWindowRect(grandchild, &rect);
+    ok(rect.left == origin.x + 35 && rect.top == origin.y + 25 &&
+       rect.right == origin.x + 55 && rect.bottom == origin.y + 45,
+       "got window rect %s\n", wine_dbgstr_rect(&rect));
+    if (pGetWindowInfo)
+    {
+        WINDOWINFO wi;
+
+        wi.cbSize = sizeof(wi);
+        ok(pGetWindowInfo(grandchild, &wi), "GetWindowInfo failed: %u\n", GetLastError());
+        ok(EqualRect(&wi.rcWindow, &rect), "got window rect %s\n", wine_dbgstr_rect(&wi.rcWindow));
+        ok(wi.dwStyle == (WS_CHILD | WS_VISIBLE), "got style %08x\n", wi.dwStyle);
+    }
+    ShowWindow(child, SW_HIDE);
+    ok(!IsWindowVisible(grandchild), "grandchild is visible\n");
+    SetWindowLongPtrA(child, GWLP_USERDATA, 0xcafe);
+    ok(GetWindowLongPtrA(child, GWLP_USERDATA) == 0xcafe, "got user data %lx\n",
+       GetWindowLongPtrA(child, GWLP_USERDATA));
+
+    SetEvent(end_event);
+    winetest_wait_child_process(info.hProcess);
+    ok(!IsWindow(child), "child window still exists\n");
+    ok(!IsWindow(grandchild), "grandchild window still exists\n");
+    if (pGetWindowInfo)
+    {
+        WINDOWINFO wi;
+
+        wi.cbSize = sizeof(wi);
+        SetLastError(0xdeadbeef);
+        ok(!pGetWindowInfo(child, &wi), "GetWindowInfo succeeded\n");
+        ok(GetLastError() == ERROR_INVALID_WINDOW_HANDLE, "got error %u\n", GetLastError());
+    }
+    CloseHandle(start_event);
+    CloseHandle(end_event);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+
+    DestroyWindow(hwnd);
+}
+
+static void test_other_process_window_shared(const char *argv0)
+{
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmd[MAX_PATH];
+
+    /* run the same checks in a process that reads the shared window state */
+    sprintf(cmd, "%s win other_process_window_shared", argv0);
+    memset(&startup, 0, sizeof(startup));
+    startup.cb = sizeof(startup);
+    SetEnvironmentVariableA("WINEFASTWIN", "1");
+    ok(CreateProcessA(NULL, cmd, NULL, NULL, FALSE, 0, NULL, NULL,
+                &startup, &info), "CreateProcess failed.\n");
+    SetEnvironmentVariableA("WINEFASTWIN", NULL);
+    winetest_wait_child_process(info.hProcess);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+}
+
 static void test_map_points(void)
 {
     BOOL ret;
@@ -11545,6 +11768,15 @@ START_TEST(win)
         return;
     }
 
+    if (argc==4 && !strcmp(argv[2], "other_process_window"))
+    {
+        HWND hwnd;
+
+        sscanf(argv[3], "%p", &hwnd);
+        other_process_window_proc(hwnd);
+        return;
+    }
+
     if (argc==3 && !strcmp(argv[2], "winproc_limit"))
     {
         test_winproc_limit();
@@ -11553,6 +11785,12 @@ START_TEST(win)
 
     if (!RegisterWindowClasses()) assert(0);
 
+    if (argc==3 && !strcmp(argv[2], "other_process_window_shared"))
+    {
+        test_other_process_window(argv[0]);
+        return;
+    }
+
     hwndMain = CreateWindowExA(/*WS_EX_TOOLWINDOW*/ 0, "MainWindowClass", "Main window",
                                WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX |
                                WS_MAXIMIZEBOX | WS_POPUP | WS_VISIBLE,
@@ -11588,7 +11826,10 @@ START_TEST(win)
 
     /* Add the tests below this line */
     test_child_window_from_point();
+    test_window_from_point_grid();
     test_window_from_point(argv[0]);
+    test_other_process_window(argv[0]);
+    test_other_process_window_shared(argv[0]);
     test_thick_child_size(hwndMain);
     test_fullscreen();
     test_hwnd_message();
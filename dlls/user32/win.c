@@ -103,6 +103,9 @@ static inline void set_win_data( void *ptr, LONG_PTR val, UINT size )
 
 static void *user_handles[NB_USER_HANDLES];
 
+static struct window_shared *window_shared_area;
+static BOOL window_shared_disabled;
+
 /***********************************************************************
  *           alloc_user_handle
  */
@@ -187,6 +190,87 @@ void *free_user_handle( HANDLE handle, enum user_obj_type type )
 }
 
 
+/***********************************************************************
+ *           get_window_shared_area
+ *
+ * Map the window state shared area, if enabled with WINEFASTWIN and
+ * supported by the server.
+ */
+static const struct window_shared *get_window_shared_area(void)
+{
+    struct window_shared *area;
+    HANDLE handle = 0;
+    SIZE_T size = 0;
+    const char *env;
+
+    if (window_shared_area || window_shared_disabled) return window_shared_area;
+
+    if (!(env = getenv( "WINEFASTWIN" )) || !atoi( env ))
+    {
+        window_shared_disabled = TRUE;
+        return NULL;
+    }
+
+    SERVER_START_REQ( get_window_shared_area )
+    {
+        if (!wine_server_call( req ))
+        {
+            handle = wine_server_ptr_handle( reply->handle );
+            size   = reply->size;
+        }
+    }
+    SERVER_END_REQ;
+
+    if (handle && size >= NB_USER_HANDLES * sizeof(*area) &&
+        (area = MapViewOfFile( handle, FILE_MAP_READ, 0, 0, size )))
+    {
+        if (InterlockedCompareExchangePointer( (void **)&window_shared_area, area, NULL ))
+            UnmapViewOfFile( area );  /* another thread mapped it first */
+    }
+    else window_shared_disabled = TRUE;
+    if (handle) CloseHandle( handle );
+    return window_shared_area;
+}
+
+
+/* order the reads of a shared slot against the reads of its sequence counter */
+static inline void shared_read_barrier(void)
+{
+#ifdef __GNUC__
+    __sync_synchronize();
+#endif
+}
+
+
+/***********************************************************************
+ *           get_shared_window
+ *
+ * Get a consistent copy of the state of a window of another thread from
+ * the shared area. Returns FALSE if the server has to be asked instead.
+ */
+static BOOL get_shared_window( HWND hwnd, struct window_shared *info )
+{
+    const volatile struct window_shared *shared;
+    const struct window_shared *area;
+    UINT index = USER_HANDLE_TO_INDEX( hwnd ), seq, i;
+
+    if (index >= NB_USER_HANDLES || !(area = get_window_shared_area())) return FALSE;
+
+    shared = &area[index];
+    for (i = 0; i < 16; i++)  /* the server is not going to hold the slot for long */
+    {
+        if ((seq = shared->seq) & 1) continue;
+        shared_read_barrier();
+        *info = *shared;
+        shared_read_barrier();
+        if (shared->seq != seq) continue;
+        if (!info->handle) return FALSE;
+        return info->handle == (UINT)(UINT_PTR)hwnd || !HIWORD(hwnd) || HIWORD(hwnd) == 0xffff;
+    }
+    return FALSE;
+}
+
+
 /***********************************************************************
  *           create_window_handle
  *
@@ -371,15 +455,24 @@ static HWND *list_window_parents( HWND hwnd )
     for (;;)
     {
         if (!(win = WIN_GetPtr( current ))) goto empty;
-        if (win == WND_OTHER_PROCESS) break;  /* need to do it the hard way */
-        if (win == WND_DESKTOP)
+        if (win == WND_OTHER_PROCESS)
+        {
+            struct window_shared info;
+
+            if (!get_shared_window( current, &info )) break;  /* need to do it the hard way */
+            list[pos] = current = wine_server_ptr_handle( info.parent );
+        }
+        else if (win == WND_DESKTOP)
         {
             if (!pos) goto empty;
             list[pos] = 0;
             return list;
         }
-        list[pos] = current = win->parent;
-        WIN_ReleasePtr( win );
+        else
+        {
+            list[pos] = current = win->parent;
+            WIN_ReleasePtr( win );
+        }
         if (!current) return list;
         if (++pos == size - 1)
         {
@@ -726,6 +819,10 @@ HWND WIN_GetFullHandle( HWND hwnd )
     }
     else  /* may belong to another process */
     {
+        struct window_shared info;
+
+        if (get_shared_window( hwnd, &info )) return wine_server_ptr_handle( info.handle );
+
         SERVER_START_REQ( get_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -824,6 +921,68 @@ ULONG WIN_SetStyle( HWND hwnd, ULONG set_bits, ULONG clear_bits )
 }
 
 
+/***********************************************************************
+ *           get_shared_rectangles
+ *
+ * Get the rectangles of a window of another thread from the shared area,
+ * the same way the server computes them. DPI mapping is left to the server.
+ */
+static BOOL get_shared_rectangles( HWND hwnd, enum coords_relative relative, RECT *rectWindow, RECT *rectClient )
+{
+    struct window_shared info, parent;
+    RECT window_rect, client_rect, rect;
+    HWND ptr;
+
+    if (!get_shared_window( hwnd, &info ) || info.dpi != get_thread_dpi()) return FALSE;
+
+    SetRect( &window_rect, info.window_rect.left, info.window_rect.top,
+             info.window_rect.right, info.window_rect.bottom );
+    SetRect( &client_rect, info.client_rect.left, info.client_rect.top,
+             info.client_rect.right, info.client_rect.bottom );
+
+    switch (relative)
+    {
+    case COORDS_CLIENT:
+        rect = client_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &window_rect );
+        break;
+    case COORDS_WINDOW:
+        rect = window_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &client_rect );
+        break;
+    case COORDS_PARENT:
+        if (!info.parent) break;
+        if (!get_shared_window( wine_server_ptr_handle( info.parent ), &parent )) return FALSE;
+        if (parent.ex_style & WS_EX_LAYOUTRTL)
+        {
+            SetRect( &rect, parent.client_rect.left, parent.client_rect.top,
+                     parent.client_rect.right, parent.client_rect.bottom );
+            mirror_rect( &rect, &window_rect );
+            mirror_rect( &rect, &client_rect );
+        }
+        break;
+    case COORDS_SCREEN:
+        for (ptr = wine_server_ptr_handle( info.parent ); ptr; ptr = wine_server_ptr_handle( parent.parent ))
+        {
+            if (!get_shared_window( ptr, &parent )) return FALSE;
+            if (!parent.parent) break;  /* desktop window */
+            OffsetRect( &window_rect, parent.client_rect.left, parent.client_rect.top );
+            OffsetRect( &client_rect, parent.client_rect.left, parent.client_rect.top );
+        }
+        break;
+    default:
+        return FALSE;
+    }
+    if (rectWindow) *rectWindow = window_rect;
+    if (rectClient) *rectClient = client_rect;
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           WIN_GetRectangles
  *
@@ -932,6 +1091,8 @@ BOOL WIN_GetRectangles( HWND hwnd, enum coords_relative relative, RECT *rectWind
     }
 
 other_process:
+    if (get_shared_rectangles( hwnd, relative, rectWindow, rectClient )) return TRUE;
+
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2347,11 +2508,24 @@ static LONG_PTR WIN_GetWindowLong( HWND hwnd, INT offset, UINT size, BOOL unicod
 
     if (wndPtr == WND_OTHER_PROCESS)
     {
+        struct window_shared info;
+
         if (offset == GWLP_WNDPROC)
         {
             SetLastError( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if (offset < 0 && get_shared_window( hwnd, &info ))
+        {
+            switch(offset)
+            {
+            case GWL_STYLE:      return info.style;
+            case GWL_EXSTYLE:    return info.ex_style;
+            case GWLP_ID:        return info.id;
+            case GWLP_HINSTANCE: return (ULONG_PTR)wine_server_get_ptr( info.instance );
+            case GWLP_USERDATA:  return info.user_data;
+            }
+        }
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -2947,6 +3121,7 @@ INT WINAPI GetWindowTextLengthW( HWND hwnd )
  */
 BOOL WINAPI IsWindow( HWND hwnd )
 {
+    struct window_shared info;
     WND *ptr;
     BOOL ret;
 
@@ -2960,6 +3135,8 @@ BOOL WINAPI IsWindow( HWND hwnd )
     }
 
     /* check other processes */
+    if (get_shared_window( hwnd, &info )) return TRUE;
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2975,6 +3152,7 @@ BOOL WINAPI IsWindow( HWND hwnd )
  */
 DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
 {
+    struct window_shared info;
     WND *ptr;
     DWORD tid = 0;
 
@@ -2994,6 +3172,12 @@ DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
     }
 
     /* check other processes */
+    if (get_shared_window( hwnd, &info ))
+    {
+        if (process) *process = info.pid;
+        return info.tid;
+    }
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -3024,7 +3208,16 @@ HWND WINAPI GetParent( HWND hwnd )
     if (wndPtr == WND_DESKTOP) return 0;
     if (wndPtr == WND_OTHER_PROCESS)
     {
-        LONG style = GetWindowLongW( hwnd, GWL_STYLE );
+        struct window_shared info;
+        LONG style;
+
+        if (get_shared_window( hwnd, &info ))
+        {
+            if (info.style & WS_POPUP) retvalue = wine_server_ptr_handle( info.owner );
+            else if (info.style & WS_CHILD) retvalue = wine_server_ptr_handle( info.parent );
+            return retvalue;
+        }
+        style = GetWindowLongW( hwnd, GWL_STYLE );
         if (style & (WS_POPUP | WS_CHILD))
         {
             SERVER_START_REQ( get_window_tree )
@@ -3054,6 +3247,7 @@ HWND WINAPI GetParent( HWND hwnd )
  */
 HWND WINAPI GetAncestor( HWND hwnd, UINT type )
 {
+    struct window_shared info;
     WND *win;
     HWND *list, ret = 0;
 
@@ -3071,6 +3265,10 @@ HWND WINAPI GetAncestor( HWND hwnd, UINT type )
             ret = win->parent;
             WIN_ReleasePtr( win );
         }
+        else if (get_shared_window( hwnd, &info ))
+        {
+            ret = wine_server_ptr_handle( info.parent );
+        }
         else /* need to query the server */
         {
             SERVER_START_REQ( get_window_tree )
@@ -3788,6 +3986,67 @@ UINT WINAPI GetWindowModuleFileNameW( HWND hwnd, LPWSTR module, UINT size )
     return GetModuleFileNameW( hinst, module, size );
 }
 
+/******************************************************************************
+ *              get_other_process_window_info
+ *
+ * Retrieve the server side parts of the window info with a single server call.
+ * The last error is not set on failure, the caller retries with separate calls.
+ */
+static BOOL get_other_process_window_info( HWND hwnd, WINDOWINFO *info )
+{
+    void *batch[3];
+    unsigned int status;
+
+    SERVER_START_REQ( get_window_rectangles )
+    {
+        req->handle = wine_server_user_handle( hwnd );
+        req->relative = COORDS_SCREEN;
+        req->dpi = get_thread_dpi();
+        batch[0] = req;
+        SERVER_START_REQ( set_window_info )
+        {
+            req->handle = wine_server_user_handle( hwnd );
+            req->flags  = 0;  /* don't set anything, just retrieve */
+            req->extra_offset = -1;
+            batch[1] = req;
+            SERVER_START_REQ( set_class_info )
+            {
+                req->window = wine_server_user_handle( hwnd );
+                req->flags = 0;
+                req->extra_offset = -1;
+                batch[2] = req;
+                if (!(status = wine_server_call_batch( batch, ARRAY_SIZE(batch) )))
+                {
+                    info->atomWindowType = reply->old_atom;
+                    status = reply->__header.error;
+                }
+            }
+            SERVER_END_REQ;
+            if (!status)
+            {
+                info->dwStyle = reply->old_style;
+                info->dwExStyle = reply->old_ex_style;
+                status = reply->__header.error;
+            }
+        }
+        SERVER_END_REQ;
+        if (!status && !(status = reply->__header.error))
+        {
+            info->rcWindow.left   = reply->window.left;
+            info->rcWindow.top    = reply->window.top;
+            info->rcWindow.right  = reply->window.right;
+            info->rcWindow.bottom = reply->window.bottom;
+            info->rcClient.left   = reply->client.left;
+            info->rcClient.top    = reply->client.top;
+            info->rcClient.right  = reply->client.right;
+            info->rcClient.bottom = reply->client.bottom;
+        }
+    }
+    SERVER_END_REQ;
+    return !status;
+}
+
+
 /******************************************************************************
  *              GetWindowInfo (USER32.@)
  *
@@ -3795,17 +4054,28 @@ UINT WINAPI GetWindowModuleFileNameW( HWND hwnd, LPWSTR module, UINT size )
  */
 BOOL WINAPI DECLSPEC_HOTPATCH GetWindowInfo( HWND hwnd, PWINDOWINFO pwi)
 {
+    WND *win;
+
     if (!pwi) return FALSE;
-    if (!WIN_GetRectangles( hwnd, COORDS_SCREEN, &pwi->rcWindow, &pwi->rcClient )) return FALSE;
 
-    pwi->dwStyle = GetWindowLongW(hwnd, GWL_STYLE);
-    pwi->dwExStyle = GetWindowLongW(hwnd, GWL_EXSTYLE);
+    win = WIN_GetPtr( hwnd );
+    if (win && win != WND_OTHER_PROCESS && win != WND_DESKTOP) WIN_ReleasePtr( win );
+
+    /* on failure, use separate calls so that the errors are the same */
+    if (win != WND_OTHER_PROCESS || !get_other_process_window_info( hwnd, pwi ))
+    {
+        if (!WIN_GetRectangles( hwnd, COORDS_SCREEN, &pwi->rcWindow, &pwi->rcClient )) return FALSE;
+
+        pwi->dwStyle = GetWindowLongW(hwnd, GWL_STYLE);
+        pwi->dwExStyle = GetWindowLongW(hwnd, GWL_EXSTYLE);
+        pwi->atomWindowType = GetClassLongW( hwnd, GCW_ATOM );
+    }
+
     pwi->dwWindowStatus = ((GetActiveWindow() == hwnd) ? WS_ACTIVECAPTION : 0);
 
     pwi->cxWindowBorders = pwi->rcClient.left - pwi->rcWindow.left;
     pwi->cyWindowBorders = pwi->rcWindow.bottom - pwi->rcClient.bottom;
 
-    pwi->atomWindowType = GetClassLongW( hwnd, GCW_ATOM );
     pwi->wCreatorVersion = 0x0400;
 
     return TRUE;
@@ -36,6 +36,7 @@ struct __server_iovec
 };
 
 #define __SERVER_MAX_DATA 5
+#define __SERVER_MAX_BATCH 16
 
 struct __server_request_info
 {
@@ -50,6 +51,7 @@ struct __server_request_info
 };
 
 extern unsigned int FARCALL wine_server_call( void *req_ptr );
+extern unsigned int CDECL wine_server_call_batch( void **reqs, unsigned int count );
 extern void CDECL wine_server_send_fd( int fd );
 extern int CDECL wine_server_fd_to_handle( int fd, unsigned int access, unsigned int attributes, HANDLE *handle );
 extern int CDECL wine_server_handle_to_fd( HANDLE handle, unsigned int access, int *unix_fd, unsigned int *options );
@@ -729,6 +729,74 @@ struct rawinput_device
 };
 
 
+struct fast_sync_slot
+{
+    int            state;
+    unsigned int   generation;
+    unsigned int   max;
+    unsigned int   __pad;
+};
+#define FAST_SYNC_SERVER_OWNED 0x80000000
+
+enum fast_sync_type
+{
+    FAST_SYNC_NONE,
+    FAST_SYNC_MANUAL_EVENT,
+    FAST_SYNC_AUTO_EVENT,
+    FAST_SYNC_SEMAPHORE
+};
+
+
+#define REGISTRY_GENERATIONS 16384
+
+
+struct queue_shared
+{
+    unsigned int   wake_bits;
+    unsigned int   changed_bits;
+    unsigned int   post_seq;
+    unsigned int   __pad;
+};
+#define QUEUE_SHARED_SLOTS 16384
+
+
+struct posted_message
+{
+    user_handle_t  win;
+    unsigned int   msg;
+    lparam_t       wparam;
+    lparam_t       lparam;
+    int            x;
+    int            y;
+    unsigned int   time;
+    unsigned int   seq;
+};
+
+
+struct window_shared
+{
+    unsigned int   seq;
+    user_handle_t  handle;
+    user_handle_t  parent;
+    user_handle_t  owner;
+    process_id_t   pid;
+    thread_id_t    tid;
+    unsigned int   style;
+    unsigned int   ex_style;
+    unsigned int   id;
+    unsigned int   dpi;
+    mod_handle_t   instance;
+    lparam_t       user_data;
+    rectangle_t    window_rect;
+    rectangle_t    client_rect;
+};
+#define WINDOW_SHARED_SLOTS ((LAST_USER_HANDLE - FIRST_USER_HANDLE + 1) >> 1)
+
+
+
+
+
+
 
 
 
@@ -1440,6 +1508,36 @@ struct open_semaphore_reply
 
 
 
+struct get_fast_sync_area_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_fast_sync_area_reply
+{
+    struct reply_header __header;
+    data_size_t  size;
+    char __pad_12[4];
+};
+
+
+
+struct get_fast_sync_obj_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct get_fast_sync_obj_reply
+{
+    struct reply_header __header;
+    int          type;
+    unsigned int index;
+    unsigned int generation;
+    unsigned int access;
+};
+
+
+
 struct create_file_request
 {
     struct request_header __header;
@@ -1522,6 +1620,8 @@ struct get_handle_fd_reply
     int          cacheable;
     unsigned int access;
     unsigned int options;
+    unsigned int comp_flags;
+    char __pad_28[4];
 };
 enum server_fd_type
 {
@@ -2680,7 +2780,25 @@ struct get_key_value_reply
     struct reply_header __header;
     int          type;
     data_size_t  total;
+    unsigned int gen_index;
+    unsigned int generation;
+    unsigned int global_gen;
     /* VARARG(data,bytes); */
+    char __pad_28[4];
+};
+
+
+
+struct get_registry_generations_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_registry_generations_reply
+{
+    struct reply_header __header;
+    data_size_t  size;
+    char __pad_12[4];
 };
 
 
@@ -2773,6 +2891,24 @@ struct set_registry_notification_reply
 
 
 
+struct get_registry_save_stats_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_registry_save_stats_reply
+{
+    struct reply_header __header;
+    timeout_t    last_save;
+    timeout_t    last_duration;
+    timeout_t    max_duration;
+    timeout_t    last_snapshot;
+    unsigned int saves;
+    unsigned int failures;
+};
+
+
+
 struct create_timer_request
 {
     struct request_header __header;
@@ -3065,6 +3201,37 @@ struct get_queue_status_reply
 
 
 
+struct get_queue_shared_request
+{
+    struct request_header __header;
+    int          map;
+};
+struct get_queue_shared_reply
+{
+    struct reply_header __header;
+    obj_handle_t handle;
+    data_size_t  size;
+    unsigned int index;
+    int          x;
+    int          y;
+    char __pad_28[4];
+};
+
+
+
+struct post_local_messages_request
+{
+    struct request_header __header;
+    unsigned int changed_bits;
+    /* VARARG(msgs,posted_messages); */
+};
+struct post_local_messages_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct get_process_idle_event_request
 {
     struct request_header __header;
@@ -3672,6 +3839,19 @@ struct get_window_tree_reply
 };
 
 
+struct get_window_shared_area_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_window_shared_area_reply
+{
+    struct reply_header __header;
+    obj_handle_t   handle;
+    data_size_t    size;
+};
+
+
 struct set_window_pos_request
 {
     struct request_header __header;
@@ -4974,6 +5154,24 @@ struct get_system_handles_reply
 
 
 
+struct get_handle_table_stats_request
+{
+    struct request_header __header;
+    obj_handle_t    handle;
+};
+struct get_handle_table_stats_reply
+{
+    struct reply_header __header;
+    unsigned int    count;
+    unsigned int    capacity;
+    unsigned int    blocks;
+    int             last;
+    mem_size_t      lookups;
+    mem_size_t      misses;
+};
+
+
+
 struct create_mailslot_request
 {
     struct request_header __header;
@@ -5286,8 +5484,8 @@ struct create_completion_request
     struct request_header __header;
     unsigned int access;
     unsigned int concurrent;
+    int          local;
     /* VARARG(objattr,object_attributes); */
-    char __pad_20[4];
 };
 struct create_completion_reply
 {
@@ -5332,6 +5530,18 @@ struct add_completion_reply
 
 
 
+struct share_completion_request
+{
+    struct request_header __header;
+    obj_handle_t  handle;
+};
+struct share_completion_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct remove_completion_request
 {
     struct request_header __header;
@@ -5669,6 +5879,22 @@ struct terminate_job_reply
 };
 
 
+
+struct batch_request
+{
+    struct request_header __header;
+    /* VARARG(requests,bytes); */
+    char __pad_12[4];
+};
+struct batch_reply
+{
+    struct reply_header __header;
+    int            count;
+    /* VARARG(replies,bytes); */
+    char __pad_12[4];
+};
+
+
 enum request
 {
     REQ_new_process,
@@ -5713,6 +5939,8 @@ enum request
     REQ_release_semaphore,
     REQ_query_semaphore,
     REQ_open_semaphore,
+    REQ_get_fast_sync_area,
+    REQ_get_fast_sync_obj,
     REQ_create_file,
     REQ_open_file_object,
     REQ_alloc_file_handle,
@@ -5783,12 +6011,14 @@ enum request
     REQ_enum_key,
     REQ_set_key_value,
     REQ_get_key_value,
+    REQ_get_registry_generations,
     REQ_enum_key_value,
     REQ_delete_key_value,
     REQ_load_registry,
     REQ_unload_registry,
     REQ_save_registry,
     REQ_set_registry_notification,
+    REQ_get_registry_save_stats,
     REQ_create_timer,
     REQ_open_timer,
     REQ_set_timer,
@@ -5808,6 +6038,8 @@ enum request
     REQ_set_queue_fd,
     REQ_set_queue_mask,
     REQ_get_queue_status,
+    REQ_get_queue_shared,
+    REQ_post_local_messages,
     REQ_get_process_idle_event,
     REQ_send_message,
     REQ_post_quit_message,
@@ -5841,6 +6073,7 @@ enum request
     REQ_get_window_children,
     REQ_get_window_children_from_point,
     REQ_get_window_tree,
+    REQ_get_window_shared_area,
     REQ_set_window_pos,
     REQ_get_window_rectangles,
     REQ_get_window_text,
@@ -5918,6 +6151,7 @@ enum request
     REQ_set_security_object,
     REQ_get_security_object,
     REQ_get_system_handles,
+    REQ_get_handle_table_stats,
     REQ_create_mailslot,
     REQ_set_mailslot_info,
     REQ_create_directory,
@@ -5940,6 +6174,7 @@ enum request
     REQ_create_completion,
     REQ_open_completion,
     REQ_add_completion,
+    REQ_share_completion,
     REQ_remove_completion,
     REQ_query_completion,
     REQ_set_completion_info,
@@ -5962,6 +6197,7 @@ enum request
     REQ_set_job_limits,
     REQ_set_job_completion_port,
     REQ_terminate_job,
+    REQ_batch,
     REQ_NB_REQUESTS
 };
 
@@ -6011,6 +6247,8 @@ union generic_request
     struct release_semaphore_request release_semaphore_request;
     struct query_semaphore_request query_semaphore_request;
     struct open_semaphore_request open_semaphore_request;
+    struct get_fast_sync_area_request get_fast_sync_area_request;
+    struct get_fast_sync_obj_request get_fast_sync_obj_request;
     struct create_file_request create_file_request;
     struct open_file_object_request open_file_object_request;
     struct alloc_file_handle_request alloc_file_handle_request;
@@ -6081,12 +6319,14 @@ union generic_request
     struct enum_key_request enum_key_request;
     struct set_key_value_request set_key_value_request;
     struct get_key_value_request get_key_value_request;
+    struct get_registry_generations_request get_registry_generations_request;
     struct enum_key_value_request enum_key_value_request;
     struct delete_key_value_request delete_key_value_request;
     struct load_registry_request load_registry_request;
     struct unload_registry_request unload_registry_request;
     struct save_registry_request save_registry_request;
     struct set_registry_notification_request set_registry_notification_request;
+    struct get_registry_save_stats_request get_registry_save_stats_request;
     struct create_timer_request create_timer_request;
     struct open_timer_request open_timer_request;
     struct set_timer_request set_timer_request;
@@ -6106,6 +6346,8 @@ union generic_request
     struct set_queue_fd_request set_queue_fd_request;
     struct set_queue_mask_request set_queue_mask_request;
     struct get_queue_status_request get_queue_status_request;
+    struct get_queue_shared_request get_queue_shared_request;
+    struct post_local_messages_request post_local_messages_request;
     struct get_process_idle_event_request get_process_idle_event_request;
     struct send_message_request send_message_request;
     struct post_quit_message_request post_quit_message_request;
@@ -6139,6 +6381,7 @@ union generic_request
     struct get_window_children_request get_window_children_request;
     struct get_window_children_from_point_request get_window_children_from_point_request;
     struct get_window_tree_request get_window_tree_request;
+    struct get_window_shared_area_request get_window_shared_area_request;
     struct set_window_pos_request set_window_pos_request;
     struct get_window_rectangles_request get_window_rectangles_request;
     struct get_window_text_request get_window_text_request;
@@ -6216,6 +6459,7 @@ union generic_request
     struct set_security_object_request set_security_object_request;
     struct get_security_object_request get_security_object_request;
     struct get_system_handles_request get_system_handles_request;
+    struct get_handle_table_stats_request get_handle_table_stats_request;
     struct create_mailslot_request create_mailslot_request;
     struct set_mailslot_info_request set_mailslot_info_request;
     struct create_directory_request create_directory_request;
@@ -6238,6 +6482,7 @@ union generic_request
     struct create_completion_request create_completion_request;
     struct open_completion_request open_completion_request;
     struct add_completion_request add_completion_request;
+    struct share_completion_request share_completion_request;
     struct remove_completion_request remove_completion_request;
     struct query_completion_request query_completion_request;
     struct set_completion_info_request set_completion_info_request;
@@ -6260,6 +6505,7 @@ union generic_request
     struct set_job_limits_request set_job_limits_request;
     struct set_job_completion_port_request set_job_completion_port_request;
     struct terminate_job_request terminate_job_request;
+    struct batch_request batch_request;
 };
 union generic_reply
 {
@@ -6307,6 +6553,8 @@ union generic_reply
     struct release_semaphore_reply release_semaphore_reply;
     struct query_semaphore_reply query_semaphore_reply;
     struct open_semaphore_reply open_semaphore_reply;
+    struct get_fast_sync_area_reply get_fast_sync_area_reply;
+    struct get_fast_sync_obj_reply get_fast_sync_obj_reply;
     struct create_file_reply create_file_reply;
     struct open_file_object_reply open_file_object_reply;
     struct alloc_file_handle_reply alloc_file_handle_reply;
@@ -6377,12 +6625,14 @@ union generic_reply
     struct enum_key_reply enum_key_reply;
     struct set_key_value_reply set_key_value_reply;
     struct get_key_value_reply get_key_value_reply;
+    struct get_registry_generations_reply get_registry_generations_reply;
     struct enum_key_value_reply enum_key_value_reply;
     struct delete_key_value_reply delete_key_value_reply;
     struct load_registry_reply load_registry_reply;
     struct unload_registry_reply unload_registry_reply;
     struct save_registry_reply save_registry_reply;
     struct set_registry_notification_reply set_registry_notification_reply;
+    struct get_registry_save_stats_reply get_registry_save_stats_reply;
     struct create_timer_reply create_timer_reply;
     struct open_timer_reply open_timer_reply;
     struct set_timer_reply set_timer_reply;
@@ -6402,6 +6652,8 @@ union generic_reply
     struct set_queue_fd_reply set_queue_fd_reply;
     struct set_queue_mask_reply set_queue_mask_reply;
     struct get_queue_status_reply get_queue_status_reply;
+    struct get_queue_shared_reply get_queue_shared_reply;
+    struct post_local_messages_reply post_local_messages_reply;
     struct get_process_idle_event_reply get_process_idle_event_reply;
     struct send_message_reply send_message_reply;
     struct post_quit_message_reply post_quit_message_reply;
@@ -6435,6 +6687,7 @@ union generic_reply
     struct get_window_children_reply get_window_children_reply;
     struct get_window_children_from_point_reply get_window_children_from_point_reply;
     struct get_window_tree_reply get_window_tree_reply;
+    struct get_window_shared_area_reply get_window_shared_area_reply;
     struct set_window_pos_reply set_window_pos_reply;
     struct get_window_rectangles_reply get_window_rectangles_reply;
     struct get_window_text_reply get_window_text_reply;
@@ -6512,6 +6765,7 @@ union generic_reply
     struct set_security_object_reply set_security_object_reply;
     struct get_security_object_reply get_security_object_reply;
     struct get_system_handles_reply get_system_handles_reply;
+    struct get_handle_table_stats_reply get_handle_table_stats_reply;
     struct create_mailslot_reply create_mailslot_reply;
     struct set_mailslot_info_reply set_mailslot_info_reply;
     struct create_directory_reply create_directory_reply;
@@ -6534,6 +6788,7 @@ union generic_reply
     struct create_completion_reply create_completion_reply;
     struct open_completion_reply open_completion_reply;
     struct add_completion_reply add_completion_reply;
+    struct share_completion_reply share_completion_reply;
     struct remove_completion_reply remove_completion_reply;
     struct query_completion_reply query_completion_reply;
     struct set_completion_info_reply set_completion_info_reply;
@@ -6556,8 +6811,9 @@ union generic_reply
     struct set_job_limits_reply set_job_limits_reply;
     struct set_job_completion_port_reply set_job_completion_port_reply;
     struct terminate_job_reply terminate_job_reply;
+    struct batch_reply batch_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 572
+#define SERVER_PROTOCOL_VERSION 585
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
@@ -49,6 +49,7 @@ struct completion
     struct object  obj;
     struct list    queue;
     unsigned int   depth;
+    int            local;   /* packets are queued in the creating process, can't be shared */
 };
 
 static void completion_dump( struct object*, int );
@@ -131,7 +132,7 @@ static unsigned int completion_map_access( struct object *obj, unsigned int acce
 }
 
 static struct completion *create_completion( struct object *root, const struct unicode_str *name,
-                                             unsigned int attr, unsigned int concurrent,
+                                             unsigned int attr, unsigned int concurrent, int local,
                                              const struct security_descriptor *sd )
 {
     struct completion *completion;
@@ -142,6 +143,7 @@ static struct completion *create_completion( struct object *root, const struct u
         {
             list_init( &completion->queue );
             completion->depth = 0;
+            completion->local = local && !name->len;
         }
     }
 
@@ -153,6 +155,12 @@ struct completion *get_completion_obj( struct process *process, obj_handle_t han
     return (struct completion *) get_handle_obj( process, handle, access, &completion_ops );
 }
 
+/* check if an object is a completion port whose packets are queued in the creating process */
+int is_local_completion( struct object *obj )
+{
+    return obj->ops == &completion_ops && ((struct completion *)obj)->local;
+}
+
 void add_completion( struct completion *completion, apc_param_t ckey, apc_param_t cvalue,
                      unsigned int status, apc_param_t information )
 {
@@ -182,7 +190,7 @@ DECL_HANDLER(create_completion)
 
     if (!objattr) return;
 
-    if ((completion = create_completion( root, &name, objattr->attributes, req->concurrent, sd )))
+    if ((completion = create_completion( root, &name, objattr->attributes, req->concurrent, req->local, sd )))
     {
         reply->handle = alloc_handle( current->process, completion, req->access, objattr->attributes );
         release_object( completion );
@@ -213,6 +221,16 @@ DECL_HANDLER(add_completion)
     release_object( completion );
 }
 
+/* let a process-local completion port be shared */
+DECL_HANDLER(share_completion)
+{
+    struct completion* completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+
+    if (!completion) return;
+    completion->local = 0;
+    release_object( completion );
+}
+
 /* get completion from completion port */
 DECL_HANDLER(remove_completion)
 {
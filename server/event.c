@@ -38,25 +38,29 @@
 
 struct event
 {
-    struct object  obj;             /* object header */
-    int            manual_reset;    /* is it a manual reset event? */
-    int            signaled;        /* event has been signaled */
+    struct object          obj;             /* object header */
+    int                    manual_reset;    /* is it a manual reset event? */
+    struct fast_sync_slot *sync;            /* signaled state, possibly shared with clients */
+    struct fast_sync_slot  private_sync;    /* state storage when not shared */
 };
 
 static void event_dump( struct object *obj, int verbose );
 static struct object_type *event_get_type( struct object *obj );
+static int event_add_queue( struct object *obj, struct wait_queue_entry *entry );
+static void event_remove_queue( struct object *obj, struct wait_queue_entry *entry );
 static int event_signaled( struct object *obj, struct wait_queue_entry *entry );
 static void event_satisfied( struct object *obj, struct wait_queue_entry *entry );
 static unsigned int event_map_access( struct object *obj, unsigned int access );
 static int event_signal( struct object *obj, unsigned int access);
+static void event_destroy( struct object *obj );
 
 static const struct object_ops event_ops =
 {
     sizeof(struct event),      /* size */
     event_dump,                /* dump */
     event_get_type,            /* get_type */
-    add_queue,                 /* add_queue */
-    remove_queue,              /* remove_queue */
+    event_add_queue,           /* add_queue */
+    event_remove_queue,        /* remove_queue */
     event_signaled,            /* signaled */
     event_satisfied,           /* satisfied */
     event_signal,              /* signal */
@@ -69,7 +73,7 @@ static const struct object_ops event_ops =
     default_unlink_name,       /* unlink_name */
     no_open_file,              /* open_file */
     no_close_handle,           /* close_handle */
-    no_destroy                 /* destroy */
+    event_destroy              /* destroy */
 };
 
 
@@ -118,7 +122,8 @@ struct event *create_event( struct object *root, const struct unicode_str *name,
         {
             /* initialize it if it didn't already exist */
             event->manual_reset = manual_reset;
-            event->signaled     = initial_state;
+            event->sync         = alloc_fast_sync_slot( &event->private_sync );
+            set_fast_sync_state( event->sync, initial_state ? 1 : 0 );
         }
     }
     return event;
@@ -129,24 +134,33 @@ struct event *get_event_obj( struct process *process, obj_handle_t handle, unsig
     return (struct event *)get_handle_obj( process, handle, access, &event_ops );
 }
 
+struct fast_sync_slot *get_event_fast_sync( struct object *obj, int *type )
+{
+    struct event *event = (struct event *)obj;
+
+    if (obj->ops != &event_ops) return NULL;
+    *type = event->manual_reset ? FAST_SYNC_MANUAL_EVENT : FAST_SYNC_AUTO_EVENT;
+    return event->sync;
+}
+
 void pulse_event( struct event *event )
 {
-    event->signaled = 1;
+    set_fast_sync_state( event->sync, 1 );
     /* wake up all waiters if manual reset, a single one otherwise */
     wake_up( &event->obj, !event->manual_reset );
-    event->signaled = 0;
+    set_fast_sync_state( event->sync, 0 );
 }
 
 void set_event( struct event *event )
 {
-    event->signaled = 1;
+    set_fast_sync_state( event->sync, 1 );
     /* wake up all waiters if manual reset, a single one otherwise */
     wake_up( &event->obj, !event->manual_reset );
 }
 
 void reset_event( struct event *event )
 {
-    event->signaled = 0;
+    set_fast_sync_state( event->sync, 0 );
 }
 
 static void event_dump( struct object *obj, int verbose )
@@ -154,7 +168,7 @@ static void event_dump( struct object *obj, int verbose )
     struct event *event = (struct event *)obj;
     assert( obj->ops == &event_ops );
     fprintf( stderr, "Event manual=%d signaled=%d\n",
-             event->manual_reset, event->signaled );
+             event->manual_reset, get_fast_sync_state( event->sync ) );
 }
 
 static struct object_type *event_get_type( struct object *obj )
@@ -164,11 +178,25 @@ static struct object_type *event_get_type( struct object *obj )
     return get_object_type( &str );
 }
 
+static int event_add_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct event *event = (struct event *)obj;
+    assert( obj->ops == &event_ops );
+    return fast_sync_add_queue( obj, entry, event->sync );
+}
+
+static void event_remove_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct event *event = (struct event *)obj;
+    assert( obj->ops == &event_ops );
+    fast_sync_remove_queue( obj, entry, event->sync );
+}
+
 static int event_signaled( struct object *obj, struct wait_queue_entry *entry )
 {
     struct event *event = (struct event *)obj;
     assert( obj->ops == &event_ops );
-    return event->signaled;
+    return get_fast_sync_state( event->sync ) != 0;
 }
 
 static void event_satisfied( struct object *obj, struct wait_queue_entry *entry )
@@ -176,7 +204,7 @@ static void event_satisfied( struct object *obj, struct wait_queue_entry *entry
     struct event *event = (struct event *)obj;
     assert( obj->ops == &event_ops );
     /* Reset if it's an auto-reset event */
-    if (!event->manual_reset) event->signaled = 0;
+    if (!event->manual_reset) set_fast_sync_state( event->sync, 0 );
 }
 
 static unsigned int event_map_access( struct object *obj, unsigned int access )
@@ -202,6 +230,13 @@ static int event_signal( struct object *obj, unsigned int access )
     return 1;
 }
 
+static void event_destroy( struct object *obj )
+{
+    struct event *event = (struct event *)obj;
+    assert( obj->ops == &event_ops );
+    free_fast_sync_slot( event->sync );
+}
+
 struct keyed_event *create_keyed_event( struct object *root, const struct unicode_str *name,
                                         unsigned int attr, const struct security_descriptor *sd )
 {
@@ -337,7 +372,7 @@ DECL_HANDLER(query_event)
     if (!(event = get_event_obj( current->process, req->handle, EVENT_QUERY_STATE ))) return;
 
     reply->manual_reset = event->manual_reset;
-    reply->state = event->signaled;
+    reply->state = get_fast_sync_state( event->sync ) != 0;
 
     release_object( event );
 }
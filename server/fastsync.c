@@ -0,0 +1,221 @@
+/*
+ * Server-side fast synchronization support
+ *
+ * Copyright (C) 2019 Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * The state of events and semaphores can be stored in a memory area that is
+ * mapped into every client, which allows clients to signal and acquire these
+ * objects with atomic operations instead of a server round trip.
+ *
+ * As long as no thread is blocked on an object in the server, its state can
+ * be modified by anybody. Once a thread is queued on the object, the server
+ * sets FAST_SYNC_SERVER_OWNED in the state and clients fall back to server
+ * requests, so that the server can wake up the waiters. The flag is cleared
+ * again when the wait queue becomes empty.
+ *
+ * Clients cache the slot of each handle along with the slot generation, and
+ * only modify the state together with the generation they cached. The
+ * generation is changed whenever such a mapping may have become stale, i.e.
+ * when the slot is freed and when a handle to the object is closed from
+ * another process, so that clients go back to the server instead of using
+ * the slot of an unrelated object.
+ *
+ * This is only enabled when the server is started with WINEFASTSYNC set.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#include <unistd.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+
+#include "file.h"
+#include "handle.h"
+#include "thread.h"
+#include "request.h"
+
+#define FAST_SYNC_SLOTS 65536
+
+static int fast_sync_enabled = -1;
+static int fast_sync_fd = -1;
+static struct fast_sync_slot *fast_sync_area;
+static unsigned int *free_slots;       /* stack of free slot indices */
+static unsigned int free_count;        /* number of entries in free_slots */
+static unsigned int next_slot;         /* first never used slot */
+
+static int init_fast_sync_area(void)
+{
+    const char *env;
+    size_t size = FAST_SYNC_SLOTS * sizeof(*fast_sync_area);
+    void *ptr;
+
+    if (fast_sync_enabled != -1) return fast_sync_enabled;
+
+    fast_sync_enabled = 0;
+    if (!(env = getenv( "WINEFASTSYNC" )) || !atoi( env )) return 0;
+
+    if (!(free_slots = mem_alloc( FAST_SYNC_SLOTS * sizeof(*free_slots) ))) return 0;
+    if ((fast_sync_fd = create_temp_file( size )) == -1) goto failed;
+    if ((ptr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fast_sync_fd, 0 )) == MAP_FAILED)
+    {
+        close( fast_sync_fd );
+        fast_sync_fd = -1;
+        goto failed;
+    }
+    fast_sync_area = ptr;
+    fast_sync_enabled = 1;
+    return 1;
+
+failed:
+    fprintf( stderr, "wineserver: failed to create fast synchronization area\n" );
+    free( free_slots );
+    free_slots = NULL;
+    return 0;
+}
+
+static inline int is_shared_slot( const struct fast_sync_slot *slot )
+{
+    return fast_sync_area && slot >= fast_sync_area && slot < fast_sync_area + FAST_SYNC_SLOTS;
+}
+
+/* allocate a shared slot for an object; fall back to the private slot if none is available */
+struct fast_sync_slot *alloc_fast_sync_slot( struct fast_sync_slot *private_slot )
+{
+    struct fast_sync_slot *slot = private_slot;
+
+    if (init_fast_sync_area())
+    {
+        if (free_count) slot = &fast_sync_area[free_slots[--free_count]];
+        else if (next_slot < FAST_SYNC_SLOTS) slot = &fast_sync_area[next_slot++];
+    }
+    slot->state = 0;
+    slot->max = 0;
+    return slot;
+}
+
+void free_fast_sync_slot( struct fast_sync_slot *slot )
+{
+    if (!is_shared_slot( slot )) return;
+    interlocked_xchg_add( (int *)&slot->generation, 1 );
+    slot->state = 0;
+    slot->max = 0;
+    free_slots[free_count++] = slot - fast_sync_area;
+}
+
+/* make clients drop their cached mappings of the object's slot */
+void invalidate_fast_sync( struct object *obj )
+{
+    struct fast_sync_slot *slot;
+    int type;
+
+    if (!(slot = get_event_fast_sync( obj, &type ))) slot = get_semaphore_fast_sync( obj, &type );
+    if (slot && is_shared_slot( slot )) interlocked_xchg_add( (int *)&slot->generation, 1 );
+}
+
+/* atomically replace the state if it still matches old_state, preserving the owner flag */
+int update_fast_sync_state( struct fast_sync_slot *slot, unsigned int new_state, unsigned int old_state )
+{
+    /* only the server changes the flag, so it can't change under us */
+    int owned = slot->state & FAST_SYNC_SERVER_OWNED;
+
+    return interlocked_cmpxchg( &slot->state, new_state | owned, old_state | owned ) == (int)(old_state | owned);
+}
+
+void set_fast_sync_state( struct fast_sync_slot *slot, unsigned int state )
+{
+    while (!update_fast_sync_state( slot, state, get_fast_sync_state( slot ) )) /* nothing */;
+}
+
+/* take or give back ownership of the state depending on whether the object has waiters */
+void update_fast_sync_owner( struct fast_sync_slot *slot, struct object *obj )
+{
+    int owned = list_empty( &obj->wait_queue ) ? 0 : FAST_SYNC_SERVER_OWNED;
+    int state;
+
+    for (;;)
+    {
+        state = slot->state;
+        if ((state & FAST_SYNC_SERVER_OWNED) == owned) break;
+        if (interlocked_cmpxchg( &slot->state, state ^ FAST_SYNC_SERVER_OWNED, state ) == state) break;
+    }
+}
+
+/* add_queue implementation for objects using a fast sync slot */
+int fast_sync_add_queue( struct object *obj, struct wait_queue_entry *entry,
+                         struct fast_sync_slot *slot )
+{
+    add_queue( obj, entry );
+    update_fast_sync_owner( slot, obj );
+    return 1;
+}
+
+/* remove_queue implementation for objects using a fast sync slot */
+void fast_sync_remove_queue( struct object *obj, struct wait_queue_entry *entry,
+                             struct fast_sync_slot *slot )
+{
+    remove_queue( obj, entry );
+    update_fast_sync_owner( slot, obj );
+}
+
+/* retrieve the shared memory area */
+DECL_HANDLER(get_fast_sync_area)
+{
+    if (!init_fast_sync_area())
+    {
+        set_error( STATUS_NOT_SUPPORTED );
+        return;
+    }
+    reply->size = FAST_SYNC_SLOTS * sizeof(*fast_sync_area);
+    send_client_fd( current->process, fast_sync_fd, 0 );
+}
+
+/* retrieve the slot used by an object */
+DECL_HANDLER(get_fast_sync_obj)
+{
+    struct fast_sync_slot *slot;
+    struct object *obj;
+    int type;
+
+    if (!(obj = get_handle_obj( current->process, req->handle, 0, NULL ))) return;
+
+    if (!(slot = get_event_fast_sync( obj, &type ))) slot = get_semaphore_fast_sync( obj, &type );
+
+    if (slot && is_shared_slot( slot ))
+    {
+        reply->type   = type;
+        reply->index      = slot - fast_sync_area;
+        reply->generation = slot->generation;
+        reply->access     = get_handle_access( current->process, req->handle );
+    }
+    else reply->type = FAST_SYNC_NONE;
+
+    release_object( obj );
+}
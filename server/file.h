@@ -157,6 +157,8 @@ extern struct mapping *get_mapping_obj( struct process *process, obj_handle_t ha
 extern struct file *get_mapping_file( struct process *process, client_ptr_t base,
                                       unsigned int access, unsigned int sharing );
 extern void free_mapped_views( struct process *process );
+extern int create_temp_file( file_pos_t size );
+extern struct object *create_shared_mapping( mem_size_t size, void **ptr );
 extern int get_page_size(void);
 
 /* device functions */
@@ -176,6 +178,7 @@ extern struct dir *get_dir_obj( struct process *process, obj_handle_t handle, un
 /* completion */
 
 extern struct completion *get_completion_obj( struct process *process, obj_handle_t handle, unsigned int access );
+extern int is_local_completion( struct object *obj );
 extern void add_completion( struct completion *completion, apc_param_t ckey, apc_param_t cvalue,
                             unsigned int status, apc_param_t information );
 
@@ -33,6 +33,7 @@
 #include "windef.h"
 #include "winternl.h"
 
+#include "file.h"
 #include "handle.h"
 #include "process.h"
 #include "thread.h"
@@ -41,18 +42,22 @@
 
 struct handle_entry
 {
-    struct object *ptr;       /* object */
-    unsigned int   access;    /* access rights */
+    struct object *ptr;       /* object, NULL if the entry is free */
+    unsigned int   access;    /* access rights, or index of the next free entry */
 };
 
 struct handle_table
 {
-    struct object        obj;         /* object header */
-    struct process      *process;     /* process owning this table */
-    int                  count;       /* number of allocated entries */
-    int                  last;        /* last used entry */
-    int                  free;        /* first entry that may be free */
-    struct handle_entry *entries;     /* handle entries */
+    struct object         obj;         /* object header */
+    struct process       *process;     /* process owning this table */
+    int                   count;       /* number of allocated entries */
+    int                   last;        /* last used entry */
+    int                   free;        /* head of the list of free entries, -1 if empty */
+    int                   used;        /* number of entries in use */
+    int                   nb_blocks;   /* size of the blocks array */
+    struct handle_entry **blocks;      /* blocks of handle entries */
+    unsigned __int64      lookups;     /* number of handle lookups */
+    unsigned __int64      misses;      /* number of lookups of invalid handles */
 };
 
 static struct handle_table *global_table;
@@ -63,9 +68,13 @@ static struct handle_table *global_table;
 #define RESERVED_CLOSE_PROTECT (HANDLE_FLAG_PROTECT_FROM_CLOSE << RESERVED_SHIFT)
 #define RESERVED_ALL           (RESERVED_INHERIT | RESERVED_CLOSE_PROTECT)
 
-#define MIN_HANDLE_ENTRIES  32
 #define MAX_HANDLE_ENTRIES  0x00ffffff
 
+/* entries are allocated in fixed-size blocks that never move once allocated */
+#define HANDLE_BLOCK_SHIFT  8
+#define HANDLE_BLOCK_SIZE   (1 << HANDLE_BLOCK_SHIFT)
+#define MIN_HANDLE_BLOCKS   16
+
 
 /* handle to table index conversion */
 
@@ -79,6 +88,12 @@ static inline int handle_to_index( obj_handle_t handle )
     return (handle >> 2) - 1;
 }
 
+/* return the entry for a given index, which must be below the table count */
+static inline struct handle_entry *get_entry( struct handle_table *table, int index )
+{
+    return table->blocks[index >> HANDLE_BLOCK_SHIFT] + (index & (HANDLE_BLOCK_SIZE - 1));
+}
+
 /* global handle conversion */
 
 #define HANDLE_OBFUSCATOR 0x544a4def
@@ -146,12 +161,12 @@ static void handle_table_dump( struct object *obj, int verbose )
 
     assert( obj->ops == &handle_table_ops );
 
-    fprintf( stderr, "Handle table last=%d count=%d process=%p\n",
-             table->last, table->count, table->process );
+    fprintf( stderr, "Handle table last=%d count=%d used=%d process=%p\n",
+             table->last, table->count, table->used, table->process );
     if (!verbose) return;
-    entry = table->entries;
-    for (i = 0; i <= table->last; i++, entry++)
+    for (i = 0; i <= table->last; i++)
     {
+        entry = get_entry( table, i );
         if (!entry->ptr) continue;
         fprintf( stderr, "    %04x: %p %08x ",
                  index_to_handle(i), entry->ptr, entry->access );
@@ -172,20 +187,24 @@ static void handle_table_destroy( struct object *obj )
     /* first notify all objects that handles are being closed */
     if (table->process)
     {
-        for (i = 0, entry = table->entries; i <= table->last; i++, entry++)
+        for (i = 0; i <= table->last; i++)
         {
-            struct object *obj = entry->ptr;
+            struct object *obj = get_entry( table, i )->ptr;
             if (obj) obj->ops->close_handle( obj, table->process, index_to_handle(i) );
         }
     }
 
-    for (i = 0, entry = table->entries; i <= table->last; i++, entry++)
+    for (i = 0; i <= table->last; i++)
     {
-        struct object *obj = entry->ptr;
+        struct object *obj;
+
+        entry = get_entry( table, i );
+        obj = entry->ptr;
         entry->ptr = NULL;
         if (obj) release_object_from_handle( obj );
     }
-    free( table->entries );
+    for (i = 0; i < table->count >> HANDLE_BLOCK_SHIFT; i++) free( table->blocks[i] );
+    free( table->blocks );
 }
 
 /* close all the process handles and free the handle table */
@@ -197,60 +216,101 @@ void close_process_handles( struct process *process )
     if (table) release_object( table );
 }
 
+/* add a block of entries to a handle table */
+static int grow_handle_table( struct handle_table *table )
+{
+    struct handle_entry *block;
+    int index = table->count >> HANDLE_BLOCK_SHIFT;
+
+    if (index == table->nb_blocks)
+    {
+        struct handle_entry **new_blocks;
+        int nb_blocks = max( table->nb_blocks * 2, MIN_HANDLE_BLOCKS );
+
+        if (!(new_blocks = realloc( table->blocks, nb_blocks * sizeof(*new_blocks) )))
+        {
+            set_error( STATUS_INSUFFICIENT_RESOURCES );
+            return 0;
+        }
+        table->blocks    = new_blocks;
+        table->nb_blocks = nb_blocks;
+    }
+    if (!(block = calloc( HANDLE_BLOCK_SIZE, sizeof(*block) )))
+    {
+        set_error( STATUS_INSUFFICIENT_RESOURCES );
+        return 0;
+    }
+    table->blocks[index] = block;
+    table->count += HANDLE_BLOCK_SIZE;
+    return 1;
+}
+
 /* allocate a new handle table */
 struct handle_table *alloc_handle_table( struct process *process, int count )
 {
     struct handle_table *table;
 
-    if (count < MIN_HANDLE_ENTRIES) count = MIN_HANDLE_ENTRIES;
     if (!(table = alloc_object( &handle_table_ops )))
         return NULL;
-    table->process = process;
-    table->count   = count;
-    table->last    = -1;
-    table->free    = 0;
-    if ((table->entries = mem_alloc( count * sizeof(*table->entries) ))) return table;
-    release_object( table );
-    return NULL;
-}
-
-/* grow a handle table */
-static int grow_handle_table( struct handle_table *table )
-{
-    struct handle_entry *new_entries;
-    int count = min( table->count * 2, MAX_HANDLE_ENTRIES );
-
-    if (count == table->count ||
-        !(new_entries = realloc( table->entries, count * sizeof(struct handle_entry) )))
+    table->process   = process;
+    table->count     = 0;
+    table->last      = -1;
+    table->free      = -1;
+    table->used      = 0;
+    table->nb_blocks = 0;
+    table->blocks    = NULL;
+    table->lookups   = 0;
+    table->misses    = 0;
+    while (table->count < count)
     {
-        set_error( STATUS_INSUFFICIENT_RESOURCES );
-        return 0;
+        if (grow_handle_table( table )) continue;
+        release_object( table );
+        return NULL;
     }
-    table->entries = new_entries;
-    table->count   = count;
-    return 1;
+    return table;
 }
 
-/* allocate the first free entry in the handle table */
+/* allocate a free entry in the handle table */
 static obj_handle_t alloc_entry( struct handle_table *table, void *obj, unsigned int access )
 {
-    struct handle_entry *entry = table->entries + table->free;
+    struct handle_entry *entry;
     int i;
 
-    for (i = table->free; i <= table->last; i++, entry++) if (!entry->ptr) goto found;
-    if (i >= table->count)
+    if ((i = table->free) != -1)
+    {
+        entry = get_entry( table, i );
+        table->free = entry->access;
+    }
+    else  /* all entries up to the last one are in use */
     {
-        if (!grow_handle_table( table )) return 0;
-        entry = table->entries + i;  /* the entries may have moved */
+        i = table->last + 1;
+        if (i >= MAX_HANDLE_ENTRIES)
+        {
+            set_error( STATUS_INSUFFICIENT_RESOURCES );
+            return 0;
+        }
+        if (i >= table->count && !grow_handle_table( table )) return 0;
+        entry = get_entry( table, i );
     }
-    table->last = i;
- found:
-    table->free = i + 1;
+    if (i > table->last) table->last = i;
+    table->used++;
     entry->ptr    = grab_object_for_handle( obj );
     entry->access = access;
     return index_to_handle(i);
 }
 
+/* free an entry of the handle table */
+static void free_entry( struct handle_table *table, int index )
+{
+    struct handle_entry *entry = get_entry( table, index );
+
+    entry->ptr    = NULL;
+    entry->access = table->free;
+    table->free   = index;
+    table->used--;
+    while (table->last >= 0 && !get_entry( table, table->last )->ptr) table->last--;
+}
+
 /* allocate a handle for an object, incrementing its refcount */
 static obj_handle_t alloc_handle_entry( struct process *process, void *ptr,
                                         unsigned int access, unsigned int attr )
@@ -323,33 +383,16 @@ static struct handle_entry *get_handle( struct process *process, obj_handle_t ha
         table = global_table;
     }
     if (!table) return NULL;
+    table->lookups++;
     index = handle_to_index( handle );
-    if (index < 0) return NULL;
-    if (index > table->last) return NULL;
-    entry = table->entries + index;
-    if (!entry->ptr) return NULL;
+    if (index < 0 || index > table->last) goto invalid;
+    entry = get_entry( table, index );
+    if (!entry->ptr) goto invalid;
     return entry;
-}
-
-/* attempt to shrink a table */
-static void shrink_handle_table( struct handle_table *table )
-{
-    struct handle_entry *entry = table->entries + table->last;
-    struct handle_entry *new_entries;
-    int count = table->count;
 
-    while (table->last >= 0)
-    {
-        if (entry->ptr) break;
-        table->last--;
-        entry--;
-    }
-    if (table->last >= count / 4) return;  /* no need to shrink */
-    if (count < MIN_HANDLE_ENTRIES * 2) return;  /* too small to shrink */
-    count /= 2;
-    if (!(new_entries = realloc( table->entries, count * sizeof(*new_entries) ))) return;
-    table->count   = count;
-    table->entries = new_entries;
+invalid:
+    table->misses++;
+    return NULL;
 }
 
 /* copy the handle table of the parent process */
@@ -363,29 +406,34 @@ struct handle_table *copy_handle_table( struct process *process, struct process
     assert( parent_table );
     assert( parent_table->obj.ops == &handle_table_ops );
 
-    if (!(table = alloc_handle_table( process, parent_table->count )))
+    if (!(table = alloc_handle_table( process, parent_table->last + 1 )))
         return NULL;
 
-    if ((table->last = parent_table->last) >= 0)
+    for (i = 0; i <= parent_table->last; i++)
     {
-        struct handle_entry *ptr = table->entries;
-        memcpy( ptr, parent_table->entries, (table->last + 1) * sizeof(struct handle_entry) );
-        for (i = 0; i <= table->last; i++, ptr++)
-        {
-            if (!ptr->ptr) continue;
-            if (ptr->access & RESERVED_INHERIT) grab_object_for_handle( ptr->ptr );
-            else ptr->ptr = NULL; /* don't inherit this entry */
-        }
+        struct handle_entry *entry = get_entry( parent_table, i );
+
+        if (!entry->ptr || !(entry->access & RESERVED_INHERIT)) continue;  /* don't inherit this entry */
+        *get_entry( table, i ) = *entry;
+        grab_object_for_handle( entry->ptr );
+        table->last = i;
+        table->used++;
+    }
+    /* chain the remaining entries in increasing order */
+    for (i = table->last; i >= 0; i--)
+    {
+        struct handle_entry *entry = get_entry( table, i );
+
+        if (entry->ptr) continue;
+        entry->access = table->free;
+        table->free = i;
     }
-    /* attempt to shrink the table */
-    shrink_handle_table( table );
     return table;
 }
 
 /* close a handle and decrement the refcount of the associated object */
 unsigned int close_handle( struct process *process, obj_handle_t handle )
 {
-    struct handle_table *table;
     struct handle_entry *entry;
     struct object *obj;
 
@@ -393,10 +441,12 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     if (entry->access & RESERVED_CLOSE_PROTECT) return STATUS_HANDLE_NOT_CLOSABLE;
     obj = entry->ptr;
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
-    entry->ptr = NULL;
-    table = handle_is_global(handle) ? global_table : process->handles;
-    if (entry < table->entries + table->free) table->free = entry - table->entries;
-    if (entry == table->entries + table->last) shrink_handle_table( table );
+    /* the owning process can't drop its cached fast sync mapping itself */
+    if (!current || process != current->process) invalidate_fast_sync( obj );
+    if (handle_is_global(handle))
+        free_entry( global_table, handle_to_index( handle_global_to_local(handle) ));
+    else
+        free_entry( process->handles, handle_to_index( handle ));
     release_object_from_handle( obj );
     return STATUS_SUCCESS;
 }
@@ -476,8 +526,9 @@ obj_handle_t find_inherited_handle( struct process *process, const struct object
 
     if (!table) return 0;
 
-    for (i = 0, ptr = table->entries; i <= table->last; i++, ptr++)
+    for (i = 0; i <= table->last; i++)
     {
+        ptr = get_entry( table, i );
         if (!ptr->ptr) continue;
         if (ptr->ptr->ops != ops) continue;
         if (ptr->access & RESERVED_INHERIT) return index_to_handle(i);
@@ -496,8 +547,9 @@ obj_handle_t enumerate_handles( struct process *process, const struct object_ops
 
     if (!table) return 0;
 
-    for (i = *index, entry = &table->entries[i]; i <= table->last; i++, entry++)
+    for (i = *index; (int)i <= table->last; i++)
     {
+        entry = get_entry( table, i );
         if (!entry->ptr) continue;
         if (entry->ptr->ops != ops) continue;
         *index = i + 1;
@@ -635,10 +687,27 @@ DECL_HANDLER(set_handle_info)
 DECL_HANDLER(dup_handle)
 {
     struct process *src, *dst = NULL;
+    struct object *obj;
+    int local = 0;
 
     reply->handle = 0;
     if ((src = get_process_from_handle( req->src_process, PROCESS_DUP_HANDLE )))
     {
+        /* the packets of a process-local port are only known to its owner, which
+         * shares the port before duplicating or closing it */
+        if ((obj = get_handle_obj( src, req->src_handle, 0, NULL )))
+        {
+            local = is_local_completion( obj );
+            release_object( obj );
+        }
+        else clear_error();
+
+        if (local)
+        {
+            set_error( STATUS_ACCESS_DENIED );
+            release_object( src );
+            return;
+        }
         if (req->options & DUP_HANDLE_MAKE_GLOBAL)
         {
             reply->handle = duplicate_handle( src, req->src_handle, NULL,
@@ -794,8 +863,9 @@ static int enum_handles( struct process *process, void *user )
     if (!table)
         return 0;
 
-    for (i = 0, entry = table->entries; i <= table->last; i++, entry++)
+    for (i = 0; (int)i <= table->last; i++)
     {
+        entry = get_entry( table, i );
         if (!entry->ptr) continue;
         if (!info->handle)
         {
@@ -832,3 +902,23 @@ DECL_HANDLER(get_system_handles)
         enum_processes( enum_handles, &info );
     }
 }
+
+/* retrieve the handle table statistics of a process */
+DECL_HANDLER(get_handle_table_stats)
+{
+    struct process *process;
+    struct handle_table *table;
+
+    if (!(process = get_process_from_handle( req->handle, PROCESS_QUERY_LIMITED_INFORMATION ))) return;
+    if ((table = process->handles))
+    {
+        reply->count    = table->used;
+        reply->capacity = table->count;
+        reply->blocks   = table->count >> HANDLE_BLOCK_SHIFT;
+        reply->last     = table->last;
+        reply->lookups  = table->lookups;
+        reply->misses   = table->misses;
+    }
+    else set_error( STATUS_PROCESS_IS_TERMINATING );
+    release_object( process );
+}
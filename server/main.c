@@ -26,6 +26,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 #include <unistd.h>
 #ifdef HAVE_GETOPT_H
@@ -43,6 +44,7 @@ int debug_level = 0;
 int foreground = 0;
 timeout_t master_socket_timeout = 3 * -TICKS_PER_SEC;  /* master socket timeout, default is 3 seconds */
 const char *server_argv0;
+static int convert_format = -1;  /* registry format to convert to */
 
 /* parse-line args */
 
@@ -55,6 +57,7 @@ static void usage( FILE *fh )
     fprintf(fh, "   -h,    --help            display this help message\n");
     fprintf(fh, "   -k[n], --kill[=n]        kill the current wineserver, optionally with signal n\n");
     fprintf(fh, "   -p[n], --persistent[=n]  make server persistent, optionally for n seconds\n");
+    fprintf(fh, "   -r f,  --convert-registry=f  convert the registry to format f (binary or text) and exit\n");
     fprintf(fh, "   -v,    --version         display version information and exit\n");
     fprintf(fh, "   -w,    --wait            wait until the current wineserver terminates\n");
     fprintf(fh, "\n");
@@ -71,6 +74,7 @@ static void parse_args( int argc, char *argv[] )
         {"help",        0, NULL, 'h'},
         {"kill",        2, NULL, 'k'},
         {"persistent",  2, NULL, 'p'},
+        {"convert-registry", 1, NULL, 'r'},
         {"version",     0, NULL, 'v'},
         {"wait",        0, NULL, 'w'},
         { NULL,         0, NULL, 0}
@@ -78,7 +82,7 @@ static void parse_args( int argc, char *argv[] )
 
     server_argv0 = argv[0];
 
-    while ((optc = getopt_long( argc, argv, "d::fhk::p::vw", long_options, NULL )) != -1)
+    while ((optc = getopt_long( argc, argv, "d::fhk::p::r:vw", long_options, NULL )) != -1)
     {
         switch(optc)
         {
@@ -107,6 +111,16 @@ static void parse_args( int argc, char *argv[] )
                 else
                     master_socket_timeout = TIMEOUT_INFINITE;
                 break;
+            case 'r':
+                if (!strcmp( optarg, "binary" )) convert_format = 1;
+                else if (!strcmp( optarg, "text" )) convert_format = 0;
+                else
+                {
+                    usage(stderr);
+                    exit(1);
+                }
+                foreground = 1;
+                break;
             case 'v':
                 fprintf( stderr, "%s\n", wine_get_build_id());
                 exit(0);
@@ -145,6 +159,11 @@ int main( int argc, char *argv[] )
     init_signals();
     init_directories();
     init_registry();
+    if (convert_format != -1)
+    {
+        convert_registry( convert_format );
+        exit(0);
+    }
     main_loop();
     return 0;
 }
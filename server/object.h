@@ -185,6 +185,29 @@ extern struct keyed_event *get_keyed_event_obj( struct process *process, obj_han
 extern void pulse_event( struct event *event );
 extern void set_event( struct event *event );
 extern void reset_event( struct event *event );
+extern struct fast_sync_slot *get_event_fast_sync( struct object *obj, int *type );
+
+/* semaphore functions */
+
+extern struct fast_sync_slot *get_semaphore_fast_sync( struct object *obj, int *type );
+
+/* fast synchronization functions */
+
+extern struct fast_sync_slot *alloc_fast_sync_slot( struct fast_sync_slot *private_slot );
+extern void free_fast_sync_slot( struct fast_sync_slot *slot );
+extern void invalidate_fast_sync( struct object *obj );
+extern int update_fast_sync_state( struct fast_sync_slot *slot, unsigned int new_state, unsigned int old_state );
+extern void set_fast_sync_state( struct fast_sync_slot *slot, unsigned int state );
+extern void update_fast_sync_owner( struct fast_sync_slot *slot, struct object *obj );
+extern int fast_sync_add_queue( struct object *obj, struct wait_queue_entry *entry,
+                                struct fast_sync_slot *slot );
+extern void fast_sync_remove_queue( struct object *obj, struct wait_queue_entry *entry,
+                                    struct fast_sync_slot *slot );
+
+static inline unsigned int get_fast_sync_state( const struct fast_sync_slot *slot )
+{
+    return *(volatile const int *)&slot->state & ~FAST_SYNC_SERVER_OWNED;
+}
 
 /* mutex functions */
 
@@ -210,6 +233,7 @@ extern void debug_exit_thread( struct thread *thread );
 extern unsigned int get_prefix_cpu_mask(void);
 extern void init_registry(void);
 extern void flush_registry(void);
+extern void convert_registry( int binary );
 
 /* signal functions */
 
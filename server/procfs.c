@@ -27,6 +27,9 @@
 #include <signal.h>
 #include <stdarg.h>
 #include <sys/types.h>
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -90,7 +93,8 @@ static int open_proc_lwpctl( struct thread *thread )
 /* handle a SIGCHLD signal */
 void sigchld_callback(void)
 {
-    assert( 0 );  /* should only be called when using ptrace */
+    /* only children of the server itself, such as registry save processes, end up here */
+    while (waitpid( -1, NULL, WNOHANG ) > 0);
 }
 
 /* initialize the process tracing mechanism */
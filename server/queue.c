@@ -83,9 +83,23 @@ struct message
     void                  *data;      /* message data for sent messages */
     unsigned int           data_size; /* size of message data */
     unsigned int           unique_id; /* unique id for nested hw message waits */
+    unsigned int           seq;       /* sequence number of posted messages */
+    struct posted_class   *class;     /* class of posted messages */
+    struct list            class_entry; /* entry in class message list */
     struct message_result *result;    /* result in sender queue */
 };
 
+/* posted messages with the same window and message code, used to look up filtered messages */
+struct posted_class
+{
+    struct list            entry;     /* entry in queue hash bucket */
+    user_handle_t          win;       /* window handle */
+    unsigned int           msg;       /* message code */
+    struct list            msgs;      /* messages of this class in queue order */
+};
+
+#define POSTED_HASH_SIZE 16
+
 struct timer
 {
     struct list     entry;     /* entry in timer list */
@@ -130,6 +144,7 @@ struct msg_queue
     int                    exit_code;       /* exit code of pending quit message */
     int                    cursor_count;    /* per-queue cursor show count */
     struct list            msg_list[NB_MSG_KINDS];  /* lists of messages */
+    struct list            posted_hash[POSTED_HASH_SIZE]; /* classes of posted messages */
     struct list            send_result;     /* stack of sent messages waiting for result */
     struct list            callback_result; /* list of callback messages waiting for result */
     struct message_result *recv_result;     /* stack of received messages waiting for result */
@@ -140,6 +155,8 @@ struct msg_queue
     struct thread_input   *input;           /* thread input descriptor */
     struct hook_table     *hooks;           /* hook table */
     timeout_t              last_get_msg;    /* time of last get message call */
+    struct queue_shared   *shared;          /* state shared with the owning thread */
+    struct queue_shared    private_shared;  /* storage for the state until the client asks to share it */
 };
 
 struct hotkey
@@ -223,9 +240,101 @@ static const struct object_ops thread_input_ops =
 /* pointer to input structure of foreground thread */
 static unsigned int last_input_time;
 
+/* The wake bits of a queue are mirrored into a memory area that is mapped
+ * into the clients once its thread asks for it (WINEFASTMSG). This lets
+ * a thread check its queue status, and post messages to itself that it will
+ * retrieve later, without a server round trip. The area is read-only for the
+ * clients. Messages buffered that way record the sequence number of the next
+ * message posted through the server, so that they can be merged in order
+ * with the messages posted through the server. */
+static int queue_shared_enabled = -1;
+static struct object *queue_shared_mapping;
+static struct queue_shared *queue_shared_area;
+static unsigned int *free_queue_slots;       /* stack of free slot indices */
+static unsigned int free_queue_count;        /* number of entries in free_queue_slots */
+static unsigned int next_queue_slot;         /* first never used slot */
+
 static void queue_hardware_message( struct desktop *desktop, struct message *msg, int always_queue );
 static void free_message( struct message *msg );
 
+/* create the queue shared area on first use */
+static int init_queue_shared_area(void)
+{
+    unsigned int error = get_error();
+    void *ptr;
+
+    if (queue_shared_enabled != -1) return queue_shared_enabled;
+
+    queue_shared_enabled = 0;
+    if (!(free_queue_slots = mem_alloc( QUEUE_SHARED_SLOTS * sizeof(*free_queue_slots) ))) return 0;
+    if (!(queue_shared_mapping = create_shared_mapping( QUEUE_SHARED_SLOTS * sizeof(*queue_shared_area), &ptr )))
+    {
+        fprintf( stderr, "wineserver: failed to create message queue shared area\n" );
+        free( free_queue_slots );
+        free_queue_slots = NULL;
+        set_error( error );
+        return 0;
+    }
+    make_object_static( queue_shared_mapping );
+    queue_shared_area = ptr;
+    queue_shared_enabled = 1;
+    set_error( error );
+    return 1;
+}
+
+static inline int is_shared_queue_slot( const struct queue_shared *shared )
+{
+    return queue_shared_area && shared >= queue_shared_area && shared < queue_shared_area + QUEUE_SHARED_SLOTS;
+}
+
+/* move the state of a queue from its private storage to a shared slot */
+static int share_queue_state( struct msg_queue *queue )
+{
+    struct queue_shared *shared;
+
+    if (is_shared_queue_slot( queue->shared )) return 1;
+    if (!init_queue_shared_area())
+    {
+        set_error( STATUS_NOT_SUPPORTED );
+        return 0;
+    }
+    if (free_queue_count) shared = &queue_shared_area[free_queue_slots[--free_queue_count]];
+    else if (next_queue_slot < QUEUE_SHARED_SLOTS) shared = &queue_shared_area[next_queue_slot++];
+    else
+    {
+        set_error( STATUS_NO_MEMORY );
+        return 0;
+    }
+    *shared = *queue->shared;
+    queue->shared = shared;
+    return 1;
+}
+
+static void free_queue_shared( struct msg_queue *queue )
+{
+    if (!is_shared_queue_slot( queue->shared )) return;
+    memset( queue->shared, 0, sizeof(*queue->shared) );
+    free_queue_slots[free_queue_count++] = queue->shared - queue_shared_area;
+}
+
+/* update the shared copy of the queue bits */
+static inline void update_shared_bits( struct msg_queue *queue )
+{
+    queue->shared->wake_bits = queue->wake_bits;
+    queue->shared->changed_bits = queue->changed_bits;
+}
+
+/* messages posted through the server are numbered POST_SEQ_STRIDE apart; the
+ * numbers in between go to the messages buffered by the client, so that they
+ * sort before the message that had the shared post_seq value they saw */
+#define POST_SEQ_STRIDE 128
+
+/* allocate the sequence number of a message posted through the server */
+static inline unsigned int get_post_seq( struct msg_queue *queue )
+{
+    return queue->shared->post_seq++ * POST_SEQ_STRIDE;
+}
+
 /* set the caret window in a given thread input */
 static void set_caret_window( struct thread_input *input, user_handle_t win )
 {
@@ -298,11 +407,14 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         queue->input           = (struct thread_input *)grab_object( input );
         queue->hooks           = NULL;
         queue->last_get_msg    = current_time;
+        queue->shared          = &queue->private_shared;
+        memset( queue->shared, 0, sizeof(*queue->shared) );
         list_init( &queue->send_result );
         list_init( &queue->callback_result );
         list_init( &queue->pending_timers );
         list_init( &queue->expired_timers );
         for (i = 0; i < NB_MSG_KINDS; i++) list_init( &queue->msg_list[i] );
+        for (i = 0; i < POSTED_HASH_SIZE; i++) list_init( &queue->posted_hash[i] );
 
         thread->queue = queue;
     }
@@ -451,6 +563,7 @@ static inline void set_queue_bits( struct msg_queue *queue, unsigned int bits )
 {
     queue->wake_bits |= bits;
     queue->changed_bits |= bits;
+    update_shared_bits( queue );
     if (is_signaled( queue )) wake_up( &queue->obj, 0 );
 }
 
@@ -459,6 +572,7 @@ static inline void clear_queue_bits( struct msg_queue *queue, unsigned int bits
 {
     queue->wake_bits &= ~bits;
     queue->changed_bits &= ~bits;
+    update_shared_bits( queue );
 }
 
 /* check whether msg is a keyboard message */
@@ -626,6 +740,59 @@ static void free_message( struct message *msg )
     free( msg );
 }
 
+/* check whether a posted message was queued before another one */
+static inline int is_older_message( const struct message *msg, const struct message *other )
+{
+    return (int)(msg->seq - other->seq) < 0;
+}
+
+static inline unsigned int get_posted_hash( user_handle_t win, unsigned int msg )
+{
+    return (win ^ (win >> 4) ^ msg ^ (msg >> 4)) % POSTED_HASH_SIZE;
+}
+
+/* add a posted message to the queue and to the list of its class */
+/* both lists are kept in sequence order; the new message is usually the newest one */
+static int link_posted_message( struct msg_queue *queue, struct message *msg )
+{
+    struct list *list = &queue->msg_list[POST_MESSAGE];
+    struct list *bucket = &queue->posted_hash[get_posted_hash( msg->win, msg->msg )];
+    struct posted_class *class;
+    struct list *ptr;
+
+    LIST_FOR_EACH_ENTRY( class, bucket, struct posted_class, entry )
+        if (class->win == msg->win && class->msg == msg->msg) goto found;
+
+    if (!(class = mem_alloc( sizeof(*class) ))) return 0;
+    class->win = msg->win;
+    class->msg = msg->msg;
+    list_init( &class->msgs );
+    list_add_tail( bucket, &class->entry );
+
+found:
+    msg->class = class;
+    for (ptr = list_tail( list ); ptr; ptr = list_prev( list, ptr ))
+        if (is_older_message( LIST_ENTRY( ptr, struct message, entry ), msg )) break;
+    list_add_after( ptr ? ptr : list, &msg->entry );
+    for (ptr = list_tail( &class->msgs ); ptr; ptr = list_prev( &class->msgs, ptr ))
+        if (is_older_message( LIST_ENTRY( ptr, struct message, class_entry ), msg )) break;
+    list_add_after( ptr ? ptr : &class->msgs, &msg->class_entry );
+    return 1;
+}
+
+/* remove a posted message from the list of its class */
+static void unlink_posted_message( struct message *msg )
+{
+    struct posted_class *class = msg->class;
+
+    list_remove( &msg->class_entry );
+    if (list_empty( &class->msgs ))
+    {
+        list_remove( &class->entry );
+        free( class );
+    }
+}
+
 /* remove (and free) a message from a message list */
 static void remove_queue_message( struct msg_queue *queue, struct message *msg,
                                   enum message_kind kind )
@@ -637,6 +804,7 @@ static void remove_queue_message( struct msg_queue *queue, struct message *msg,
         if (list_empty( &queue->msg_list[kind] )) clear_queue_bits( queue, QS_SENDMESSAGE );
         break;
     case POST_MESSAGE:
+        unlink_posted_message( msg );
         if (list_empty( &queue->msg_list[kind] ) && !queue->quit_message)
             clear_queue_bits( queue, QS_POSTMESSAGE|QS_ALLPOSTMESSAGE );
         if (msg->msg == WM_HOTKEY && --queue->hotkey_count == 0)
@@ -794,16 +962,31 @@ static int get_posted_message( struct msg_queue *queue, user_handle_t win,
                                unsigned int first, unsigned int last, unsigned int flags,
                                struct get_message_reply *reply )
 {
-    struct message *msg;
+    struct message *msg = NULL, *head;
+    struct posted_class *class;
+    struct list *ptr;
+    unsigned int i;
 
-    /* check against the filters */
-    LIST_FOR_EACH_ENTRY( msg, &queue->msg_list[POST_MESSAGE], struct message, entry )
+    if (!win && !first && last == ~0U)
     {
-        if (!match_window( win, msg->win )) continue;
-        if (!check_msg_filter( msg->msg, first, last )) continue;
-        goto found; /* found one */
+        if (!(ptr = list_head( &queue->msg_list[POST_MESSAGE] ))) return 0;
+        msg = LIST_ENTRY( ptr, struct message, entry );
+        goto found;
     }
-    return 0;
+
+    /* check the oldest message of each class against the filters */
+    for (i = 0; i < POSTED_HASH_SIZE; i++)
+    {
+        LIST_FOR_EACH_ENTRY( class, &queue->posted_hash[i], struct posted_class, entry )
+        {
+            if (!check_msg_filter( class->msg, first, last )) continue;
+            head = LIST_ENTRY( list_head( &class->msgs ), struct message, class_entry );
+            if (msg && !is_older_message( head, msg )) continue;
+            if (!match_window( win, class->win )) continue;
+            msg = head;
+        }
+    }
+    if (!msg) return 0;
 
     /* return it to the app */
 found:
@@ -979,6 +1162,14 @@ static void msg_queue_destroy( struct object *obj )
 
     cleanup_results( queue );
     for (i = 0; i < NB_MSG_KINDS; i++) empty_msg_list( &queue->msg_list[i] );
+    for (i = 0; i < POSTED_HASH_SIZE; i++)
+    {
+        while ((ptr = list_head( &queue->posted_hash[i] )))
+        {
+            list_remove( ptr );
+            free( LIST_ENTRY( ptr, struct posted_class, entry ) );
+        }
+    }
 
     LIST_FOR_EACH_ENTRY_SAFE( hotkey, hotkey2, &queue->input->desktop->hotkeys, struct hotkey, entry )
     {
@@ -1006,6 +1197,7 @@ static void msg_queue_destroy( struct object *obj )
     release_object( queue->input );
     if (queue->hooks) release_object( queue->hooks );
     if (queue->fd) release_object( queue->fd );
+    free_queue_shared( queue );
 }
 
 static void msg_queue_poll_event( struct fd *fd, int event )
@@ -1402,8 +1594,13 @@ found:
     free( msg->data );
     msg->data      = NULL;
     msg->data_size = 0;
+    msg->seq       = get_post_seq( hotkey->queue );
 
-    list_add_tail( &hotkey->queue->msg_list[POST_MESSAGE], &msg->entry );
+    if (!link_posted_message( hotkey->queue, msg ))
+    {
+        free_message( msg );
+        return 1;
+    }
     set_queue_bits( hotkey->queue, QS_POSTMESSAGE|QS_ALLPOSTMESSAGE|QS_HOTKEY );
     hotkey->queue->hotkey_count++;
     return 1;
@@ -2058,9 +2255,16 @@ void post_message( user_handle_t win, unsigned int message, lparam_t wparam, lpa
         msg->data      = NULL;
         msg->data_size = 0;
 
+        msg->seq       = get_post_seq( thread->queue );
+
         get_message_defaults( thread->queue, &msg->x, &msg->y, &msg->time );
 
-        list_add_tail( &thread->queue->msg_list[POST_MESSAGE], &msg->entry );
+        if (!link_posted_message( thread->queue, msg ))
+        {
+            free( msg );
+            release_object( thread );
+            return;
+        }
         set_queue_bits( thread->queue, QS_POSTMESSAGE|QS_ALLPOSTMESSAGE );
         if (message == WM_HOTKEY)
         {
@@ -2236,11 +2440,99 @@ DECL_HANDLER(get_queue_status)
         reply->wake_bits    = queue->wake_bits;
         reply->changed_bits = queue->changed_bits;
         queue->changed_bits &= ~req->clear_bits;
+        update_shared_bits( queue );
     }
     else reply->wake_bits = reply->changed_bits = 0;
 }
 
 
+/* retrieve the shared state of the current message queue */
+DECL_HANDLER(get_queue_shared)
+{
+    struct msg_queue *queue = get_current_queue();
+
+    if (!queue || !share_queue_state( queue )) return;
+    reply->index = queue->shared - queue_shared_area;
+    reply->size  = QUEUE_SHARED_SLOTS * sizeof(*queue_shared_area);
+    reply->x     = queue->input->desktop->cursor.x;
+    reply->y     = queue->input->desktop->cursor.y;
+    if (req->map)
+        reply->handle = alloc_handle( current->process, queue_shared_mapping, SECTION_MAP_READ, 0 );
+}
+
+
+/* queue messages that were buffered by the client to the current message queue */
+DECL_HANDLER(post_local_messages)
+{
+    struct msg_queue *queue = get_current_queue();
+    const struct posted_message *posted = get_req_data();
+    data_size_t count = get_req_data_size() / sizeof(*posted);
+    struct message *msg;
+    unsigned int index = 0;
+    int added = 0;
+
+    if (!queue || !count) return;
+
+    /* messages buffered after this batch must not share its numbers */
+    queue->shared->post_seq++;
+
+    for ( ; count; count--, posted++, index++)
+    {
+        if (posted->win)
+        {
+            struct thread *thread = get_window_thread( posted->win );
+
+            if (thread) release_object( thread );
+            if (thread != current)
+            {
+                /* the window has been destroyed, same as queue_cleanup_window */
+                if (posted->msg == WM_QUIT && !queue->quit_message)
+                {
+                    queue->quit_message = 1;
+                    queue->exit_code = posted->wparam;
+                    added = 1;
+                }
+                continue;
+            }
+        }
+        if (!(msg = mem_alloc( sizeof(*msg) ))) break;
+
+        msg->type      = MSG_POSTED;
+        msg->win       = get_user_full_handle( posted->win );
+        msg->msg       = posted->msg;
+        msg->wparam    = posted->wparam;
+        msg->lparam    = posted->lparam;
+        msg->x         = posted->x;
+        msg->y         = posted->y;
+        msg->time      = posted->time;
+        msg->seq       = (posted->seq - 1) * POST_SEQ_STRIDE + 1 + min( index, POST_SEQ_STRIDE - 2 );
+        msg->unique_id = 0;
+        msg->result    = NULL;
+        msg->data      = NULL;
+        msg->data_size = 0;
+
+        /* messages posted through the server in the meantime can be older */
+        if (!link_posted_message( queue, msg ))
+        {
+            free( msg );
+            break;
+        }
+        if (msg->msg == WM_HOTKEY)
+        {
+            set_queue_bits( queue, QS_HOTKEY );
+            queue->hotkey_count++;
+        }
+        added = 1;
+    }
+
+    if (!added) return;
+    queue->wake_bits |= QS_POSTMESSAGE | QS_ALLPOSTMESSAGE;
+    queue->changed_bits |= req->changed_bits & (QS_POSTMESSAGE | QS_ALLPOSTMESSAGE);
+    update_shared_bits( queue );
+    if (is_signaled( queue )) wake_up( &queue->obj, 0 );
+}
+
+
 /* send a message to a thread queue */
 DECL_HANDLER(send_message)
 {
@@ -2301,7 +2593,12 @@ DECL_HANDLER(send_message)
             set_queue_bits( recv_queue, QS_SENDMESSAGE );
             break;
         case MSG_POSTED:
-            list_add_tail( &recv_queue->msg_list[POST_MESSAGE], &msg->entry );
+            msg->seq = get_post_seq( recv_queue );
+            if (!link_posted_message( recv_queue, msg ))
+            {
+                free_message( msg );
+                break;
+            }
             set_queue_bits( recv_queue, QS_POSTMESSAGE|QS_ALLPOSTMESSAGE );
             if (msg->msg == WM_HOTKEY)
             {
@@ -2412,6 +2709,7 @@ DECL_HANDLER(get_message)
     }
     if (filter & QS_INPUT) queue->changed_bits &= ~QS_INPUT;
     if (filter & QS_PAINT) queue->changed_bits &= ~QS_PAINT;
+    update_shared_bits( queue );
 
     /* then check for posted messages */
     if ((filter & QS_POSTMESSAGE) &&
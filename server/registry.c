@@ -30,11 +30,19 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -124,13 +132,41 @@ static struct key_value *find_value( const struct key *key, const struct unicode
 struct save_branch_info
 {
     struct key  *key;
-    const char  *path;
+    const char  *path;       /* path of the text file */
+    const char  *hive_path;  /* path of the binary hive file */
+    int          binary;     /* save the branch in binary format */
+    int          from_text;  /* the branch was loaded from the text file */
 };
 
 #define MAX_SAVE_BRANCH_INFO 3
 static int save_branch_count;
 static struct save_branch_info save_branch_info[MAX_SAVE_BRANCH_INFO];
 
+/* background saving of the registry */
+static void save_poll_event( struct fd *fd, int event );
+
+static const struct fd_ops save_fd_ops =
+{
+    NULL,                     /* get_poll_events */
+    save_poll_event,          /* poll_event */
+    NULL,                     /* flush */
+    NULL,                     /* get_fd_type */
+    NULL,                     /* ioctl */
+    NULL,                     /* queue_async */
+    NULL                      /* reselect_async */
+};
+
+static struct fd *save_fd;              /* pipe from the child process saving the registry */
+static pid_t save_pid;                  /* pid of the child process */
+static unsigned int save_mask;          /* mask of the branches being saved */
+static timeout_t save_start;            /* start time of the current save */
+static timeout_t save_last_time;        /* end time of the last save */
+static timeout_t save_last_duration;    /* duration of the last save */
+static timeout_t save_max_duration;     /* longest save duration */
+static timeout_t save_last_snapshot;    /* time spent creating the snapshot for the last save */
+static unsigned int save_count;         /* number of saves */
+static unsigned int save_failures;      /* number of branches that failed to save */
+
 
 /* information about a file being loaded */
 struct file_load_info
@@ -144,6 +180,59 @@ struct file_load_info
     size_t      tmplen;   /* length of temp buffer */
 };
 
+/* binary hive format
+ *
+ * A hive file contains a header followed by the branch key and all its
+ * non-volatile subkeys in depth-first order. All blocks are aligned to 8 bytes
+ * and stored in host byte order, so that the file can be used directly once mapped.
+ */
+
+#define HIVE_MAGIC    "WINEHIVE"
+#define HIVE_VERSION  1
+
+#define HIVE_KEY_FLAGS KEY_SYMLINK  /* key flags saved in the hive */
+#define HIVE_MAX_DEPTH 512          /* max. depth of the key tree, as on Windows */
+
+struct hive_header
+{
+    char           magic[8];    /* HIVE_MAGIC */
+    unsigned int   version;     /* HIVE_VERSION */
+    unsigned int   arch;        /* prefix type */
+};
+
+struct hive_key
+{
+    timeout_t      modif;       /* last modification time */
+    unsigned int   flags;       /* key flags */
+    unsigned short namelen;     /* length of key name */
+    unsigned short classlen;    /* length of class name */
+    unsigned int   nb_values;   /* number of values */
+    unsigned int   nb_subkeys;  /* number of subkeys */
+    /* followed by the name, the class, the values and the subkeys */
+};
+
+struct hive_value
+{
+    unsigned int   type;        /* value type */
+    data_size_t    len;         /* value data length in bytes */
+    unsigned short namelen;     /* length of value name */
+    unsigned short pad;
+    /* followed by the name and the data */
+};
+
+/* information about a hive being loaded */
+struct hive_load_info
+{
+    const char *ptr;      /* current position in the file mapping */
+    const char *end;      /* end of the file mapping */
+};
+
+static int binary_registry;  /* save the branches in the binary format */
+
+/* generation counters shared with the clients, bumped when the values of a key change */
+static unsigned int *generation_area;
+static int generation_fd = -1;
+
 
 static void key_dump( struct object *obj, int verbose );
 static struct object_type *key_get_type( struct object *obj );
@@ -537,11 +626,49 @@ static void check_notify( struct key *key, unsigned int change, int not_subtree
     }
 }
 
+/* map the generation counters on first use */
+static int init_generation_area(void)
+{
+    size_t size = REGISTRY_GENERATIONS * sizeof(*generation_area);
+    void *ptr;
+
+    if (generation_area) return 1;
+    if ((generation_fd = create_temp_file( size )) == -1) return 0;
+    if ((ptr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, generation_fd, 0 )) == MAP_FAILED)
+    {
+        close( generation_fd );
+        generation_fd = -1;
+        return 0;
+    }
+    generation_area = ptr;
+    return 1;
+}
+
+/* return the index of the generation counter of a key */
+static inline unsigned int get_generation_index( const struct key *key )
+{
+    unsigned long hash = (unsigned long)key / sizeof(void *);
+    return 1 + (hash * 0x9e3779b1) % (REGISTRY_GENERATIONS - 1);
+}
+
+/* invalidate the values of a key cached by the clients */
+static void bump_key_generation( const struct key *key )
+{
+    if (generation_area) generation_area[get_generation_index( key )]++;
+}
+
+/* invalidate all the values cached by the clients */
+static void bump_global_generation(void)
+{
+    if (generation_area) generation_area[0]++;
+}
+
 /* update key modification time */
 static void touch_key( struct key *key, unsigned int change )
 {
     struct key *k;
 
+    bump_key_generation( key );
     key->modif = current_time;
     make_dirty( key );
 
@@ -1012,6 +1139,7 @@ static int delete_key( struct key *key, int recurse )
     }
 
     if (debug_level > 1) dump_operation( key, NULL, "Delete" );
+    bump_key_generation( key );
     free_subkey( parent, index );
     touch_key( parent, REG_NOTIFY_CHANGE_NAME );
     return 0;
@@ -1714,12 +1842,184 @@ static void load_registry( struct key *key, obj_handle_t handle )
     }
 }
 
+/* return the next block of a hive being loaded, or NULL if past the end of the file */
+static const void *read_hive_data( struct hive_load_info *info, size_t size )
+{
+    const char *ret = info->ptr;
+
+    if (size > (size_t)(info->end - info->ptr)) return NULL;
+    size = (size + 7) & ~7;
+    if (size > (size_t)(info->end - info->ptr)) info->ptr = info->end;
+    else info->ptr += size;
+    return ret;
+}
+
+/* load the class, values and subkeys of a key from a hive */
+static int load_hive_key( struct key *key, const struct hive_key *hkey, struct hive_load_info *info,
+                          unsigned int depth )
+{
+    const struct hive_value *hvalue;
+    const struct hive_key *hsubkey;
+    struct key_value *value;
+    struct unicode_str name;
+    struct key *subkey;
+    const void *data;
+    unsigned int i;
+    int index;
+
+    if (!(data = read_hive_data( info, hkey->classlen ))) return 0;
+    if (hkey->classlen)
+    {
+        free( key->class );
+        key->classlen = 0;
+        if (!(key->class = memdup( data, hkey->classlen ))) return 0;
+        key->classlen = hkey->classlen;
+    }
+    key->flags |= hkey->flags & HIVE_KEY_FLAGS;
+    key->modif = hkey->modif;
+
+    for (i = 0; i < hkey->nb_values; i++)
+    {
+        if (!(hvalue = read_hive_data( info, sizeof(*hvalue) ))) return 0;
+        if (!(name.str = read_hive_data( info, hvalue->namelen ))) return 0;
+        name.len = hvalue->namelen;
+        if (!(data = read_hive_data( info, hvalue->len ))) return 0;
+
+        if (!(value = find_value( key, &name, &index )) &&
+            !(value = insert_value( key, &name, index )))
+            return 0;
+        free( value->data );
+        value->type = hvalue->type;
+        value->len  = 0;
+        value->data = NULL;
+        if (hvalue->len && !(value->data = memdup( data, hvalue->len ))) return 0;
+        value->len  = hvalue->len;
+    }
+
+    if (hkey->nb_subkeys && depth >= HIVE_MAX_DEPTH) return 0;
+
+    for (i = 0; i < hkey->nb_subkeys; i++)
+    {
+        if (!(hsubkey = read_hive_data( info, sizeof(*hsubkey) ))) return 0;
+        if (!(name.str = read_hive_data( info, hsubkey->namelen ))) return 0;
+        name.len = hsubkey->namelen;
+
+        if (!(subkey = find_subkey( key, &name, &index )) &&
+            !(subkey = alloc_subkey( key, &name, index, hsubkey->modif )))
+            return 0;
+        if (!load_hive_key( subkey, hsubkey, info, depth + 1 )) return 0;
+    }
+    return 1;
+}
+
+/* move the contents of a key loaded from a hive to the (empty) branch key */
+static void graft_hive_key( struct key *key, struct key *loaded )
+{
+    WCHAR *class = key->class;
+    unsigned short classlen = key->classlen;
+    struct key **subkeys = key->subkeys;
+    struct key_value *values = key->values;
+    int i, last_subkey = key->last_subkey, nb_subkeys = key->nb_subkeys;
+    int last_value = key->last_value, nb_values = key->nb_values;
+
+    key->class       = loaded->class;
+    key->classlen    = loaded->classlen;
+    key->subkeys     = loaded->subkeys;
+    key->last_subkey = loaded->last_subkey;
+    key->nb_subkeys  = loaded->nb_subkeys;
+    key->values      = loaded->values;
+    key->last_value  = loaded->last_value;
+    key->nb_values   = loaded->nb_values;
+    key->flags      |= loaded->flags & (HIVE_KEY_FLAGS | KEY_WOW64);
+    key->modif       = loaded->modif;
+    for (i = 0; i <= key->last_subkey; i++) key->subkeys[i]->parent = key;
+
+    /* the previous contents are freed along with the loaded key */
+    loaded->class       = class;
+    loaded->classlen    = classlen;
+    loaded->subkeys     = subkeys;
+    loaded->last_subkey = last_subkey;
+    loaded->nb_subkeys  = nb_subkeys;
+    loaded->values      = values;
+    loaded->last_value  = last_value;
+    loaded->nb_values   = nb_values;
+    release_object( loaded );
+}
+
+/* load a registry branch from a hive file */
+/* the branch is only modified if the whole file could be loaded */
+static int load_hive( struct key *key, const char *filename, int fd )
+{
+    const struct hive_header *header;
+    const struct hive_key *hkey;
+    struct hive_load_info info;
+    struct unicode_str name;
+    struct key *loaded;
+    struct stat st;
+    void *base;
+    int ret = 0;
+
+    if (fstat( fd, &st ) == -1) return 0;
+    if (st.st_size < sizeof(*header)) return 0;
+    if ((base = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 )) == MAP_FAILED) return 0;
+    info.ptr = base;
+    info.end = info.ptr + st.st_size;
+
+    header = read_hive_data( &info, sizeof(*header) );
+    if (memcmp( header->magic, HIVE_MAGIC, sizeof(header->magic) ) ||
+        header->version != HIVE_VERSION || header->arch > PREFIX_64BIT)
+        goto done;
+    if (header->arch != PREFIX_UNKNOWN)
+    {
+        if (prefix_type == PREFIX_UNKNOWN) prefix_type = header->arch;
+        else if (header->arch != prefix_type)
+        {
+            fprintf( stderr, "%s: Mismatched architecture\n", filename );
+            goto done;
+        }
+    }
+
+    name.str = key->name;
+    name.len = key->namelen;
+    if (!(loaded = alloc_key( &name, key->modif ))) goto done;
+
+    if (!(hkey = read_hive_data( &info, sizeof(*hkey) )) ||
+        !read_hive_data( &info, hkey->namelen ) ||  /* the branch key name is not used */
+        !load_hive_key( loaded, hkey, &info, 0 ))
+    {
+        fprintf( stderr, "%s: Malformed registry hive\n", filename );
+        release_object( loaded );
+        goto done;
+    }
+
+    graft_hive_key( key, loaded );
+    ret = 1;
+
+done:
+    munmap( base, st.st_size );
+    clear_error();
+    return ret;
+}
+
 /* load one of the initial registry files */
-static int load_init_registry_from_file( const char *filename, struct key *key )
+/* the binary hive is used if present, unless the text file has been modified since it was written */
+static int load_init_registry_from_file( const char *filename, const char *hive_name, struct key *key )
 {
+    struct stat st, hive_st;
+    int fd, from_text = 0, bad_hive = 0, ret = 0;
     FILE *f;
 
-    if ((f = fopen( filename, "r" )))
+    if ((fd = open( hive_name, O_RDONLY )) != -1)
+    {
+        if (!fstat( fd, &hive_st ) && (stat( filename, &st ) == -1 || st.st_mtime <= hive_st.st_mtime))
+        {
+            if (load_hive( key, hive_name, fd )) ret = 1;
+            else bad_hive = 1;
+        }
+        close( fd );
+    }
+
+    if (!ret && (f = fopen( filename, "r" )))
     {
         load_keys( key, filename, f, 0 );
         fclose( f );
@@ -1728,14 +2028,29 @@ static int load_init_registry_from_file( const char *filename, struct key *key )
             fprintf( stderr, "%s is not a valid registry file\n", filename );
             return 1;
         }
+        if (bad_hive) fprintf( stderr, "%s is not a valid registry file, using %s\n", hive_name, filename );
+        from_text = ret = 1;
+    }
+    else if (bad_hive)
+    {
+        /* don't overwrite it, so that it can still be recovered */
+        fprintf( stderr, "%s is not a valid registry file\n", hive_name );
+        return 1;
     }
 
+    /* convert the branch to the requested format at the next save, replacing a bad hive */
+    if (ret && (bad_hive || (from_text && binary_registry) || (!from_text && !binary_registry)))
+        make_dirty( key );
+
     assert( save_branch_count < MAX_SAVE_BRANCH_INFO );
 
     save_branch_info[save_branch_count].path = filename;
+    save_branch_info[save_branch_count].hive_path = hive_name;
+    save_branch_info[save_branch_count].binary = binary_registry;
+    save_branch_info[save_branch_count].from_text = from_text;
     save_branch_info[save_branch_count++].key = (struct key *)grab_object( key );
     make_object_static( &key->obj );
-    return (f != NULL);
+    return ret;
 }
 
 static WCHAR *format_user_registry_path( const SID *sid, struct unicode_str *path )
@@ -1811,6 +2126,8 @@ void init_registry(void)
 
     if (fchdir( config_dir_fd ) == -1) fatal_error( "chdir to config dir: %s\n", strerror( errno ));
 
+    if ((p = getenv( "WINEBINARYREGISTRY" )) && atoi( p )) binary_registry = 1;
+
     /* create the root key */
     root_key = alloc_key( &root_name, current_time );
     assert( root_key );
@@ -1821,7 +2138,7 @@ void init_registry(void)
     if (!(hklm = create_key_recursive( root_key, &HKLM_name, current_time )))
         fatal_error( "could not create Machine registry key\n" );
 
-    if (!load_init_registry_from_file( "system.reg", hklm ))
+    if (!load_init_registry_from_file( "system.reg", "system.hive", hklm ))
     {
         if ((p = getenv( "WINEARCH" )) && !strcmp( p, "win32" ))
             prefix_type = PREFIX_32BIT;
@@ -1836,7 +2153,7 @@ void init_registry(void)
     if (!(key = create_key_recursive( root_key, &HKU_name, current_time )))
         fatal_error( "could not create User\\.Default registry key\n" );
 
-    load_init_registry_from_file( "userdef.reg", key );
+    load_init_registry_from_file( "userdef.reg", "userdef.hive", key );
     release_object( key );
 
     /* load user.reg into HKEY_CURRENT_USER */
@@ -1847,7 +2164,7 @@ void init_registry(void)
         !(hkcu = create_key_recursive( root_key, &current_user_str, current_time )))
         fatal_error( "could not create HKEY_CURRENT_USER registry key\n" );
     free( current_user_path );
-    load_init_registry_from_file( "user.reg", hkcu );
+    load_init_registry_from_file( "user.reg", "user.hive", hkcu );
 
     /* set the shared flag on Software\Classes\Wow6432Node */
     if (prefix_type == PREFIX_64BIT)
@@ -1924,9 +2241,68 @@ static void save_registry( struct key *key, obj_handle_t handle )
     }
 }
 
-/* save a registry branch to a file */
-static int save_branch( struct key *key, const char *path )
+static const char hive_padding[8];
+
+/* write a block to a hive file, padded to 8 bytes */
+static void write_hive_data( const void *data, size_t size, FILE *f )
 {
+    if (!size) return;
+    fwrite( data, 1, size, f );
+    fwrite( hive_padding, 1, -size & 7, f );
+}
+
+/* save a key and all its non-volatile subkeys to a hive file */
+static void save_hive_key( const struct key *key, FILE *f )
+{
+    struct hive_key hkey;
+    int i;
+
+    hkey.modif      = key->modif;
+    hkey.flags      = key->flags & HIVE_KEY_FLAGS;
+    hkey.namelen    = key->namelen;
+    hkey.classlen   = key->classlen;
+    hkey.nb_values  = key->last_value + 1;
+    hkey.nb_subkeys = 0;
+    for (i = 0; i <= key->last_subkey; i++)
+        if (!(key->subkeys[i]->flags & KEY_VOLATILE)) hkey.nb_subkeys++;
+
+    write_hive_data( &hkey, sizeof(hkey), f );
+    write_hive_data( key->name, key->namelen, f );
+    write_hive_data( key->class, key->classlen, f );
+    for (i = 0; i <= key->last_value; i++)
+    {
+        const struct key_value *value = &key->values[i];
+        struct hive_value hvalue;
+
+        hvalue.type    = value->type;
+        hvalue.len     = value->len;
+        hvalue.namelen = value->namelen;
+        hvalue.pad     = 0;
+        write_hive_data( &hvalue, sizeof(hvalue), f );
+        write_hive_data( value->name, value->namelen, f );
+        write_hive_data( value->data, value->len, f );
+    }
+    for (i = 0; i <= key->last_subkey; i++)
+        if (!(key->subkeys[i]->flags & KEY_VOLATILE)) save_hive_key( key->subkeys[i], f );
+}
+
+/* save a registry branch to a hive file */
+static void save_hive( const struct key *key, FILE *f )
+{
+    struct hive_header header;
+
+    memcpy( header.magic, HIVE_MAGIC, sizeof(header.magic) );
+    header.version = HIVE_VERSION;
+    header.arch    = prefix_type;
+    write_hive_data( &header, sizeof(header), f );
+    save_hive_key( key, f );
+}
+
+/* save a registry branch to its file */
+static int save_branch( struct save_branch_info *info )
+{
+    struct key *key = info->key;
+    const char *path = info->binary ? info->hive_path : info->path;
     struct stat st;
     char *p, *tmp = NULL;
     int fd, count = 0, ret = 0;
@@ -1982,7 +2358,8 @@ static int save_branch( struct key *key, const char *path )
         dump_operation( key, NULL, "saving" );
     }
 
-    save_all_subkeys( key, f );
+    if (info->binary) save_hive( key, f );
+    else save_all_subkeys( key, f );
     ret = !fclose(f);
 
     if (tmp)
@@ -1994,20 +2371,145 @@ static int save_branch( struct key *key, const char *path )
 
 done:
     free( tmp );
-    if (ret) make_clean( key );
+    if (ret)
+    {
+        /* remove the file in the other format in case the branch has been converted;
+         * the text file is only replaced by a hive that was produced from it */
+        if (!info->binary) unlink( info->hive_path );
+        else if (info->from_text) unlink( info->path );
+        make_clean( key );
+    }
     return ret;
 }
 
-/* periodic saving of the registry */
-static void periodic_save( void *arg )
+/* save the given branches in the current process */
+static void save_branches( unsigned int mask )
 {
     int i;
 
     if (fchdir( config_dir_fd ) == -1) return;
-    save_timeout_user = NULL;
     for (i = 0; i < save_branch_count; i++)
-        save_branch( save_branch_info[i].key, save_branch_info[i].path );
+    {
+        if (!(mask & (1 << i))) continue;
+        if (!save_branch( &save_branch_info[i] ))
+        {
+            fprintf( stderr, "wineserver: could not save registry branch to %s",
+                     save_branch_info[i].binary ? save_branch_info[i].hive_path : save_branch_info[i].path );
+            perror( " " );
+        }
+    }
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
+}
+
+/* process the result of a background save; result is the mask of the branches that were saved */
+static void end_background_save( unsigned int result )
+{
+    int i;
+
+    for (i = 0; i < save_branch_count; i++)
+    {
+        if (!(save_mask & (1 << i)) || (result & (1 << i))) continue;
+        fprintf( stderr, "wineserver: could not save registry branch to %s\n",
+                 save_branch_info[i].binary ? save_branch_info[i].hive_path : save_branch_info[i].path );
+        make_dirty( save_branch_info[i].key );  /* try again next time */
+        save_failures++;
+    }
+    save_last_time = current_time;
+    save_last_duration = current_time - save_start;
+    if (save_last_duration > save_max_duration) save_max_duration = save_last_duration;
+    save_count++;
+    if (debug_level)
+        fprintf( stderr, "wineserver: registry saved in %u ms, snapshot took %u us\n",
+                 (unsigned int)(save_last_duration / 10000), (unsigned int)(save_last_snapshot / 10) );
+
+    release_object( save_fd );
+    save_fd = NULL;
+    save_mask = 0;
+    waitpid( save_pid, NULL, 0 );
+}
+
+static void save_poll_event( struct fd *fd, int event )
+{
+    unsigned char result = 0;
+
+    /* if the child died without reporting, nothing has been saved */
+    if (read( get_unix_fd( fd ), &result, 1 ) != 1) result = 0;
+    end_background_save( result );
+}
+
+/* wait for the current background save to finish */
+static void wait_background_save(void)
+{
+    struct pollfd pfd;
+    unsigned char result = 0;
+
+    pfd.fd = get_unix_fd( save_fd );
+    pfd.events = POLLIN;
+    while (poll( &pfd, 1, -1 ) == -1 && errno == EINTR);
+    if (read( pfd.fd, &result, 1 ) != 1) result = 0;
+    end_background_save( result );
+}
+
+/* save the modified branches from a child process, working on a copy-on-write snapshot */
+static void start_background_save(void)
+{
+    struct timeval start, end;
+    unsigned int mask = 0;
+    int i, fd[2];
+
+    for (i = 0; i < save_branch_count; i++)
+        if (save_branch_info[i].key->flags & KEY_DIRTY) mask |= 1 << i;
+    if (!mask) return;
+
+    if (pipe( fd ) == -1)
+    {
+        save_branches( mask );
+        return;
+    }
+
+    gettimeofday( &start, NULL );
+    if (!(save_pid = fork()))
+    {
+        unsigned char result = 0;
+
+        close( fd[0] );
+        if (fchdir( config_dir_fd ) != -1)
+        {
+            for (i = 0; i < save_branch_count; i++)
+                if ((mask & (1 << i)) && save_branch( &save_branch_info[i] )) result |= 1 << i;
+        }
+        write( fd[1], &result, 1 );
+        _exit(0);
+    }
+    gettimeofday( &end, NULL );
+    close( fd[1] );
+
+    if (save_pid == -1)
+    {
+        close( fd[0] );
+        save_branches( mask );
+        return;
+    }
+
+    save_mask = mask;
+    save_start = current_time;
+    save_last_snapshot = ((timeout_t)(end.tv_sec - start.tv_sec) * 1000000 + end.tv_usec - start.tv_usec) * 10;
+
+    /* further changes will mark the keys dirty again */
+    for (i = 0; i < save_branch_count; i++)
+        if (mask & (1 << i)) make_clean( save_branch_info[i].key );
+
+    if ((save_fd = create_anonymous_fd( &save_fd_ops, fd[0], &root_key->obj, 0 )))
+        set_fd_events( save_fd, POLLIN );
+    else
+        wait_background_save();
+}
+
+/* periodic saving of the registry */
+static void periodic_save( void *arg )
+{
+    save_timeout_user = NULL;
+    if (!save_fd) start_background_save();  /* otherwise the previous save is still running */
     set_periodic_save_timer();
 }
 
@@ -2020,20 +2522,22 @@ static void set_periodic_save_timer(void)
 
 /* save the modified registry branches to disk */
 void flush_registry(void)
+{
+    if (save_fd) wait_background_save();
+    save_branches( ~0u );
+}
+
+/* convert the registry branches to the binary or text format */
+void convert_registry( int binary )
 {
     int i;
 
-    if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
-        if (!save_branch( save_branch_info[i].key, save_branch_info[i].path ))
-        {
-            fprintf( stderr, "wineserver: could not save registry branch to %s",
-                     save_branch_info[i].path );
-            perror( " " );
-        }
+        save_branch_info[i].binary = binary;
+        make_dirty( save_branch_info[i].key );
     }
-    if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
+    flush_registry();
 }
 
 /* determine if the thread is wow64 (32-bit client running on 64-bit prefix) */
@@ -2172,10 +2676,28 @@ DECL_HANDLER(get_key_value)
     if ((key = get_hkey_obj( req->hkey, KEY_QUERY_VALUE )))
     {
         get_value( key, &name, &reply->type, &reply->total );
+        if (generation_area)
+        {
+            reply->gen_index  = get_generation_index( key );
+            reply->generation = generation_area[reply->gen_index];
+            reply->global_gen = generation_area[0];
+        }
         release_object( key );
     }
 }
 
+/* retrieve the registry generation counters */
+DECL_HANDLER(get_registry_generations)
+{
+    if (!init_generation_area())
+    {
+        set_error( STATUS_NOT_SUPPORTED );
+        return;
+    }
+    reply->size = REGISTRY_GENERATIONS * sizeof(*generation_area);
+    send_client_fd( current->process, generation_fd, 0 );
+}
+
 /* enumerate the value of a registry key */
 DECL_HANDLER(enum_key_value)
 {
@@ -2230,6 +2752,7 @@ DECL_HANDLER(load_registry)
         if ((key = create_key( parent, &name, NULL, 0, KEY_WOW64_64KEY, 0, sd, &dummy )))
         {
             load_registry( key, req->file );
+            bump_global_generation();  /* values are loaded without touching the keys */
             release_object( key );
         }
         release_object( parent );
@@ -2316,3 +2839,14 @@ DECL_HANDLER(set_registry_notification)
         release_object( key );
     }
 }
+
+/* retrieve statistics about the saving of the registry */
+DECL_HANDLER(get_registry_save_stats)
+{
+    reply->last_save     = save_last_time;
+    reply->last_duration = save_last_duration;
+    reply->max_duration  = save_max_duration;
+    reply->last_snapshot = save_last_snapshot;
+    reply->saves         = save_count;
+    reply->failures      = save_failures;
+}
@@ -328,16 +328,123 @@ static void call_req_handler( struct thread *thread )
     current = NULL;
 }
 
+/* execute a batch of requests on behalf of the current thread */
+DECL_HANDLER(batch)
+{
+    struct thread *thread = current;
+    const union generic_request *sub;
+    union generic_request batch_req;
+    union generic_reply sub_reply;
+    const char *ptr, *end;
+    void *batch_data;
+    data_size_t size, left, total = 0;
+    char *replies;
+    int count = 0;
+
+    /* validate everything before executing anything */
+
+    ptr = get_req_data();
+    end = ptr + get_req_data_size();
+    while (ptr < end)
+    {
+        sub = (const union generic_request *)ptr;
+        left = end - ptr;
+        if (left < sizeof(*sub) ||
+            ((sub->request_header.request_size + 7) & ~7) > left - sizeof(*sub) ||
+            sub->request_header.request_size > left - sizeof(*sub) ||
+            sub->request_header.req >= REQ_NB_REQUESTS ||
+            !req_batchable[sub->request_header.req] ||
+            sub->request_header.reply_size > get_reply_max_size())
+        {
+            set_error( STATUS_INVALID_PARAMETER );
+            return;
+        }
+        total += sizeof(sub_reply) + ((sub->request_header.reply_size + 7) & ~7);
+        if (total > get_reply_max_size())
+        {
+            set_error( STATUS_BUFFER_TOO_SMALL );
+            return;
+        }
+        ptr += sizeof(*sub) + ((sub->request_header.request_size + 7) & ~7);
+    }
+    if (!total || !(replies = mem_alloc( total ))) return;
+
+    batch_req  = thread->req;
+    batch_data = thread->req_data;
+    ptr  = batch_data;
+    size = 0;
+
+    while (ptr < end)
+    {
+        sub = (const union generic_request *)ptr;
+        thread->req = *sub;
+        thread->req_data = (void *)(sub + 1);
+        thread->reply_size = 0;
+        thread->reply_data = NULL;
+        ptr += sizeof(*sub) + ((sub->request_header.request_size + 7) & ~7);
+
+        clear_error();
+        memset( &sub_reply, 0, sizeof(sub_reply) );
+        if (debug_level) trace_request();
+        req_handlers[sub->request_header.req]( &thread->req, &sub_reply );
+
+        if (!current)  /* the thread got killed */
+        {
+            thread->req = batch_req;
+            thread->req_data = batch_data;
+            free( replies );
+            return;
+        }
+        sub_reply.reply_header.error = thread->error;
+        sub_reply.reply_header.reply_size = thread->reply_size;
+        if (debug_level) trace_reply( thread->req.request_header.req, &sub_reply );
+
+        memcpy( replies + size, &sub_reply, sizeof(sub_reply) );
+        size += sizeof(sub_reply);
+        if (thread->reply_size)
+        {
+            memcpy( replies + size, thread->reply_data, thread->reply_size );
+            memset( replies + size + thread->reply_size, 0, -thread->reply_size & 7 );
+            size += (thread->reply_size + 7) & ~7;
+        }
+        free( thread->reply_data );
+        count++;
+    }
+
+    thread->req = batch_req;
+    thread->req_data = batch_data;
+    thread->reply_data = NULL;
+    clear_error();
+    reply->count = count;
+    set_reply_data_ptr( replies, size );
+}
+
 /* read a request from a thread */
 void read_request( struct thread *thread )
 {
+    /* buffer for the variable part, so that small requests can be read with a single call */
+    static char data_buffer[4096];
+    struct iovec vec[2];
     int ret;
 
     if (!thread->req_toread)  /* no pending request */
     {
-        if ((ret = read( get_unix_fd( thread->request_fd ), &thread->req,
-                         sizeof(thread->req) )) != sizeof(thread->req)) goto error;
-        if (!(thread->req_toread = thread->req.request_header.request_size))
+        vec[0].iov_base = &thread->req;
+        vec[0].iov_len  = sizeof(thread->req);
+        vec[1].iov_base = data_buffer;
+        vec[1].iov_len  = sizeof(data_buffer);
+
+        if ((ret = readv( get_unix_fd( thread->request_fd ), vec, 2 )) < (int)sizeof(thread->req))
+            goto error;
+        ret -= sizeof(thread->req);
+        thread->req_toread = thread->req.request_header.request_size;
+        if (ret > thread->req_toread)
+        {
+            fatal_protocol_error( thread, "extra data %d in request %d\n",
+                                  ret - thread->req_toread, thread->req.request_header.req );
+            return;
+        }
+        if (!thread->req_toread)
         {
             /* no data, handle request at once */
             call_req_handler( thread );
@@ -349,6 +456,14 @@ void read_request( struct thread *thread )
                                   thread->req_toread, thread->req.request_header.req );
             return;
         }
+        memcpy( thread->req_data, data_buffer, ret );
+        if (!(thread->req_toread -= ret))
+        {
+            call_req_handler( thread );
+            free( thread->req_data );
+            thread->req_data = NULL;
+            return;
+        }
     }
 
     /* read the variable sized data */
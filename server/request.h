@@ -154,6 +154,8 @@ DECL_HANDLER(create_semaphore);
 DECL_HANDLER(release_semaphore);
 DECL_HANDLER(query_semaphore);
 DECL_HANDLER(open_semaphore);
+DECL_HANDLER(get_fast_sync_area);
+DECL_HANDLER(get_fast_sync_obj);
 DECL_HANDLER(create_file);
 DECL_HANDLER(open_file_object);
 DECL_HANDLER(alloc_file_handle);
@@ -224,12 +226,14 @@ DECL_HANDLER(flush_key);
 DECL_HANDLER(enum_key);
 DECL_HANDLER(set_key_value);
 DECL_HANDLER(get_key_value);
+DECL_HANDLER(get_registry_generations);
 DECL_HANDLER(enum_key_value);
 DECL_HANDLER(delete_key_value);
 DECL_HANDLER(load_registry);
 DECL_HANDLER(unload_registry);
 DECL_HANDLER(save_registry);
 DECL_HANDLER(set_registry_notification);
+DECL_HANDLER(get_registry_save_stats);
 DECL_HANDLER(create_timer);
 DECL_HANDLER(open_timer);
 DECL_HANDLER(set_timer);
@@ -249,6 +253,8 @@ DECL_HANDLER(get_msg_queue);
 DECL_HANDLER(set_queue_fd);
 DECL_HANDLER(set_queue_mask);
 DECL_HANDLER(get_queue_status);
+DECL_HANDLER(get_queue_shared);
+DECL_HANDLER(post_local_messages);
 DECL_HANDLER(get_process_idle_event);
 DECL_HANDLER(send_message);
 DECL_HANDLER(post_quit_message);
@@ -282,6 +288,7 @@ DECL_HANDLER(get_window_parents);
 DECL_HANDLER(get_window_children);
 DECL_HANDLER(get_window_children_from_point);
 DECL_HANDLER(get_window_tree);
+DECL_HANDLER(get_window_shared_area);
 DECL_HANDLER(set_window_pos);
 DECL_HANDLER(get_window_rectangles);
 DECL_HANDLER(get_window_text);
@@ -359,6 +366,7 @@ DECL_HANDLER(set_token_default_dacl);
 DECL_HANDLER(set_security_object);
 DECL_HANDLER(get_security_object);
 DECL_HANDLER(get_system_handles);
+DECL_HANDLER(get_handle_table_stats);
 DECL_HANDLER(create_mailslot);
 DECL_HANDLER(set_mailslot_info);
 DECL_HANDLER(create_directory);
@@ -381,6 +389,7 @@ DECL_HANDLER(get_token_statistics);
 DECL_HANDLER(create_completion);
 DECL_HANDLER(open_completion);
 DECL_HANDLER(add_completion);
+DECL_HANDLER(share_completion);
 DECL_HANDLER(remove_completion);
 DECL_HANDLER(query_completion);
 DECL_HANDLER(set_completion_info);
@@ -403,6 +412,7 @@ DECL_HANDLER(process_in_job);
 DECL_HANDLER(set_job_limits);
 DECL_HANDLER(set_job_completion_port);
 DECL_HANDLER(terminate_job);
+DECL_HANDLER(batch);
 
 #ifdef WANT_REQUEST_HANDLERS
 
@@ -451,6 +461,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_release_semaphore,
     (req_handler)req_query_semaphore,
     (req_handler)req_open_semaphore,
+    (req_handler)req_get_fast_sync_area,
+    (req_handler)req_get_fast_sync_obj,
     (req_handler)req_create_file,
     (req_handler)req_open_file_object,
     (req_handler)req_alloc_file_handle,
@@ -521,12 +533,14 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_enum_key,
     (req_handler)req_set_key_value,
     (req_handler)req_get_key_value,
+    (req_handler)req_get_registry_generations,
     (req_handler)req_enum_key_value,
     (req_handler)req_delete_key_value,
     (req_handler)req_load_registry,
     (req_handler)req_unload_registry,
     (req_handler)req_save_registry,
     (req_handler)req_set_registry_notification,
+    (req_handler)req_get_registry_save_stats,
     (req_handler)req_create_timer,
     (req_handler)req_open_timer,
     (req_handler)req_set_timer,
@@ -546,6 +560,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_set_queue_fd,
     (req_handler)req_set_queue_mask,
     (req_handler)req_get_queue_status,
+    (req_handler)req_get_queue_shared,
+    (req_handler)req_post_local_messages,
     (req_handler)req_get_process_idle_event,
     (req_handler)req_send_message,
     (req_handler)req_post_quit_message,
@@ -579,6 +595,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_window_children,
     (req_handler)req_get_window_children_from_point,
     (req_handler)req_get_window_tree,
+    (req_handler)req_get_window_shared_area,
     (req_handler)req_set_window_pos,
     (req_handler)req_get_window_rectangles,
     (req_handler)req_get_window_text,
@@ -656,6 +673,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_set_security_object,
     (req_handler)req_get_security_object,
     (req_handler)req_get_system_handles,
+    (req_handler)req_get_handle_table_stats,
     (req_handler)req_create_mailslot,
     (req_handler)req_set_mailslot_info,
     (req_handler)req_create_directory,
@@ -678,6 +696,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_create_completion,
     (req_handler)req_open_completion,
     (req_handler)req_add_completion,
+    (req_handler)req_share_completion,
     (req_handler)req_remove_completion,
     (req_handler)req_query_completion,
     (req_handler)req_set_completion_info,
@@ -700,6 +719,312 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_set_job_limits,
     (req_handler)req_set_job_completion_port,
     (req_handler)req_terminate_job,
+    (req_handler)req_batch,
+};
+
+static const unsigned char req_batchable[REQ_NB_REQUESTS] =
+{
+    0,  /* new_process */
+    0,  /* exec_process */
+    0,  /* get_new_process_info */
+    0,  /* new_thread */
+    0,  /* get_startup_info */
+    0,  /* init_process_done */
+    0,  /* init_thread */
+    0,  /* terminate_process */
+    0,  /* terminate_thread */
+    0,  /* get_process_info */
+    0,  /* get_process_vm_counters */
+    0,  /* set_process_info */
+    0,  /* get_thread_info */
+    0,  /* get_thread_times */
+    0,  /* set_thread_info */
+    0,  /* get_dll_info */
+    0,  /* suspend_thread */
+    0,  /* resume_thread */
+    0,  /* load_dll */
+    0,  /* unload_dll */
+    0,  /* queue_apc */
+    0,  /* get_apc_result */
+    0,  /* close_handle */
+    0,  /* set_handle_info */
+    0,  /* dup_handle */
+    0,  /* open_process */
+    0,  /* open_thread */
+    0,  /* select */
+    0,  /* create_event */
+    0,  /* event_op */
+    1,  /* query_event */
+    0,  /* open_event */
+    0,  /* create_keyed_event */
+    0,  /* open_keyed_event */
+    0,  /* create_mutex */
+    0,  /* release_mutex */
+    0,  /* open_mutex */
+    1,  /* query_mutex */
+    0,  /* create_semaphore */
+    0,  /* release_semaphore */
+    1,  /* query_semaphore */
+    0,  /* open_semaphore */
+    0,  /* get_fast_sync_area */
+    0,  /* get_fast_sync_obj */
+    0,  /* create_file */
+    0,  /* open_file_object */
+    0,  /* alloc_file_handle */
+    0,  /* get_handle_unix_name */
+    0,  /* get_handle_fd */
+    0,  /* get_directory_cache_entry */
+    0,  /* flush */
+    0,  /* get_file_info */
+    0,  /* get_volume_info */
+    0,  /* lock_file */
+    0,  /* unlock_file */
+    0,  /* create_socket */
+    0,  /* accept_socket */
+    0,  /* accept_into_socket */
+    0,  /* set_socket_event */
+    0,  /* get_socket_event */
+    0,  /* get_socket_info */
+    0,  /* enable_socket_event */
+    0,  /* set_socket_deferred */
+    0,  /* alloc_console */
+    0,  /* free_console */
+    0,  /* get_console_renderer_events */
+    0,  /* open_console */
+    0,  /* attach_console */
+    0,  /* get_console_wait_event */
+    0,  /* get_console_mode */
+    0,  /* set_console_mode */
+    0,  /* set_console_input_info */
+    0,  /* get_console_input_info */
+    0,  /* append_console_input_history */
+    0,  /* get_console_input_history */
+    0,  /* create_console_output */
+    0,  /* set_console_output_info */
+    0,  /* get_console_output_info */
+    0,  /* write_console_input */
+    0,  /* read_console_input */
+    0,  /* write_console_output */
+    0,  /* fill_console_output */
+    0,  /* read_console_output */
+    0,  /* move_console_output */
+    0,  /* send_console_signal */
+    0,  /* read_directory_changes */
+    0,  /* read_change */
+    0,  /* create_mapping */
+    0,  /* open_mapping */
+    0,  /* get_mapping_info */
+    0,  /* map_view */
+    0,  /* unmap_view */
+    0,  /* get_mapping_committed_range */
+    0,  /* add_mapping_committed_range */
+    0,  /* is_same_mapping */
+    0,  /* create_snapshot */
+    0,  /* next_process */
+    0,  /* next_thread */
+    0,  /* wait_debug_event */
+    0,  /* queue_exception_event */
+    0,  /* get_exception_status */
+    0,  /* continue_debug_event */
+    0,  /* debug_process */
+    0,  /* debug_break */
+    0,  /* set_debugger_kill_on_exit */
+    0,  /* read_process_memory */
+    0,  /* write_process_memory */
+    0,  /* create_key */
+    0,  /* open_key */
+    0,  /* delete_key */
+    0,  /* flush_key */
+    0,  /* enum_key */
+    0,  /* set_key_value */
+    0,  /* get_key_value */
+    0,  /* get_registry_generations */
+    0,  /* enum_key_value */
+    0,  /* delete_key_value */
+    0,  /* load_registry */
+    0,  /* unload_registry */
+    0,  /* save_registry */
+    0,  /* set_registry_notification */
+    0,  /* get_registry_save_stats */
+    0,  /* create_timer */
+    0,  /* open_timer */
+    0,  /* set_timer */
+    0,  /* cancel_timer */
+    0,  /* get_timer_info */
+    0,  /* get_thread_context */
+    0,  /* set_thread_context */
+    0,  /* get_selector_entry */
+    0,  /* add_atom */
+    0,  /* delete_atom */
+    0,  /* find_atom */
+    0,  /* get_atom_information */
+    0,  /* set_atom_information */
+    0,  /* empty_atom_table */
+    0,  /* init_atom_table */
+    0,  /* get_msg_queue */
+    0,  /* set_queue_fd */
+    0,  /* set_queue_mask */
+    0,  /* get_queue_status */
+    0,  /* get_queue_shared */
+    0,  /* post_local_messages */
+    0,  /* get_process_idle_event */
+    0,  /* send_message */
+    0,  /* post_quit_message */
+    0,  /* send_hardware_message */
+    0,  /* get_message */
+    0,  /* reply_message */
+    0,  /* accept_hardware_message */
+    0,  /* get_message_reply */
+    0,  /* set_win_timer */
+    0,  /* kill_win_timer */
+    1,  /* is_window_hung */
+    0,  /* get_serial_info */
+    0,  /* set_serial_info */
+    0,  /* register_async */
+    0,  /* cancel_async */
+    0,  /* get_async_result */
+    0,  /* read */
+    0,  /* write */
+    0,  /* ioctl */
+    0,  /* set_irp_result */
+    0,  /* create_named_pipe */
+    0,  /* set_named_pipe_info */
+    0,  /* create_window */
+    0,  /* destroy_window */
+    0,  /* get_desktop_window */
+    0,  /* set_window_owner */
+    1,  /* get_window_info */
+    1,  /* set_window_info */
+    0,  /* set_parent */
+    1,  /* get_window_parents */
+    1,  /* get_window_children */
+    0,  /* get_window_children_from_point */
+    1,  /* get_window_tree */
+    0,  /* get_window_shared_area */
+    0,  /* set_window_pos */
+    1,  /* get_window_rectangles */
+    1,  /* get_window_text */
+    0,  /* set_window_text */
+    0,  /* get_windows_offset */
+    0,  /* get_visible_region */
+    0,  /* get_surface_region */
+    1,  /* get_window_region */
+    0,  /* set_window_region */
+    0,  /* get_update_region */
+    0,  /* update_window_zorder */
+    0,  /* redraw_window */
+    0,  /* set_window_property */
+    0,  /* remove_window_property */
+    1,  /* get_window_property */
+    1,  /* get_window_properties */
+    0,  /* create_winstation */
+    0,  /* open_winstation */
+    0,  /* close_winstation */
+    0,  /* get_process_winstation */
+    0,  /* set_process_winstation */
+    0,  /* enum_winstation */
+    0,  /* create_desktop */
+    0,  /* open_desktop */
+    0,  /* open_input_desktop */
+    0,  /* close_desktop */
+    0,  /* get_thread_desktop */
+    0,  /* set_thread_desktop */
+    0,  /* enum_desktop */
+    0,  /* set_user_object_info */
+    0,  /* register_hotkey */
+    0,  /* unregister_hotkey */
+    0,  /* attach_thread_input */
+    1,  /* get_thread_input */
+    0,  /* get_last_input_time */
+    1,  /* get_key_state */
+    0,  /* set_key_state */
+    0,  /* set_foreground_window */
+    0,  /* set_focus_window */
+    0,  /* set_active_window */
+    0,  /* set_capture_window */
+    0,  /* set_caret_window */
+    0,  /* set_caret_info */
+    0,  /* set_hook */
+    0,  /* remove_hook */
+    0,  /* start_hook_chain */
+    0,  /* finish_hook_chain */
+    0,  /* get_hook_info */
+    0,  /* create_class */
+    0,  /* destroy_class */
+    1,  /* set_class_info */
+    0,  /* open_clipboard */
+    0,  /* close_clipboard */
+    0,  /* empty_clipboard */
+    0,  /* set_clipboard_data */
+    0,  /* get_clipboard_data */
+    0,  /* get_clipboard_formats */
+    0,  /* enum_clipboard_formats */
+    0,  /* release_clipboard */
+    0,  /* get_clipboard_info */
+    0,  /* set_clipboard_viewer */
+    0,  /* add_clipboard_listener */
+    0,  /* remove_clipboard_listener */
+    0,  /* open_token */
+    0,  /* set_global_windows */
+    0,  /* adjust_token_privileges */
+    0,  /* get_token_privileges */
+    0,  /* check_token_privileges */
+    0,  /* duplicate_token */
+    0,  /* access_check */
+    0,  /* get_token_sid */
+    0,  /* get_token_groups */
+    0,  /* get_token_default_dacl */
+    0,  /* set_token_default_dacl */
+    0,  /* set_security_object */
+    0,  /* get_security_object */
+    0,  /* get_system_handles */
+    0,  /* get_handle_table_stats */
+    0,  /* create_mailslot */
+    0,  /* set_mailslot_info */
+    0,  /* create_directory */
+    0,  /* open_directory */
+    0,  /* get_directory_entry */
+    0,  /* create_symlink */
+    0,  /* open_symlink */
+    0,  /* query_symlink */
+    0,  /* get_object_info */
+    0,  /* get_object_type */
+    0,  /* unlink_object */
+    0,  /* get_token_impersonation_level */
+    0,  /* allocate_locally_unique_id */
+    0,  /* create_device_manager */
+    0,  /* create_device */
+    0,  /* delete_device */
+    0,  /* get_next_device_request */
+    0,  /* make_process_system */
+    0,  /* get_token_statistics */
+    0,  /* create_completion */
+    0,  /* open_completion */
+    0,  /* add_completion */
+    0,  /* share_completion */
+    0,  /* remove_completion */
+    0,  /* query_completion */
+    0,  /* set_completion_info */
+    0,  /* add_fd_completion */
+    0,  /* set_fd_completion_mode */
+    0,  /* set_fd_disp_info */
+    0,  /* set_fd_name_info */
+    0,  /* get_window_layered_info */
+    0,  /* set_window_layered_info */
+    0,  /* alloc_user_handle */
+    0,  /* free_user_handle */
+    0,  /* set_cursor */
+    0,  /* update_rawinput_devices */
+    0,  /* get_suspend_context */
+    0,  /* set_suspend_context */
+    0,  /* create_job */
+    0,  /* open_job */
+    0,  /* assign_job */
+    0,  /* process_in_job */
+    0,  /* set_job_limits */
+    0,  /* set_job_completion_port */
+    0,  /* terminate_job */
+    0,  /* batch */
 };
 
 C_ASSERT( sizeof(affinity_t) == 8 );
@@ -995,6 +1320,16 @@ C_ASSERT( FIELD_OFFSET(struct open_semaphore_request, rootdir) == 20 );
 C_ASSERT( sizeof(struct open_semaphore_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct open_semaphore_reply, handle) == 8 );
 C_ASSERT( sizeof(struct open_semaphore_reply) == 16 );
+C_ASSERT( sizeof(struct get_fast_sync_area_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_fast_sync_area_reply, size) == 8 );
+C_ASSERT( sizeof(struct get_fast_sync_area_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_fast_sync_obj_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_fast_sync_obj_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_fast_sync_obj_reply, type) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_fast_sync_obj_reply, index) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_fast_sync_obj_reply, generation) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_fast_sync_obj_reply, access) == 20 );
+C_ASSERT( sizeof(struct get_fast_sync_obj_reply) == 24 );
 C_ASSERT( FIELD_OFFSET(struct create_file_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_file_request, sharing) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_file_request, create) == 20 );
@@ -1027,7 +1362,8 @@ C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, type) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, cacheable) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, access) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, options) == 20 );
-C_ASSERT( sizeof(struct get_handle_fd_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_fd_reply, comp_flags) == 24 );
+C_ASSERT( sizeof(struct get_handle_fd_reply) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_directory_cache_entry_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_directory_cache_entry_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_directory_cache_entry_reply, entry) == 8 );
@@ -1411,7 +1747,13 @@ C_ASSERT( FIELD_OFFSET(struct get_key_value_request, hkey) == 12 );
 C_ASSERT( sizeof(struct get_key_value_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, type) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, total) == 12 );
-C_ASSERT( sizeof(struct get_key_value_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, gen_index) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, generation) == 20 );
+C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, global_gen) == 24 );
+C_ASSERT( sizeof(struct get_key_value_reply) == 32 );
+C_ASSERT( sizeof(struct get_registry_generations_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_registry_generations_reply, size) == 8 );
+C_ASSERT( sizeof(struct get_registry_generations_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct enum_key_value_request, hkey) == 12 );
 C_ASSERT( FIELD_OFFSET(struct enum_key_value_request, index) == 16 );
 C_ASSERT( FIELD_OFFSET(struct enum_key_value_request, info_class) == 20 );
@@ -1434,6 +1776,14 @@ C_ASSERT( FIELD_OFFSET(struct set_registry_notification_request, event) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_registry_notification_request, subtree) == 20 );
 C_ASSERT( FIELD_OFFSET(struct set_registry_notification_request, filter) == 24 );
 C_ASSERT( sizeof(struct set_registry_notification_request) == 32 );
+C_ASSERT( sizeof(struct get_registry_save_stats_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_registry_save_stats_reply, last_save) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_registry_save_stats_reply, last_duration) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_registry_save_stats_reply, max_duration) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_registry_save_stats_reply, last_snapshot) == 32 );
+C_ASSERT( FIELD_OFFSET(struct get_registry_save_stats_reply, saves) == 40 );
+C_ASSERT( FIELD_OFFSET(struct get_registry_save_stats_reply, failures) == 44 );
+C_ASSERT( sizeof(struct get_registry_save_stats_reply) == 48 );
 C_ASSERT( FIELD_OFFSET(struct create_timer_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_timer_request, manual) == 16 );
 C_ASSERT( sizeof(struct create_timer_request) == 24 );
@@ -1526,6 +1876,16 @@ C_ASSERT( sizeof(struct get_queue_status_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_queue_status_reply, wake_bits) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_queue_status_reply, changed_bits) == 12 );
 C_ASSERT( sizeof(struct get_queue_status_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_queue_shared_request, map) == 12 );
+C_ASSERT( sizeof(struct get_queue_shared_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_queue_shared_reply, handle) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_queue_shared_reply, size) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_queue_shared_reply, index) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_queue_shared_reply, x) == 20 );
+C_ASSERT( FIELD_OFFSET(struct get_queue_shared_reply, y) == 24 );
+C_ASSERT( sizeof(struct get_queue_shared_reply) == 32 );
+C_ASSERT( FIELD_OFFSET(struct post_local_messages_request, changed_bits) == 12 );
+C_ASSERT( sizeof(struct post_local_messages_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_process_idle_event_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_process_idle_event_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_process_idle_event_reply, event) == 8 );
@@ -1751,6 +2111,10 @@ C_ASSERT( FIELD_OFFSET(struct get_window_tree_reply, last_sibling) == 28 );
 C_ASSERT( FIELD_OFFSET(struct get_window_tree_reply, first_child) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_window_tree_reply, last_child) == 36 );
 C_ASSERT( sizeof(struct get_window_tree_reply) == 40 );
+C_ASSERT( sizeof(struct get_window_shared_area_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_window_shared_area_reply, handle) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_window_shared_area_reply, size) == 12 );
+C_ASSERT( sizeof(struct get_window_shared_area_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_window_pos_request, swp_flags) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_window_pos_request, paint_flags) == 14 );
 C_ASSERT( FIELD_OFFSET(struct set_window_pos_request, handle) == 16 );
@@ -2195,6 +2559,15 @@ C_ASSERT( sizeof(struct get_security_object_reply) == 16 );
 C_ASSERT( sizeof(struct get_system_handles_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_system_handles_reply, count) == 8 );
 C_ASSERT( sizeof(struct get_system_handles_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_table_stats_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_handle_table_stats_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_table_stats_reply, count) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_table_stats_reply, capacity) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_table_stats_reply, blocks) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_table_stats_reply, last) == 20 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_table_stats_reply, lookups) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_handle_table_stats_reply, misses) == 32 );
+C_ASSERT( sizeof(struct get_handle_table_stats_reply) == 40 );
 C_ASSERT( FIELD_OFFSET(struct create_mailslot_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_mailslot_request, read_timeout) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_mailslot_request, max_msgsize) == 24 );
@@ -2297,6 +2670,7 @@ C_ASSERT( FIELD_OFFSET(struct get_token_statistics_reply, privilege_count) == 36
 C_ASSERT( sizeof(struct get_token_statistics_reply) == 40 );
 C_ASSERT( FIELD_OFFSET(struct create_completion_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_completion_request, concurrent) == 16 );
+C_ASSERT( FIELD_OFFSET(struct create_completion_request, local) == 20 );
 C_ASSERT( sizeof(struct create_completion_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct create_completion_reply, handle) == 8 );
 C_ASSERT( sizeof(struct create_completion_reply) == 16 );
@@ -2312,6 +2686,8 @@ C_ASSERT( FIELD_OFFSET(struct add_completion_request, cvalue) == 24 );
 C_ASSERT( FIELD_OFFSET(struct add_completion_request, information) == 32 );
 C_ASSERT( FIELD_OFFSET(struct add_completion_request, status) == 40 );
 C_ASSERT( sizeof(struct add_completion_request) == 48 );
+C_ASSERT( FIELD_OFFSET(struct share_completion_request, handle) == 12 );
+C_ASSERT( sizeof(struct share_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct remove_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, ckey) == 8 );
@@ -2406,6 +2782,9 @@ C_ASSERT( sizeof(struct set_job_completion_port_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct terminate_job_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct terminate_job_request, status) == 16 );
 C_ASSERT( sizeof(struct terminate_job_request) == 24 );
+C_ASSERT( sizeof(struct batch_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct batch_reply, count) == 8 );
+C_ASSERT( sizeof(struct batch_reply) == 16 );
 
 #endif  /* WANT_REQUEST_HANDLERS */
 
@@ -891,6 +891,25 @@ static void dump_varargs_rectangles( const char *prefix, data_size_t size )
     remove_data( size );
 }
 
+static void dump_varargs_posted_messages( const char *prefix, data_size_t size )
+{
+    const struct posted_message *msg = cur_data;
+    data_size_t len = size / sizeof(*msg);
+
+    fprintf( stderr,"%s{", prefix );
+    while (len > 0)
+    {
+        fprintf( stderr, "{win=%08x,msg=%08x", msg->win, msg->msg );
+        dump_uint64( ",wparam=", &msg->wparam );
+        dump_uint64( ",lparam=", &msg->lparam );
+        fprintf( stderr, ",x=%d,y=%d,time=%u,seq=%u}", msg->x, msg->y, msg->time, msg->seq );
+        msg++;
+        if (--len) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+    remove_data( size );
+}
+
 static void dump_varargs_message_data( const char *prefix, data_size_t size )
 {
     /* FIXME: dump the structured data */
@@ -1758,6 +1777,28 @@ static void dump_open_semaphore_reply( const struct open_semaphore_reply *req )
     fprintf( stderr, " handle=%04x", req->handle );
 }
 
+static void dump_get_fast_sync_area_request( const struct get_fast_sync_area_request *req )
+{
+}
+
+static void dump_get_fast_sync_area_reply( const struct get_fast_sync_area_reply *req )
+{
+    fprintf( stderr, " size=%u", req->size );
+}
+
+static void dump_get_fast_sync_obj_request( const struct get_fast_sync_obj_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_get_fast_sync_obj_reply( const struct get_fast_sync_obj_reply *req )
+{
+    fprintf( stderr, " type=%d", req->type );
+    fprintf( stderr, ", index=%08x", req->index );
+    fprintf( stderr, ", generation=%08x", req->generation );
+    fprintf( stderr, ", access=%08x", req->access );
+}
+
 static void dump_create_file_request( const struct create_file_request *req )
 {
     fprintf( stderr, " access=%08x", req->access );
@@ -1823,6 +1864,7 @@ static void dump_get_handle_fd_reply( const struct get_handle_fd_reply *req )
     fprintf( stderr, ", cacheable=%d", req->cacheable );
     fprintf( stderr, ", access=%08x", req->access );
     fprintf( stderr, ", options=%08x", req->options );
+    fprintf( stderr, ", comp_flags=%08x", req->comp_flags );
 }
 
 static void dump_get_directory_cache_entry_request( const struct get_directory_cache_entry_request *req )
@@ -2559,9 +2601,21 @@ static void dump_get_key_value_reply( const struct get_key_value_reply *req )
 {
     fprintf( stderr, " type=%d", req->type );
     fprintf( stderr, ", total=%u", req->total );
+    fprintf( stderr, ", gen_index=%08x", req->gen_index );
+    fprintf( stderr, ", generation=%08x", req->generation );
+    fprintf( stderr, ", global_gen=%08x", req->global_gen );
     dump_varargs_bytes( ", data=", cur_size );
 }
 
+static void dump_get_registry_generations_request( const struct get_registry_generations_request *req )
+{
+}
+
+static void dump_get_registry_generations_reply( const struct get_registry_generations_reply *req )
+{
+    fprintf( stderr, " size=%u", req->size );
+}
+
 static void dump_enum_key_value_request( const struct enum_key_value_request *req )
 {
     fprintf( stderr, " hkey=%04x", req->hkey );
@@ -2609,6 +2663,20 @@ static void dump_set_registry_notification_request( const struct set_registry_no
     fprintf( stderr, ", filter=%08x", req->filter );
 }
 
+static void dump_get_registry_save_stats_request( const struct get_registry_save_stats_request *req )
+{
+}
+
+static void dump_get_registry_save_stats_reply( const struct get_registry_save_stats_reply *req )
+{
+    dump_timeout( " last_save=", &req->last_save );
+    dump_timeout( ", last_duration=", &req->last_duration );
+    dump_timeout( ", max_duration=", &req->max_duration );
+    dump_timeout( ", last_snapshot=", &req->last_snapshot );
+    fprintf( stderr, ", saves=%08x", req->saves );
+    fprintf( stderr, ", failures=%08x", req->failures );
+}
+
 static void dump_create_timer_request( const struct create_timer_request *req )
 {
     fprintf( stderr, " access=%08x", req->access );
@@ -2810,6 +2878,26 @@ static void dump_get_queue_status_reply( const struct get_queue_status_reply *re
     fprintf( stderr, ", changed_bits=%08x", req->changed_bits );
 }
 
+static void dump_get_queue_shared_request( const struct get_queue_shared_request *req )
+{
+    fprintf( stderr, " map=%d", req->map );
+}
+
+static void dump_get_queue_shared_reply( const struct get_queue_shared_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", size=%u", req->size );
+    fprintf( stderr, ", index=%08x", req->index );
+    fprintf( stderr, ", x=%d", req->x );
+    fprintf( stderr, ", y=%d", req->y );
+}
+
+static void dump_post_local_messages_request( const struct post_local_messages_request *req )
+{
+    fprintf( stderr, " changed_bits=%08x", req->changed_bits );
+    dump_varargs_posted_messages( ", msgs=", cur_size );
+}
+
 static void dump_get_process_idle_event_request( const struct get_process_idle_event_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -3217,6 +3305,16 @@ static void dump_get_window_tree_reply( const struct get_window_tree_reply *req
     fprintf( stderr, ", last_child=%08x", req->last_child );
 }
 
+static void dump_get_window_shared_area_request( const struct get_window_shared_area_request *req )
+{
+}
+
+static void dump_get_window_shared_area_reply( const struct get_window_shared_area_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", size=%u", req->size );
+}
+
 static void dump_set_window_pos_request( const struct set_window_pos_request *req )
 {
     fprintf( stderr, " swp_flags=%04x", req->swp_flags );
@@ -4117,6 +4215,21 @@ static void dump_get_system_handles_reply( const struct get_system_handles_reply
     dump_varargs_handle_infos( ", data=", cur_size );
 }
 
+static void dump_get_handle_table_stats_request( const struct get_handle_table_stats_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_get_handle_table_stats_reply( const struct get_handle_table_stats_reply *req )
+{
+    fprintf( stderr, " count=%08x", req->count );
+    fprintf( stderr, ", capacity=%08x", req->capacity );
+    fprintf( stderr, ", blocks=%08x", req->blocks );
+    fprintf( stderr, ", last=%d", req->last );
+    dump_uint64( ", lookups=", &req->lookups );
+    dump_uint64( ", misses=", &req->misses );
+}
+
 static void dump_create_mailslot_request( const struct create_mailslot_request *req )
 {
     fprintf( stderr, " access=%08x", req->access );
@@ -4342,6 +4455,7 @@ static void dump_create_completion_request( const struct create_completion_reque
 {
     fprintf( stderr, " access=%08x", req->access );
     fprintf( stderr, ", concurrent=%08x", req->concurrent );
+    fprintf( stderr, ", local=%d", req->local );
     dump_varargs_object_attributes( ", objattr=", cur_size );
 }
 
@@ -4372,6 +4486,11 @@ static void dump_add_completion_request( const struct add_completion_request *re
     fprintf( stderr, ", status=%08x", req->status );
 }
 
+static void dump_share_completion_request( const struct share_completion_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_remove_completion_request( const struct remove_completion_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -4562,6 +4681,17 @@ static void dump_terminate_job_request( const struct terminate_job_request *req
     fprintf( stderr, ", status=%d", req->status );
 }
 
+static void dump_batch_request( const struct batch_request *req )
+{
+    dump_varargs_bytes( " requests=", cur_size );
+}
+
+static void dump_batch_reply( const struct batch_reply *req )
+{
+    fprintf( stderr, " count=%d", req->count );
+    dump_varargs_bytes( ", replies=", cur_size );
+}
+
 static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_new_process_request,
     (dump_func)dump_exec_process_request,
@@ -4605,6 +4735,8 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_release_semaphore_request,
     (dump_func)dump_query_semaphore_request,
     (dump_func)dump_open_semaphore_request,
+    (dump_func)dump_get_fast_sync_area_request,
+    (dump_func)dump_get_fast_sync_obj_request,
     (dump_func)dump_create_file_request,
     (dump_func)dump_open_file_object_request,
     (dump_func)dump_alloc_file_handle_request,
@@ -4675,12 +4807,14 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_enum_key_request,
     (dump_func)dump_set_key_value_request,
     (dump_func)dump_get_key_value_request,
+    (dump_func)dump_get_registry_generations_request,
     (dump_func)dump_enum_key_value_request,
     (dump_func)dump_delete_key_value_request,
     (dump_func)dump_load_registry_request,
     (dump_func)dump_unload_registry_request,
     (dump_func)dump_save_registry_request,
     (dump_func)dump_set_registry_notification_request,
+    (dump_func)dump_get_registry_save_stats_request,
     (dump_func)dump_create_timer_request,
     (dump_func)dump_open_timer_request,
     (dump_func)dump_set_timer_request,
@@ -4700,6 +4834,8 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_queue_fd_request,
     (dump_func)dump_set_queue_mask_request,
     (dump_func)dump_get_queue_status_request,
+    (dump_func)dump_get_queue_shared_request,
+    (dump_func)dump_post_local_messages_request,
     (dump_func)dump_get_process_idle_event_request,
     (dump_func)dump_send_message_request,
     (dump_func)dump_post_quit_message_request,
@@ -4733,6 +4869,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_window_children_request,
     (dump_func)dump_get_window_children_from_point_request,
     (dump_func)dump_get_window_tree_request,
+    (dump_func)dump_get_window_shared_area_request,
     (dump_func)dump_set_window_pos_request,
     (dump_func)dump_get_window_rectangles_request,
     (dump_func)dump_get_window_text_request,
@@ -4810,6 +4947,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_security_object_request,
     (dump_func)dump_get_security_object_request,
     (dump_func)dump_get_system_handles_request,
+    (dump_func)dump_get_handle_table_stats_request,
     (dump_func)dump_create_mailslot_request,
     (dump_func)dump_set_mailslot_info_request,
     (dump_func)dump_create_directory_request,
@@ -4832,6 +4970,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_create_completion_request,
     (dump_func)dump_open_completion_request,
     (dump_func)dump_add_completion_request,
+    (dump_func)dump_share_completion_request,
     (dump_func)dump_remove_completion_request,
     (dump_func)dump_query_completion_request,
     (dump_func)dump_set_completion_info_request,
@@ -4854,6 +4993,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_job_limits_request,
     (dump_func)dump_set_job_completion_port_request,
     (dump_func)dump_terminate_job_request,
+    (dump_func)dump_batch_request,
 };
 
 static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
@@ -4899,6 +5039,8 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_release_semaphore_reply,
     (dump_func)dump_query_semaphore_reply,
     (dump_func)dump_open_semaphore_reply,
+    (dump_func)dump_get_fast_sync_area_reply,
+    (dump_func)dump_get_fast_sync_obj_reply,
     (dump_func)dump_create_file_reply,
     (dump_func)dump_open_file_object_reply,
     (dump_func)dump_alloc_file_handle_reply,
@@ -4969,12 +5111,14 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_enum_key_reply,
     NULL,
     (dump_func)dump_get_key_value_reply,
+    (dump_func)dump_get_registry_generations_reply,
     (dump_func)dump_enum_key_value_reply,
     NULL,
     NULL,
     NULL,
     NULL,
     NULL,
+    (dump_func)dump_get_registry_save_stats_reply,
     (dump_func)dump_create_timer_reply,
     (dump_func)dump_open_timer_reply,
     (dump_func)dump_set_timer_reply,
@@ -4994,6 +5138,8 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_set_queue_mask_reply,
     (dump_func)dump_get_queue_status_reply,
+    (dump_func)dump_get_queue_shared_reply,
+    NULL,
     (dump_func)dump_get_process_idle_event_reply,
     NULL,
     NULL,
@@ -5027,6 +5173,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_window_children_reply,
     (dump_func)dump_get_window_children_from_point_reply,
     (dump_func)dump_get_window_tree_reply,
+    (dump_func)dump_get_window_shared_area_reply,
     (dump_func)dump_set_window_pos_reply,
     (dump_func)dump_get_window_rectangles_reply,
     (dump_func)dump_get_window_text_reply,
@@ -5104,6 +5251,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_get_security_object_reply,
     (dump_func)dump_get_system_handles_reply,
+    (dump_func)dump_get_handle_table_stats_reply,
     (dump_func)dump_create_mailslot_reply,
     (dump_func)dump_set_mailslot_info_reply,
     (dump_func)dump_create_directory_reply,
@@ -5126,6 +5274,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_create_completion_reply,
     (dump_func)dump_open_completion_reply,
     NULL,
+    NULL,
     (dump_func)dump_remove_completion_reply,
     (dump_func)dump_query_completion_reply,
     NULL,
@@ -5148,6 +5297,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     NULL,
     NULL,
+    (dump_func)dump_batch_reply,
 };
 
 static const char * const req_names[REQ_NB_REQUESTS] = {
@@ -5193,6 +5343,8 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "release_semaphore",
     "query_semaphore",
     "open_semaphore",
+    "get_fast_sync_area",
+    "get_fast_sync_obj",
     "create_file",
     "open_file_object",
     "alloc_file_handle",
@@ -5263,12 +5415,14 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "enum_key",
     "set_key_value",
     "get_key_value",
+    "get_registry_generations",
     "enum_key_value",
     "delete_key_value",
     "load_registry",
     "unload_registry",
     "save_registry",
     "set_registry_notification",
+    "get_registry_save_stats",
     "create_timer",
     "open_timer",
     "set_timer",
@@ -5288,6 +5442,8 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_queue_fd",
     "set_queue_mask",
     "get_queue_status",
+    "get_queue_shared",
+    "post_local_messages",
     "get_process_idle_event",
     "send_message",
     "post_quit_message",
@@ -5321,6 +5477,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_window_children",
     "get_window_children_from_point",
     "get_window_tree",
+    "get_window_shared_area",
     "set_window_pos",
     "get_window_rectangles",
     "get_window_text",
@@ -5398,6 +5555,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_security_object",
     "get_security_object",
     "get_system_handles",
+    "get_handle_table_stats",
     "create_mailslot",
     "set_mailslot_info",
     "create_directory",
@@ -5420,6 +5578,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "create_completion",
     "open_completion",
     "add_completion",
+    "share_completion",
     "remove_completion",
     "query_completion",
     "set_completion_info",
@@ -5442,6 +5601,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_job_limits",
     "set_job_completion_port",
     "terminate_job",
+    "batch",
 };
 
 static const struct
@@ -33,6 +33,8 @@
 #include "winternl.h"
 
 #include "object.h"
+#include "file.h"
+#include "handle.h"
 #include "request.h"
 #include "thread.h"
 #include "process.h"
@@ -54,6 +56,33 @@ enum property_type
     PROP_TYPE_ATOM    /* plain atom */
 };
 
+/* a cached visible region */
+struct visible_cache
+{
+    struct region *region;   /* visible region relative to the window, NULL if not cached */
+    unsigned int   flags;    /* DCX flags it was computed for */
+};
+
+/* flags that change the result of get_visible_region */
+#define VISIBLE_CACHE_FLAGS (DCX_PARENTCLIP | DCX_WINDOW | DCX_CLIPCHILDREN)
+
+/* grid of the children of a window, used to find the children containing a point */
+struct child_index
+{
+    unsigned int    cols;        /* number of columns, 0 if the children list is used instead */
+    unsigned int    rows;        /* number of rows */
+    rectangle_t     extents;     /* area covered by the grid (relative to parent client area) */
+    int             cell_width;  /* size of a grid cell */
+    int             cell_height;
+    unsigned int   *cells;       /* index of the first child of each cell, plus the total count */
+    struct window **children;    /* children overlapping each cell, in Z-order */
+};
+
+#define CHILD_INDEX_MIN_CHILDREN 32   /* don't bother indexing fewer children */
+#define CHILD_INDEX_MAX_SIZE     64   /* maximum number of rows and columns */
+#define CHILD_INDEX_MAX_CELLS    8    /* maximum average number of cells overlapped by a child */
+#define CHILD_INDEX_MAX_SPAN     0x1000000  /* maximum width and height of the indexed area */
+
 
 struct window
 {
@@ -74,6 +103,8 @@ struct window
     rectangle_t      client_rect;     /* client rectangle (relative to parent client area) */
     struct region   *win_region;      /* region for shaped windows (relative to window rect) */
     struct region   *update_region;   /* update region (relative to window rect) */
+    struct visible_cache vis_cache[2]; /* cached visible regions for client and window DCs */
+    struct child_index *child_index;  /* spatial index of the children, built on demand */
     unsigned int     style;           /* window style */
     unsigned int     ex_style;        /* window extended style */
     unsigned int     id;              /* window id */
@@ -123,6 +154,19 @@ static struct window *shell_listview;
 static struct window *progman_window;
 static struct window *taskman_window;
 
+/* number of visible regions currently cached */
+static unsigned int vis_cache_count;
+
+/* The state of the windows is mirrored into a memory area that is mapped
+ * read-only into the clients that ask for it, so that they can query windows
+ * of other threads without a server round trip. The area is created when the
+ * first client asks for it. Each window uses the slot of its user handle
+ * index; the sequence counter of a slot is odd while the window state is
+ * being updated. */
+static int window_shared_enabled = -1;
+static struct object *window_shared_mapping;
+static struct window_shared *window_shared_area;
+
 /* magic HWND_TOP etc. pointers */
 #define WINPTR_TOP       ((struct window *)1L)
 #define WINPTR_BOTTOM    ((struct window *)2L)
@@ -179,6 +223,74 @@ static inline void update_pixel_format_flags( struct window *win )
         win->paint_flags |= PAINT_PIXEL_FORMAT_CHILD;
 }
 
+/* get the shared slot of a window, if the shared area exists */
+static inline struct window_shared *get_window_shared( const struct window *win )
+{
+    if (!window_shared_area) return NULL;
+    return &window_shared_area[((win->handle & 0xffff) - FIRST_USER_HANDLE) >> 1];
+}
+
+/* update the shared copy of the window state */
+static void update_window_shared( struct window *win )
+{
+    struct window_shared *shared = get_window_shared( win );
+
+    if (!shared) return;
+    interlocked_xchg_add( (int *)&shared->seq, 1 );
+    shared->handle      = win->handle;
+    shared->parent      = win->parent ? win->parent->handle : 0;
+    shared->owner       = win->owner;
+    shared->pid         = win->thread ? get_process_id( win->thread->process ) : 0;
+    shared->tid         = win->thread ? get_thread_id( win->thread ) : 0;
+    shared->style       = win->style;
+    shared->ex_style    = win->ex_style;
+    shared->id          = win->id;
+    shared->dpi         = win->dpi;
+    shared->instance    = win->instance;
+    shared->user_data   = win->user_data;
+    shared->window_rect = win->window_rect;
+    shared->client_rect = win->client_rect;
+    interlocked_xchg_add( (int *)&shared->seq, 1 );
+}
+
+/* invalidate the shared copy of the state of a destroyed window */
+static void free_window_shared( struct window *win )
+{
+    struct window_shared *shared = get_window_shared( win );
+
+    if (!shared) return;
+    interlocked_xchg_add( (int *)&shared->seq, 1 );
+    shared->handle = 0;
+    interlocked_xchg_add( (int *)&shared->seq, 1 );
+}
+
+/* create the window shared area the first time a client asks for it */
+static int init_window_shared_area(void)
+{
+    unsigned int error = get_error();
+    user_handle_t handle = 0;
+    struct window *win;
+    void *ptr;
+
+    if (window_shared_enabled != -1) return window_shared_enabled;
+
+    window_shared_enabled = 0;
+    if (!(window_shared_mapping = create_shared_mapping( WINDOW_SHARED_SLOTS * sizeof(*window_shared_area), &ptr )))
+    {
+        fprintf( stderr, "wineserver: failed to create window shared area\n" );
+        set_error( error );
+        return 0;
+    }
+    make_object_static( window_shared_mapping );
+    window_shared_area = ptr;
+    window_shared_enabled = 1;
+
+    /* publish the windows that already exist */
+    while ((win = next_user_handle( &handle, USER_WINDOW ))) update_window_shared( win );
+    set_error( error );
+    return 1;
+}
+
 /* get the per-monitor DPI for a window */
 static unsigned int get_monitor_dpi( struct window *win )
 {
@@ -187,6 +299,62 @@ static unsigned int get_monitor_dpi( struct window *win )
     return win->dpi ? win->dpi : USER_DEFAULT_SCREEN_DPI;
 }
 
+/* free the cached visible regions of a window */
+static void free_visible_cache( struct window *win )
+{
+    unsigned int i;
+
+    for (i = 0; i < sizeof(win->vis_cache) / sizeof(win->vis_cache[0]); i++)
+    {
+        if (!win->vis_cache[i].region) continue;
+        free_region( win->vis_cache[i].region );
+        win->vis_cache[i].region = NULL;
+        vis_cache_count--;
+    }
+}
+
+/* free the cached visible regions of a window and all its children */
+static void free_visible_cache_tree( struct window *win )
+{
+    struct window *child;
+
+    free_visible_cache( win );
+    LIST_FOR_EACH_ENTRY( child, &win->children, struct window, entry )
+        free_visible_cache_tree( child );
+    LIST_FOR_EACH_ENTRY( child, &win->unlinked, struct window, entry )
+        free_visible_cache_tree( child );
+}
+
+/* invalidate the cached visible regions that depend on the position, Z-order, */
+/* style or region of a window; it must also be called before moving the window */
+/* in the Z-order, to cover the windows that were below it */
+static void invalidate_visible_cache( struct window *win )
+{
+    struct window *ptr;
+
+    if (!vis_cache_count) return;
+
+    free_visible_cache_tree( win );
+    /* top-level windows don't clip each other, and the desktop isn't clipped by them */
+    if (!win->parent || is_desktop_window( win->parent )) return;
+    free_visible_cache( win->parent );
+    if (!win->is_linked) return;
+    for (ptr = get_next_window( win ); ptr; ptr = get_next_window( ptr ))
+        free_visible_cache_tree( ptr );
+}
+
+/* free the spatial index of the children of a window, it will be rebuilt on demand */
+static void invalidate_child_index( struct window *win )
+{
+    struct child_index *index = win->child_index;
+
+    if (!index) return;
+    free( index->cells );
+    free( index->children );
+    free( index );
+    win->child_index = NULL;
+}
+
 /* link a window at the right place in the siblings list */
 static void link_window( struct window *win, struct window *previous )
 {
@@ -240,6 +408,9 @@ static void link_window( struct window *win, struct window *previous )
     }
 
     win->is_linked = 1;
+    invalidate_child_index( win->parent );
+    invalidate_visible_cache( win );
+    update_window_shared( win );
 }
 
 /* change the parent of a window (or unlink the window if the new parent is NULL) */
@@ -257,6 +428,9 @@ static int set_parent_window( struct window *win, struct window *parent )
         }
     }
 
+    invalidate_visible_cache( win );
+    if (win->parent) invalidate_child_index( win->parent );
+
     if (parent)
     {
         win->parent = parent;
@@ -266,6 +440,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         {
             win->dpi = parent->dpi;
             win->dpi_awareness = parent->dpi_awareness;
+            invalidate_child_index( win );
         }
 
         /* if parent belongs to a different thread and the window isn't */
@@ -282,6 +457,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         list_add_head( &win->parent->unlinked, &win->entry );
         win->is_linked = 0;
     }
+    update_window_shared( win );
     return 1;
 }
 
@@ -420,6 +596,7 @@ static void detach_window_thread( struct window *win )
     /* destroyed when the desktop ref count reaches zero */
     release_object( win->desktop );
     win->thread = NULL;
+    update_window_shared( win );
 }
 
 /* get the process owning the top window of a given desktop */
@@ -495,6 +672,8 @@ static struct window *create_window( struct window *parent, struct window *owner
     win->last_active    = win->handle;
     win->win_region     = NULL;
     win->update_region  = NULL;
+    memset( win->vis_cache, 0, sizeof(win->vis_cache) );
+    win->child_index    = NULL;
     win->style          = 0;
     win->ex_style       = 0;
     win->id             = 0;
@@ -546,6 +725,7 @@ static struct window *create_window( struct window *parent, struct window *owner
     }
 
     current->desktop_users++;
+    update_window_shared( win );
     return win;
 
 failed:
@@ -749,52 +929,184 @@ static unsigned int get_children_windows( struct window *parent, atom_t atom, th
     return count;
 }
 
-/* find child of 'parent' that contains the given point (in parent-relative coords) */
-static struct window *child_window_from_point( struct window *parent, int x, int y )
+/* build the spatial index of the children of a window */
+/* the index is left empty if the children list should be used instead */
+static struct child_index *build_child_index( struct window *parent )
 {
+    struct child_index *index;
     struct window *ptr;
+    rectangle_t *ext;
+    unsigned int i, count = 0, total = 0, size, col, row, left, top, right, bottom;
+
+    if (!(index = mem_alloc( sizeof(*index) ))) return NULL;
+    memset( index, 0, sizeof(*index) );
+    ext = &index->extents;
+
+    /* top-level windows can have different DPIs, and there are usually few of them */
+    if (is_desktop_window( parent )) return index;
 
     LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
     {
-        int x_child = x, y_child = y;
+        if (ptr->dpi != parent->dpi) return index;
+        if (is_rect_empty( &ptr->visible_rect )) continue;  /* can't contain any point */
+        if (!count++) *ext = ptr->visible_rect;
+        else
+        {
+            ext->left   = min( ext->left, ptr->visible_rect.left );
+            ext->top    = min( ext->top, ptr->visible_rect.top );
+            ext->right  = max( ext->right, ptr->visible_rect.right );
+            ext->bottom = max( ext->bottom, ptr->visible_rect.bottom );
+        }
+    }
+    if (count < CHILD_INDEX_MIN_CHILDREN) return index;
+    /* the rectangles come from the client, keep the offsets computed below in range */
+    if ((__int64)ext->right - ext->left > CHILD_INDEX_MAX_SPAN ||
+        (__int64)ext->bottom - ext->top > CHILD_INDEX_MAX_SPAN) return index;
 
-        if (!is_point_in_window( ptr, &x_child, &y_child, parent->dpi )) continue;  /* skip it */
+    /* aim for about one child per cell */
+    for (size = 1; size * size < count && size < CHILD_INDEX_MAX_SIZE; size++) ;
+    index->cols = index->rows = size;
+    index->cell_width  = (ext->right - ext->left + size - 1) / size;
+    index->cell_height = (ext->bottom - ext->top + size - 1) / size;
 
-        /* if window is minimized or disabled, return at once */
-        if (ptr->style & (WS_MINIMIZE|WS_DISABLED)) return ptr;
+    if (!(index->cells = mem_alloc( (size * size + 1) * sizeof(*index->cells) ))) goto failed;
+    memset( index->cells, 0, (size * size + 1) * sizeof(*index->cells) );
 
-        /* if point is not in client area, return at once */
-        if (!point_in_rect( &ptr->client_rect, x_child, y_child )) return ptr;
+    /* count the children overlapping each cell */
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        if (is_rect_empty( &ptr->visible_rect )) continue;
+        left   = (ptr->visible_rect.left - ext->left) / index->cell_width;
+        right  = (ptr->visible_rect.right - 1 - ext->left) / index->cell_width;
+        top    = (ptr->visible_rect.top - ext->top) / index->cell_height;
+        bottom = (ptr->visible_rect.bottom - 1 - ext->top) / index->cell_height;
+        total += (right - left + 1) * (bottom - top + 1);
+        /* large overlapping children would make the grid bigger than the list */
+        if (total > count * CHILD_INDEX_MAX_CELLS) goto failed;
+        for (row = top; row <= bottom; row++)
+            for (col = left; col <= right; col++) index->cells[row * size + col]++;
+    }
 
-        return child_window_from_point( ptr, x_child - ptr->client_rect.left,
-                                        y_child - ptr->client_rect.top );
+    /* turn the counts into end offsets, and fill the cells from the end */
+    /* in reverse Z-order so that each cell ends up sorted in Z-order */
+    for (i = 1; i <= size * size; i++) index->cells[i] += index->cells[i - 1];
+    if (!(index->children = mem_alloc( total * sizeof(*index->children) ))) goto failed;
+
+    LIST_FOR_EACH_ENTRY_REV( ptr, &parent->children, struct window, entry )
+    {
+        if (is_rect_empty( &ptr->visible_rect )) continue;
+        left   = (ptr->visible_rect.left - ext->left) / index->cell_width;
+        right  = (ptr->visible_rect.right - 1 - ext->left) / index->cell_width;
+        top    = (ptr->visible_rect.top - ext->top) / index->cell_height;
+        bottom = (ptr->visible_rect.bottom - 1 - ext->top) / index->cell_height;
+        for (row = top; row <= bottom; row++)
+            for (col = left; col <= right; col++)
+                index->children[--index->cells[row * size + col]] = ptr;
     }
+    return index;
+
+failed:
+    free( index->cells );
+    index->cells = NULL;
+    index->cols = index->rows = 0;
+    return index;
+}
+
+/* get the children of a window that may contain a point (in parent-relative coords) */
+/* returns NULL if the whole children list has to be checked instead */
+static struct window **get_children_at_point( struct window *parent, int x, int y, unsigned int *count )
+{
+    struct child_index *index = parent->child_index;
+    unsigned int cell, error;
+
+    if (!index)
+    {
+        error = get_error();  /* failing to build the index is not an error */
+        index = parent->child_index = build_child_index( parent );
+        set_error( error );
+        if (!index) return NULL;
+    }
+    if (!index->cols) return NULL;
+
+    *count = 0;
+    if (!point_in_rect( &index->extents, x, y )) return index->children;
+    cell = (y - index->extents.top) / index->cell_height * index->cols +
+           (x - index->extents.left) / index->cell_width;
+    *count = index->cells[cell + 1] - index->cells[cell];
+    return index->children + index->cells[cell];
+}
+
+static struct window *child_window_from_point( struct window *parent, int x, int y );
+
+/* find the window containing the given point in a child of 'parent', or NULL if not in the child */
+static struct window *window_from_point_in_child( struct window *child, int x, int y, unsigned int dpi )
+{
+    if (!is_point_in_window( child, &x, &y, dpi )) return NULL;
+
+    /* if window is minimized or disabled, return at once */
+    if (child->style & (WS_MINIMIZE|WS_DISABLED)) return child;
+
+    /* if point is not in client area, return at once */
+    if (!point_in_rect( &child->client_rect, x, y )) return child;
+
+    return child_window_from_point( child, x - child->client_rect.left, y - child->client_rect.top );
+}
+
+/* find child of 'parent' that contains the given point (in parent-relative coords) */
+static struct window *child_window_from_point( struct window *parent, int x, int y )
+{
+    struct window *ptr, *ret, **children;
+    unsigned int i, count;
+
+    if ((children = get_children_at_point( parent, x, y, &count )))
+    {
+        for (i = 0; i < count; i++)
+            if ((ret = window_from_point_in_child( children[i], x, y, parent->dpi ))) return ret;
+        return parent;
+    }
+
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+        if ((ret = window_from_point_in_child( ptr, x, y, parent->dpi ))) return ret;
     return parent;  /* not found any child */
 }
 
-/* find all children of 'parent' that contain the given point */
 static int get_window_children_from_point( struct window *parent, int x, int y,
-                                           struct user_handle_array *array )
+                                           struct user_handle_array *array );
+
+/* add a child of 'parent' and its children to the array if they contain the given point */
+static int add_child_windows_from_point( struct window *child, int x, int y, unsigned int dpi,
+                                         struct user_handle_array *array )
 {
-    struct window *ptr;
+    if (!is_point_in_window( child, &x, &y, dpi )) return 1;  /* skip it */
 
-    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    /* if point is in client area, and window is not minimized or disabled, check children */
+    if (!(child->style & (WS_MINIMIZE|WS_DISABLED)) && point_in_rect( &child->client_rect, x, y ))
     {
-        int x_child = x, y_child = y;
+        if (!get_window_children_from_point( child, x - child->client_rect.left,
+                                             y - child->client_rect.top, array ))
+            return 0;
+    }
 
-        if (!is_point_in_window( ptr, &x_child, &y_child, parent->dpi )) continue;  /* skip it */
+    /* now add window to the array */
+    return add_handle_to_array( array, child->handle );
+}
 
-        /* if point is in client area, and window is not minimized or disabled, check children */
-        if (!(ptr->style & (WS_MINIMIZE|WS_DISABLED)) && point_in_rect( &ptr->client_rect, x_child, y_child ))
-        {
-            if (!get_window_children_from_point( ptr, x_child - ptr->client_rect.left,
-                                                 y_child - ptr->client_rect.top, array ))
-                return 0;
-        }
+/* find all children of 'parent' that contain the given point */
+static int get_window_children_from_point( struct window *parent, int x, int y,
+                                           struct user_handle_array *array )
+{
+    struct window *ptr, **children;
+    unsigned int i, count;
 
-        /* now add window to the array */
-        if (!add_handle_to_array( array, ptr->handle )) return 0;
+    if ((children = get_children_at_point( parent, x, y, &count )))
+    {
+        for (i = 0; i < count; i++)
+            if (!add_child_windows_from_point( children[i], x, y, parent->dpi, array )) return 0;
+        return 1;
     }
+
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+        if (!add_child_windows_from_point( ptr, x, y, parent->dpi, array )) return 0;
     return 1;
 }
 
@@ -1016,7 +1328,7 @@ static inline struct window *get_top_clipping_window( struct window *win )
 
 
 /* compute the visible region of a window, in window coordinates */
-static struct region *get_visible_region( struct window *win, unsigned int flags )
+static struct region *compute_visible_region( struct window *win, unsigned int flags )
 {
     struct region *tmp = NULL, *region;
     int offset_x, offset_y;
@@ -1095,6 +1407,45 @@ error:
 }
 
 
+/* get the visible region of a window, in window coordinates, from the cache if possible */
+static struct region *get_visible_region( struct window *win, unsigned int flags )
+{
+    struct visible_cache *cache = &win->vis_cache[(flags & DCX_WINDOW) != 0];
+    struct region *region;
+    unsigned int error;
+
+    flags &= VISIBLE_CACHE_FLAGS;
+    if (cache->region && cache->flags == flags)
+    {
+        if (!(region = create_empty_region())) return NULL;
+        if (copy_region( region, cache->region )) return region;
+        free_region( region );
+        return NULL;
+    }
+
+    if (!(region = compute_visible_region( win, flags ))) return NULL;
+
+    /* failing to cache the region is not an error */
+    error = get_error();
+    if (!cache->region)
+    {
+        if (!(cache->region = create_empty_region())) goto done;
+        vis_cache_count++;
+    }
+    if (!copy_region( cache->region, region ))
+    {
+        free_region( cache->region );
+        cache->region = NULL;
+        vis_cache_count--;
+        goto done;
+    }
+    cache->flags = flags;
+done:
+    set_error( error );
+    return region;
+}
+
+
 /* clip all children with a custom pixel format out of the visible region */
 static struct region *clip_pixel_format_children( struct window *parent, struct region *parent_clip,
                                                   struct region *region, int offset_x, int offset_y )
@@ -1693,6 +2044,9 @@ static void set_window_pos( struct window *win, struct window *previous,
 
     /* set the new window info before invalidating anything */
 
+    invalidate_visible_cache( win );
+    if (win->parent && memcmp( &old_visible_rect, visible_rect, sizeof(*visible_rect) ))
+        invalidate_child_index( win->parent );
     win->window_rect  = *window_rect;
     win->visible_rect = *visible_rect;
     win->surface_rect = *surface_rect;
@@ -1708,14 +2062,20 @@ static void set_window_pos( struct window *win, struct window *previous,
         int old_size = old_client_rect.right - old_client_rect.left;
         int new_size = win->client_rect.right - win->client_rect.left;
 
+        /* all the children move together, so the grid only needs to follow them */
+        if (old_size != new_size && win->child_index)
+            offset_rect( &win->child_index->extents, new_size - old_size, 0 );
         if (old_size != new_size) LIST_FOR_EACH_ENTRY( child, &win->children, struct window, entry )
         {
             offset_rect( &child->window_rect, new_size - old_size, 0 );
             offset_rect( &child->visible_rect, new_size - old_size, 0 );
             offset_rect( &child->surface_rect, new_size - old_size, 0 );
             offset_rect( &child->client_rect, new_size - old_size, 0 );
+            update_window_shared( child );
         }
     }
+    invalidate_visible_cache( win );
+    update_window_shared( win );
 
     /* reset cursor clip rectangle when the desktop changes size */
     if (win == win->desktop->top_window) win->desktop->cursor.clip = *window_rect;
@@ -1855,6 +2215,7 @@ static void set_window_region( struct window *win, struct region *region, int re
 
     if (win->win_region) free_region( win->win_region );
     win->win_region = region;
+    invalidate_visible_cache( win );
 
     /* expose anything revealed by the change */
     if (old_vis_rgn && ((exposed_rgn = expose_window( win, &win->window_rect, old_vis_rgn ))))
@@ -1876,6 +2237,7 @@ void destroy_window( struct window *win )
     {
         struct region *vis_rgn = get_visible_region( win, DCX_WINDOW );
         win->style &= ~WS_VISIBLE;
+        invalidate_visible_cache( win );
         if (vis_rgn)
         {
             struct region *exposed_rgn = expose_window( win, &win->window_rect, vis_rgn );
@@ -1901,6 +2263,8 @@ void destroy_window( struct window *win )
     cleanup_clipboard_window( win->desktop, win->handle );
     free_user_handle( win->handle );
     destroy_properties( win );
+    invalidate_visible_cache( win );
+    if (win->parent) invalidate_child_index( win->parent );
     list_remove( &win->entry );
     if (is_desktop_window(win))
     {
@@ -1915,6 +2279,9 @@ void destroy_window( struct window *win )
     }
 
     detach_window_thread( win );
+    free_window_shared( win );
+    free_visible_cache( win );
+    invalidate_child_index( win );
     if (win->win_region) free_region( win->win_region );
     if (win->update_region) free_region( win->update_region );
     if (win->class) release_class( win->class );
@@ -1963,6 +2330,7 @@ DECL_HANDLER(create_window)
         win->dpi_awareness = req->awareness;
         win->dpi = req->dpi;
     }
+    update_window_shared( win );
 
     reply->handle    = win->handle;
     reply->parent    = win->parent ? win->parent->handle : 0;
@@ -2025,6 +2393,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shared( desktop->top_window );
         }
     }
 
@@ -2037,6 +2406,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_window_shared( desktop->msg_window );
         }
     }
 
@@ -2072,6 +2442,7 @@ DECL_HANDLER(set_window_owner)
 
     reply->prev_owner = win->owner;
     reply->full_owner = win->owner = owner ? owner->handle : 0;
+    update_window_shared( win );
 }
 
 
@@ -2143,6 +2514,8 @@ DECL_HANDLER(set_window_info)
     if (req->flags & SET_WIN_USERDATA) win->user_data = req->user_data;
     if (req->flags & SET_WIN_EXTRA) memcpy( win->extra_bytes + req->extra_offset,
                                             &req->extra_value, req->extra_size );
+    if (req->flags & (SET_WIN_STYLE | SET_WIN_EXSTYLE)) invalidate_visible_cache( win );
+    update_window_shared( win );
 
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;
@@ -2402,6 +2775,19 @@ DECL_HANDLER(get_window_rectangles)
 }
 
 
+/* get a handle to the window state shared area */
+DECL_HANDLER(get_window_shared_area)
+{
+    if (!init_window_shared_area())
+    {
+        set_error( STATUS_NOT_SUPPORTED );
+        return;
+    }
+    reply->size   = WINDOW_SHARED_SLOTS * sizeof(*window_shared_area);
+    reply->handle = alloc_handle( current->process, window_shared_mapping, SECTION_MAP_READ, 0 );
+}
+
+
 /* get the window text */
 DECL_HANDLER(get_window_text)
 {
@@ -2671,8 +3057,11 @@ DECL_HANDLER(update_window_zorder)
         /* making sure to not violate the topmost rule */
         if (!(ptr->ex_style & WS_EX_TOPMOST) || (win->ex_style & WS_EX_TOPMOST))
         {
+            invalidate_visible_cache( win );
             list_remove( &win->entry );
             list_add_before( &ptr->entry, &win->entry );
+            invalidate_child_index( win->parent );
+            invalidate_visible_cache( win );
         }
         break;
     }